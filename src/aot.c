@@ -0,0 +1,336 @@
+/*
+ * chip8-aot: CHIP-8 ROM -> C 변환기
+ *
+ * PROGRAM_START_ADDR부터 점프/호출/스킵을 따라가며 도달 가능한 명령어를 찾고,
+ * 명령어마다 C 함수 하나를 만들어 aot.h의 struct aot_program으로 내보낸다.
+ * 생성된 파일은 CHIP8_AOT로 빌드한 c_chip_8에 같이 링크된다.
+ *
+ * 사용법: chip8-aot <rom> <output.c>
+ */
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "chip8.h"
+#include "errcode.h"
+#include "opcodes.h"
+
+struct analysis {
+    uint8_t memory[MEMORY_SIZE];
+    size_t rom_size;
+    bool reached[MEMORY_SIZE];          // 도달 가능한 명령어 시작 주소
+    struct chip8_insn insns[MEMORY_SIZE];
+    unsigned indirect_jumps;            // Bnnn 개수, 대상은 따라가지 않음
+    unsigned fallback_by_op[CHIP8_OP_COUNT];
+};
+
+static bool in_rom(const struct analysis *an, const uint32_t addr) {
+    return addr >= PROGRAM_START_ADDR && addr + 1 < PROGRAM_START_ADDR + an->rom_size;
+}
+
+// 런타임(키 입력, 그리기, 난수, 메모리 쓰기 무효화)이 필요한 명령어는 인터프리터가 실행
+static bool is_compiled(const enum chip8_op op) {
+    switch (op) {
+        case CHIP8_OP_SYS:
+        case CHIP8_OP_RND:
+        case CHIP8_OP_DRW:
+        case CHIP8_OP_SKP:
+        case CHIP8_OP_SKNP:
+        case CHIP8_OP_LD_VX_K:
+        case CHIP8_OP_LD_B_VX:
+        case CHIP8_OP_LD_MEM_VX:
+        case CHIP8_OP_INVALID:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// 제어 흐름을 따라가며 도달 가능한 명령어 표시
+static void walk(struct analysis *an) {
+    static uint16_t worklist[MEMORY_SIZE * 2];
+    size_t top = 0;
+    worklist[top++] = PROGRAM_START_ADDR;
+
+    while (top > 0) {
+        const uint16_t addr = worklist[--top];
+        if (!in_rom(an, addr) || an->reached[addr]) {
+            continue;
+        }
+        an->reached[addr] = true;
+
+        struct chip8_insn *in = &an->insns[addr];
+        chip8_decode_insn(in, (uint16_t) ((an->memory[addr] << 8) | an->memory[addr + 1]));
+
+        const uint16_t next = (uint16_t) (addr + 2);
+        switch (in->op) {
+            case CHIP8_OP_JP:
+                worklist[top++] = in->nnn;
+                break;
+            case CHIP8_OP_CALL:
+                worklist[top++] = in->nnn;
+                worklist[top++] = next;
+                break;
+            case CHIP8_OP_RET:
+            case CHIP8_OP_SYS:
+            case CHIP8_OP_INVALID:
+                break;
+            case CHIP8_OP_JP_V0:
+                ++an->indirect_jumps;
+                break;
+            case CHIP8_OP_SE_VX_KK:
+            case CHIP8_OP_SNE_VX_KK:
+            case CHIP8_OP_SE_VX_VY:
+            case CHIP8_OP_SNE_VX_VY:
+            case CHIP8_OP_SKP:
+            case CHIP8_OP_SKNP:
+                worklist[top++] = next;
+                worklist[top++] = (uint16_t) (next + 2);
+                break;
+            default:
+                worklist[top++] = next;
+                break;
+        }
+
+        if (!is_compiled(in->op)) {
+            ++an->fallback_by_op[in->op];
+        }
+    }
+}
+
+// 인터프리터 핸들러와 같은 동작 (VF를 먼저 쓰는 순서까지 동일하게)
+static void emit_body(FILE *out, const struct chip8_insn *in, const uint16_t addr) {
+    const unsigned x = in->x;
+    const unsigned y = in->y;
+    const unsigned kk = in->kk;
+    const unsigned nnn = in->nnn;
+    const unsigned next = addr + 2u;
+
+    switch (in->op) {
+        case CHIP8_OP_CLS:
+            fprintf(out, "    memset(c->display, 0, sizeof(c->display));\n");
+            break;
+        case CHIP8_OP_RET:
+            fprintf(out, "    c->pc = c->stack[c->sp & 0xF];\n    --c->sp;\n");
+            return;
+        case CHIP8_OP_JP:
+            fprintf(out, "    c->pc = 0x%03X;\n", nnn);
+            return;
+        case CHIP8_OP_CALL:
+            fprintf(out, "    ++c->sp;\n    c->stack[c->sp & 0xF] = 0x%03X;\n    c->pc = 0x%03X;\n", next, nnn);
+            return;
+        case CHIP8_OP_SE_VX_KK:
+            fprintf(out, "    c->pc = (c->v[0x%X] == 0x%02X) ? 0x%03X : 0x%03X;\n", x, kk, next + 2, next);
+            return;
+        case CHIP8_OP_SNE_VX_KK:
+            fprintf(out, "    c->pc = (c->v[0x%X] != 0x%02X) ? 0x%03X : 0x%03X;\n", x, kk, next + 2, next);
+            return;
+        case CHIP8_OP_SE_VX_VY:
+            fprintf(out, "    c->pc = (c->v[0x%X] == c->v[0x%X]) ? 0x%03X : 0x%03X;\n", x, y, next + 2, next);
+            return;
+        case CHIP8_OP_SNE_VX_VY:
+            fprintf(out, "    c->pc = (c->v[0x%X] != c->v[0x%X]) ? 0x%03X : 0x%03X;\n", x, y, next + 2, next);
+            return;
+        case CHIP8_OP_JP_V0:
+            fprintf(out, "    c->pc = (uint16_t) (0x%03X + c->v[0]);\n", nnn);
+            return;
+        case CHIP8_OP_LD_VX_KK:
+            fprintf(out, "    c->v[0x%X] = 0x%02X;\n", x, kk);
+            break;
+        case CHIP8_OP_ADD_VX_KK:
+            fprintf(out, "    c->v[0x%X] = (uint8_t) (c->v[0x%X] + 0x%02X);\n", x, x, kk);
+            break;
+        case CHIP8_OP_LD_VX_VY:
+            fprintf(out, "    c->v[0x%X] = c->v[0x%X];\n", x, y);
+            break;
+        case CHIP8_OP_OR:
+            fprintf(out, "    c->v[0x%X] |= c->v[0x%X];\n", x, y);
+            break;
+        case CHIP8_OP_AND:
+            fprintf(out, "    c->v[0x%X] &= c->v[0x%X];\n", x, y);
+            break;
+        case CHIP8_OP_XOR:
+            fprintf(out, "    c->v[0x%X] ^= c->v[0x%X];\n", x, y);
+            break;
+        case CHIP8_OP_ADD_VX_VY:
+            fprintf(out, "    const uint16_t sum = c->v[0x%X] + c->v[0x%X];\n"
+                    "    c->v[0xF] = (sum > 0xFF) ? 1 : 0;\n"
+                    "    c->v[0x%X] = sum & 0xFF;\n", x, y, x);
+            break;
+        case CHIP8_OP_SUB:
+            fprintf(out, "    c->v[0xF] = (c->v[0x%X] > c->v[0x%X]);\n"
+                    "    c->v[0x%X] = c->v[0x%X] - c->v[0x%X];\n", x, y, x, x, y);
+            break;
+        case CHIP8_OP_SHR:
+            fprintf(out, "    c->v[0xF] = c->v[0x%X] & 0x1;\n"
+                    "    c->v[0x%X] = c->v[0x%X] >> 1;\n", x, x, x);
+            break;
+        case CHIP8_OP_SUBN:
+            fprintf(out, "    c->v[0xF] = (c->v[0x%X] > c->v[0x%X]);\n"
+                    "    c->v[0x%X] = c->v[0x%X] - c->v[0x%X];\n", y, x, x, y, x);
+            break;
+        case CHIP8_OP_SHL:
+            fprintf(out, "    c->v[0xF] = (c->v[0x%X] & 0x80) >> 7;\n"
+                    "    c->v[0x%X] = c->v[0x%X] << 1;\n", x, x, x);
+            break;
+        case CHIP8_OP_LD_I:
+            fprintf(out, "    c->i = 0x%03X;\n", nnn);
+            break;
+        case CHIP8_OP_LD_VX_DT:
+            fprintf(out, "    c->v[0x%X] = c->delay_timer;\n", x);
+            break;
+        case CHIP8_OP_LD_DT_VX:
+            fprintf(out, "    c->delay_timer = c->v[0x%X];\n", x);
+            break;
+        case CHIP8_OP_LD_ST_VX:
+            fprintf(out, "    c->sound_timer = c->v[0x%X];\n", x);
+            break;
+        case CHIP8_OP_ADD_I_VX:
+            fprintf(out, "    c->i += c->v[0x%X];\n", x);
+            break;
+        case CHIP8_OP_LD_F_VX:
+            fprintf(out, "    c->i = FONTSET_ADDR + (c->v[0x%X] * FONT_SIZE / 8);\n", x);
+            break;
+        case CHIP8_OP_LD_VX_MEM:
+            fprintf(out, "    for (uint8_t r = 0; r <= 0x%X; r++) {\n"
+                    "        c->v[r] = c->memory[(c->i + r) & MEMORY_ADDR_MASK];\n"
+                    "    }\n", x);
+            break;
+        default:
+            break;
+    }
+    fprintf(out, "    c->pc = 0x%03X;\n", next);
+}
+
+static void write_report(FILE *out, const char *prefix, const char *rom_name,
+                         const struct analysis *an) {
+    unsigned reachable = 0;
+    unsigned compiled = 0;
+    for (size_t addr = 0; addr < MEMORY_SIZE; ++addr) {
+        if (an->reached[addr]) {
+            ++reachable;
+            compiled += is_compiled(an->insns[addr].op);
+        }
+    }
+    const unsigned rom_insn_slots = (unsigned) (an->rom_size / 2);
+
+    fprintf(out, "%sROM: %s (%zu bytes)\n", prefix, rom_name, an->rom_size);
+    fprintf(out, "%sreachable instructions: %u (%.1f%% of ROM)\n", prefix, reachable,
+            rom_insn_slots ? 100.0 * reachable / rom_insn_slots : 0.0);
+    fprintf(out, "%scompiled: %u (%.1f%% of reachable)\n", prefix, compiled,
+            reachable ? 100.0 * compiled / reachable : 0.0);
+    fprintf(out, "%sinterpreter fallback: %u\n", prefix, reachable - compiled);
+    for (int op = 0; op < CHIP8_OP_COUNT; ++op) {
+        if (an->fallback_by_op[op]) {
+            fprintf(out, "%s  %-10s %u\n", prefix, chip8_op_name((enum chip8_op) op), an->fallback_by_op[op]);
+        }
+    }
+    fprintf(out, "%sindirect jumps (Bnnn, targets not followed): %u\n", prefix, an->indirect_jumps);
+}
+
+static void write_program(FILE *out, const char *rom_name, const struct analysis *an) {
+    fprintf(out, "/*\n * chip8-aot 생성 파일, 직접 수정하지 말 것\n *\n");
+    write_report(out, " * ", rom_name, an);
+    fprintf(out, " */\n#include <string.h>\n\n#include \"aot.h\"\n\n");
+
+    for (uint16_t addr = 0; addr < MEMORY_SIZE; ++addr) {
+        const struct chip8_insn *in = &an->insns[addr];
+        if (!an->reached[addr] || !is_compiled(in->op)) {
+            continue;
+        }
+        char text[32];
+        chip8_disasm(in, text, sizeof(text));
+        fprintf(out, "static void aot_%03X(struct chip8 *c) {\n    // %s\n", addr, text);
+        emit_body(out, in, addr);
+        fprintf(out, "}\n\n");
+    }
+
+    // 주소 0은 ROM 밖이라 항상 비어 있음, 변환된 명령어가 없어도 초기화 목록이 비지 않게 둠
+    fprintf(out, "static const aot_insn_fn aot_code[MEMORY_SIZE] = {\n    [0x000] = NULL,\n");
+    for (uint16_t addr = 0; addr < MEMORY_SIZE; ++addr) {
+        if (an->reached[addr] && is_compiled(an->insns[addr].op)) {
+            fprintf(out, "    [0x%03X] = aot_%03X,\n", addr, addr);
+        }
+    }
+    fprintf(out, "};\n\nstatic const uint16_t aot_opcodes[MEMORY_SIZE] = {\n    [0x000] = 0,\n");
+    for (uint16_t addr = 0; addr < MEMORY_SIZE; ++addr) {
+        if (an->reached[addr] && is_compiled(an->insns[addr].op)) {
+            fprintf(out, "    [0x%03X] = 0x%04X,\n", addr, an->insns[addr].opcode);
+        }
+    }
+    fprintf(out, "};\n\nstatic const uint8_t aot_rom[%zu] = {", an->rom_size ? an->rom_size : 1);
+    for (size_t k = 0; k < an->rom_size; ++k) {
+        fprintf(out, "%s0x%02X,", (k % 12 == 0) ? "\n    " : " ", an->memory[PROGRAM_START_ADDR + k]);
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "const struct aot_program chip8_aot_program = {\n"
+            "    .rom_name = \"%s\",\n"
+            "    .rom = aot_rom,\n"
+            "    .rom_size = %zu,\n"
+            "    .code = aot_code,\n"
+            "    .opcodes = aot_opcodes\n"
+            "};\n", rom_name, an->rom_size);
+}
+
+static errcode_t load_rom(const char *path, struct analysis *an) {
+    FILE *rom = fopen(path, "rb");
+    if (!rom) {
+        fprintf(stderr, "Failed to open ROM %s: %s\n", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    const size_t max_size = MEMORY_SIZE - PROGRAM_START_ADDR;
+    an->rom_size = fread(an->memory + PROGRAM_START_ADDR, 1, max_size, rom);
+    const bool too_large = fgetc(rom) != EOF;
+    fclose(rom);
+    if (too_large) {
+        fprintf(stderr, "ROM too large: %s\n", path);
+        return ERR_ROM_TOO_LARGE;
+    }
+    return ERR_NONE;
+}
+
+// 생성 파일에 넣을 ROM 이름, 경로와 따옴표/역슬래시는 뺀다
+static void rom_basename(const char *path, char *buf, const size_t size) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+    size_t n = 0;
+    for (; *name && n + 1 < size; ++name) {
+        if (*name != '"' && *name != '\\') {
+            buf[n++] = *name;
+        }
+    }
+    buf[n] = '\0';
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 3) {
+        fprintf(stderr, "Usage: %s <rom> <output.c>\n", argv[0]);
+        return ERR_INVALID_PARAMETER;
+    }
+
+    static struct analysis an;
+    const errcode_t err = load_rom(argv[1], &an);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    char rom_name[256];
+    rom_basename(argv[1], rom_name, sizeof(rom_name));
+
+    walk(&an);
+
+    FILE *out = fopen(argv[2], "w");
+    if (!out) {
+        fprintf(stderr, "Failed to open %s: %s\n", argv[2], strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    write_program(out, rom_name, &an);
+    fclose(out);
+
+    write_report(stdout, "", rom_name, &an);
+    return ERR_NONE;
+}
@@ -0,0 +1,29 @@
+#ifndef AOT_H
+#define AOT_H
+
+#include <stdint.h>
+
+#include "chip8.h"
+
+/*
+ * AOT(ahead-of-time) 변환된 ROM
+ * chip8-aot 도구가 ROM을 정적으로 따라가며 도달 가능한 명령어마다 C 함수를 하나씩 만들고,
+ * 그 함수들을 주소로 찾을 수 있는 테이블과 함께 이 구조체로 내보낸다.
+ * 테이블에 없는 주소(간접 점프 대상, 키 입력/그리기 등 런타임이 필요한 명령어)는 인터프리터가 실행한다.
+ */
+
+// 명령어 하나를 실행하고 pc를 다음 명령어로 옮김
+typedef void (*aot_insn_fn)(struct chip8 *chip);
+
+struct aot_program {
+    const char *rom_name;
+    const uint8_t *rom;          // 변환에 쓴 ROM, 로드된 ROM과 같을 때만 사용
+    uint16_t rom_size;
+    const aot_insn_fn *code;     // [MEMORY_SIZE], NULL이면 인터프리터가 실행
+    const uint16_t *opcodes;     // [MEMORY_SIZE], 변환 당시 opcode (self-modifying code 검사용)
+};
+
+// 변환된 코드가 내보내는 프로그램 (chip8-aot가 생성한 C 파일에 정의)
+extern const struct aot_program chip8_aot_program;
+
+#endif // AOT_H
@@ -0,0 +1,950 @@
+#include <stdlib.h>
+#include <string.h>
+
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(CHIP8_BATCH_SCALAR)
+#include <immintrin.h>
+#define BATCH_AVX2 1 // AVX2 커널을 같이 빌드하고 실행 시 CPU를 보고 고름
+#endif
+
+#include "batch.h"
+#include "opcodes.h"
+#include "rng.h"
+
+#define LANE_ALIGN 32  // AVX2 레지스터 하나 = uint8 32레인, 레인 배열 길이(stride)는 이 배수
+#define NO_PC 0x10000u // 다른 그룹이 없을 때의 pc (uint16 범위 밖)
+
+/* 레인 배열 연산: 마스크(0x00/0xFF) 배열이 켜진 레인만 바꿈 */
+
+enum alu8_op {
+    ALU8_SET_IMM, // dst = imm
+    ALU8_ADD_IMM, // dst += imm
+    ALU8_MOV,     // dst = src
+    ALU8_OR,
+    ALU8_AND,
+    ALU8_XOR,
+    ALU8_ADD,     // 8xy4, vf = carry
+    ALU8_SUB,     // 8xy5, vf = dst > src
+    ALU8_SHR,     // 8xy6, vf = dst & 1
+    ALU8_SUBN,    // 8xy7, vf = src > dst
+    ALU8_SHL      // 8xyE, vf = dst >> 7
+};
+
+enum reg16_op {
+    REG16_SET,    // dst = imm
+    REG16_ADD_U8, // dst += src
+    REG16_FONT    // dst = imm + src * 5
+};
+
+struct batch_kernels {
+    void (*alu8)(enum alu8_op op, uint8_t *dst, const uint8_t *src, uint8_t imm, uint8_t *vf,
+                 const uint8_t *mask, uint32_t count);
+    // out = mask & (a == b) (equal이 false면 !=), b가 NULL이면 imm과 비교, 켜진 레인 수 반환
+    uint32_t (*cond8)(uint8_t *out, const uint8_t *a, const uint8_t *b, uint8_t imm, bool equal,
+                      const uint8_t *mask, uint32_t count);
+    void (*reg16)(enum reg16_op op, uint16_t *dst, const uint8_t *src, uint16_t imm, const uint8_t *mask,
+                  uint32_t count);
+};
+
+struct chip8_batch {
+    struct chip8_config config;
+    uint32_t lanes;
+    uint32_t stride;              // lanes를 LANE_ALIGN 배수로 올린 값, 남는 레인은 항상 마스크 밖
+    uint32_t ips_remainder;
+    const struct batch_kernels *kernels;
+    struct chip8_batch_stats stats;
+    uint64_t any_code_dirty;      // 레인별 code_dirty의 OR, 여기 없는 페이지는 모든 레인이 초기 이미지의 디코드를 씀
+
+    /* 레인별 배열 (SoA), stride개씩 */
+    uint8_t *v[16];
+    uint16_t *i;
+    uint16_t *pc;
+    uint8_t *sp;
+    uint16_t *stack[16];
+    uint8_t *delay_timer;
+    uint8_t *sound_timer;
+    uint64_t *display[DISPLAY_HEIGHT];
+    uint16_t *keys_down;
+    uint16_t *keys_fresh;
+    struct rng *rng;
+    uint64_t *timer_accumulator;
+    uint64_t *code_dirty;         // 초기 이미지와 달라졌을 수 있는 페이지 (비트 n = CODE_PAGE_SIZE 단위 페이지 n)
+    uint32_t *remaining;          // chip8_batch_step() 안에서 남은 명령어 수, 0이면 그룹에 들어가지 않음
+    uint8_t *error;               // errcode_t
+    uint8_t *member;              // 실행 중인 그룹
+    uint8_t *taken;               // 분기 조건 결과
+    uint8_t (*memory)[MEMORY_SIZE];
+
+    uint8_t image[MEMORY_SIZE];   // 적재한 초기 메모리 (폰트 + ROM)
+    struct chip8_insn image_decode[MEMORY_SIZE];
+    void *arena;
+};
+
+// 실행 중인 그룹: 모든 멤버의 pc가 pc
+struct group {
+    uint16_t pc;
+    uint32_t second_pc; // 그룹 밖 레인 중 가장 작은 pc, 그룹이 여기에 닿으면 다시 스케줄
+    uint32_t budget;    // 멤버 중 가장 작은 remaining
+    uint32_t count;     // 멤버 수
+};
+
+// 그룹 명령어 실행 결과
+enum group_result {
+    GROUP_CONTINUE, // 모든 멤버가 같은 pc로 진행
+    GROUP_SPLIT,    // 멤버 pc가 갈라짐, 레인별 pc는 pc 배열에 씀
+    GROUP_WAIT_KEY, // 모든 멤버가 Fx0A에서 새 키를 기다림, 남은 명령어를 모두 그 자리에서 씀
+    GROUP_ERROR
+};
+
+/* 스칼라 커널 */
+
+static void alu8_scalar(const enum alu8_op op, uint8_t *dst, const uint8_t *src, const uint8_t imm, uint8_t *vf,
+                        const uint8_t *mask, const uint32_t count) {
+    // VF를 쓰는 명령어는 chip8_ctx와 같은 순서로: VF를 먼저 쓰고 결과는 그 뒤에 다시 읽은 값으로 (x나 y가 F일 때 차이)
+    for (uint32_t l = 0; l < count; l++) {
+        if (!mask[l]) {
+            continue;
+        }
+        switch (op) {
+            case ALU8_SET_IMM: dst[l] = imm; break;
+            case ALU8_ADD_IMM: dst[l] = (uint8_t) (dst[l] + imm); break;
+            case ALU8_MOV: dst[l] = src[l]; break;
+            case ALU8_OR: dst[l] |= src[l]; break;
+            case ALU8_AND: dst[l] &= src[l]; break;
+            case ALU8_XOR: dst[l] ^= src[l]; break;
+            case ALU8_ADD: {
+                const unsigned sum = dst[l] + src[l];
+                vf[l] = sum > 0xFF;
+                dst[l] = (uint8_t) sum;
+                break;
+            }
+            case ALU8_SUB:
+                vf[l] = dst[l] > src[l];
+                dst[l] = (uint8_t) (dst[l] - src[l]);
+                break;
+            case ALU8_SHR:
+                vf[l] = dst[l] & 0x1;
+                dst[l] = dst[l] >> 1;
+                break;
+            case ALU8_SUBN:
+                vf[l] = src[l] > dst[l];
+                dst[l] = (uint8_t) (src[l] - dst[l]);
+                break;
+            case ALU8_SHL:
+                vf[l] = dst[l] >> 7;
+                dst[l] = (uint8_t) (dst[l] << 1);
+                break;
+        }
+    }
+}
+
+static uint32_t cond8_scalar(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint8_t imm, const bool equal,
+                             const uint8_t *mask, const uint32_t count) {
+    uint32_t hits = 0;
+    for (uint32_t l = 0; l < count; l++) {
+        const bool hit = mask[l] && ((a[l] == (b ? b[l] : imm)) == equal);
+        out[l] = hit ? 0xFF : 0;
+        hits += hit;
+    }
+    return hits;
+}
+
+static void reg16_scalar(const enum reg16_op op, uint16_t *dst, const uint8_t *src, const uint16_t imm,
+                         const uint8_t *mask, const uint32_t count) {
+    for (uint32_t l = 0; l < count; l++) {
+        if (!mask[l]) {
+            continue;
+        }
+        switch (op) {
+            case REG16_SET: dst[l] = imm; break;
+            case REG16_ADD_U8: dst[l] = (uint16_t) (dst[l] + src[l]); break;
+            case REG16_FONT: dst[l] = (uint16_t) (imm + src[l] * 5); break;
+        }
+    }
+}
+
+static const struct batch_kernels scalar_kernels = {alu8_scalar, cond8_scalar, reg16_scalar};
+
+#ifdef BATCH_AVX2
+
+/* AVX2 커널: 32레인씩, count는 LANE_ALIGN 배수 */
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i load256(const void *p) {
+    return _mm256_load_si256((const __m256i *) p);
+}
+
+AVX2 static inline void store256(void *p, const __m256i value) {
+    _mm256_store_si256((__m256i *) p, value);
+}
+
+// 부호 없는 a > b
+AVX2 static inline __m256i gt_epu8(const __m256i a, const __m256i b) {
+    const __m256i le = _mm256_cmpeq_epi8(_mm256_max_epu8(a, b), b);
+    return _mm256_xor_si256(le, _mm256_set1_epi8(-1));
+}
+
+AVX2 static void alu8_avx2(const enum alu8_op op, uint8_t *dst, const uint8_t *src, const uint8_t imm, uint8_t *vf,
+                           const uint8_t *mask, const uint32_t count) {
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i k = _mm256_set1_epi8((char) imm);
+    for (uint32_t l = 0; l < count; l += LANE_ALIGN) {
+        const __m256i m = load256(mask + l);
+        if (_mm256_testz_si256(m, m)) {
+            continue;
+        }
+        const __m256i a = load256(dst + l);
+        __m256i result;
+        switch (op) {
+            case ALU8_SET_IMM: result = k; break;
+            case ALU8_ADD_IMM: result = _mm256_add_epi8(a, k); break;
+            case ALU8_MOV: result = load256(src + l); break;
+            case ALU8_OR: result = _mm256_or_si256(a, load256(src + l)); break;
+            case ALU8_AND: result = _mm256_and_si256(a, load256(src + l)); break;
+            case ALU8_XOR: result = _mm256_xor_si256(a, load256(src + l)); break;
+            case ALU8_ADD: {
+                // 합은 VF를 쓰기 전 값으로 계산
+                result = _mm256_add_epi8(a, load256(src + l));
+                const __m256i carry = gt_epu8(a, result);
+                store256(vf + l, _mm256_blendv_epi8(load256(vf + l), _mm256_and_si256(carry, one), m));
+                break;
+            }
+            default: {
+                // VF를 먼저 쓰고 dst/src를 다시 읽음
+                const __m256i b = load256(src + l);
+                __m256i flag;
+                switch (op) {
+                    case ALU8_SUB: flag = _mm256_and_si256(gt_epu8(a, b), one); break;
+                    case ALU8_SUBN: flag = _mm256_and_si256(gt_epu8(b, a), one); break;
+                    case ALU8_SHR: flag = _mm256_and_si256(a, one); break;
+                    default: flag = _mm256_and_si256(_mm256_srli_epi16(a, 7), one); break; // SHL
+                }
+                store256(vf + l, _mm256_blendv_epi8(load256(vf + l), flag, m));
+                const __m256i a2 = load256(dst + l);
+                const __m256i b2 = load256(src + l);
+                switch (op) {
+                    case ALU8_SUB: result = _mm256_sub_epi8(a2, b2); break;
+                    case ALU8_SUBN: result = _mm256_sub_epi8(b2, a2); break;
+                    case ALU8_SHR: result = _mm256_and_si256(_mm256_srli_epi16(a2, 1), _mm256_set1_epi8(0x7F)); break;
+                    default: result = _mm256_add_epi8(a2, a2); break; // SHL
+                }
+                store256(dst + l, _mm256_blendv_epi8(a2, result, m));
+                continue;
+            }
+        }
+        // ADD는 VF를 쓴 뒤라 dst를 다시 읽어서 섞음 (dst가 VF일 수 있음)
+        store256(dst + l, _mm256_blendv_epi8(load256(dst + l), result, m));
+    }
+}
+
+AVX2 static uint32_t cond8_avx2(uint8_t *out, const uint8_t *a, const uint8_t *b, const uint8_t imm, const bool equal,
+                                const uint8_t *mask, const uint32_t count) {
+    const __m256i k = _mm256_set1_epi8((char) imm);
+    const __m256i flip = equal ? _mm256_setzero_si256() : _mm256_set1_epi8(-1);
+    uint32_t hits = 0;
+    for (uint32_t l = 0; l < count; l += LANE_ALIGN) {
+        const __m256i rhs = b ? load256(b + l) : k;
+        const __m256i hit = _mm256_and_si256(_mm256_xor_si256(_mm256_cmpeq_epi8(load256(a + l), rhs), flip),
+                                             load256(mask + l));
+        store256(out + l, hit);
+        hits += (uint32_t) __builtin_popcount((unsigned) _mm256_movemask_epi8(hit));
+    }
+    return hits;
+}
+
+AVX2 static void reg16_avx2(const enum reg16_op op, uint16_t *dst, const uint8_t *src, const uint16_t imm,
+                            const uint8_t *mask, const uint32_t count) {
+    const __m256i k = _mm256_set1_epi16((short) imm);
+    const __m256i five = _mm256_set1_epi16(5);
+    for (uint32_t l = 0; l < count; l += 16) {
+        // 바이트 마스크 16개를 16비트로 부호 확장 (0xFF -> 0xFFFF)
+        const __m256i m = _mm256_cvtepi8_epi16(_mm_load_si128((const __m128i *) (mask + l)));
+        if (_mm256_testz_si256(m, m)) {
+            continue;
+        }
+        const __m256i a = load256(dst + l);
+        __m256i result;
+        switch (op) {
+            case REG16_SET:
+                result = k;
+                break;
+            case REG16_ADD_U8:
+                result = _mm256_add_epi16(a, _mm256_cvtepu8_epi16(_mm_load_si128((const __m128i *) (src + l))));
+                break;
+            default: // REG16_FONT
+                result = _mm256_add_epi16(k, _mm256_mullo_epi16(
+                                                 _mm256_cvtepu8_epi16(_mm_load_si128((const __m128i *) (src + l))), five));
+                break;
+        }
+        store256(dst + l, _mm256_blendv_epi8(a, result, m));
+    }
+}
+
+static const struct batch_kernels avx2_kernels = {alu8_avx2, cond8_avx2, reg16_avx2};
+
+#endif // BATCH_AVX2
+
+static const struct batch_kernels *select_kernels(void) {
+#ifdef BATCH_AVX2
+    if (__builtin_cpu_supports("avx2")) {
+        return &avx2_kernels;
+    }
+#endif
+    return &scalar_kernels;
+}
+
+/* 생성/적재 */
+
+// 배열을 arena에서 차례로 잘라냄, base가 NULL이면 크기만 셈
+static void *carve(uint8_t *base, size_t *offset, const size_t size) {
+    void *p = base ? base + *offset : NULL;
+    *offset += (size + LANE_ALIGN - 1) & ~(size_t) (LANE_ALIGN - 1);
+    return p;
+}
+
+static size_t layout(struct chip8_batch *batch, uint8_t *base) {
+    const size_t s = batch->stride;
+    size_t offset = 0;
+    for (int r = 0; r < 16; r++) {
+        batch->v[r] = carve(base, &offset, s);
+        batch->stack[r] = carve(base, &offset, s * sizeof(uint16_t));
+    }
+    for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+        batch->display[row] = carve(base, &offset, s * sizeof(uint64_t));
+    }
+    batch->i = carve(base, &offset, s * sizeof(uint16_t));
+    batch->pc = carve(base, &offset, s * sizeof(uint16_t));
+    batch->sp = carve(base, &offset, s);
+    batch->delay_timer = carve(base, &offset, s);
+    batch->sound_timer = carve(base, &offset, s);
+    batch->keys_down = carve(base, &offset, s * sizeof(uint16_t));
+    batch->keys_fresh = carve(base, &offset, s * sizeof(uint16_t));
+    batch->rng = carve(base, &offset, s * sizeof(struct rng));
+    batch->timer_accumulator = carve(base, &offset, s * sizeof(uint64_t));
+    batch->code_dirty = carve(base, &offset, s * sizeof(uint64_t));
+    batch->remaining = carve(base, &offset, s * sizeof(uint32_t));
+    batch->error = carve(base, &offset, s);
+    batch->member = carve(base, &offset, s);
+    batch->taken = carve(base, &offset, s);
+    batch->memory = carve(base, &offset, s * MEMORY_SIZE);
+    return offset;
+}
+
+struct chip8_batch *chip8_batch_create(const struct chip8_config *config, const uint32_t lanes) {
+    if (lanes == 0 || lanes > CHIP8_BATCH_MAX_LANES) {
+        return NULL;
+    }
+    struct chip8_batch *batch = calloc(1, sizeof(*batch));
+    if (!batch) {
+        return NULL;
+    }
+    batch->config = *config;
+    batch->lanes = lanes;
+    batch->stride = (lanes + LANE_ALIGN - 1) & ~(uint32_t) (LANE_ALIGN - 1);
+    batch->kernels = select_kernels();
+
+    const size_t size = layout(batch, NULL);
+    if (posix_memalign(&batch->arena, LANE_ALIGN, size) != 0) {
+        free(batch);
+        return NULL;
+    }
+    memset(batch->arena, 0, size);
+    layout(batch, batch->arena);
+
+    static const uint8_t no_rom[1];
+    if (chip8_batch_load_rom_mem(batch, no_rom, 0, NULL) != ERR_NONE) {
+        chip8_batch_destroy(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+void chip8_batch_destroy(struct chip8_batch *batch) {
+    if (batch) {
+        free(batch->arena);
+        free(batch);
+    }
+}
+
+uint32_t chip8_batch_lanes(const struct chip8_batch *batch) {
+    return batch->lanes;
+}
+
+errcode_t chip8_batch_load_rom_mem(struct chip8_batch *batch, const uint8_t *rom, const size_t size,
+                                   const uint64_t *seeds) {
+    // 초기 메모리(폰트 배치, 크기 검사)는 chip8_ctx의 적재 규칙을 그대로 씀
+    struct chip8_ctx *ctx = chip8_create(&batch->config);
+    if (!ctx) {
+        return ERR_UNKNOWN;
+    }
+    const errcode_t err = chip8_load_rom_mem(ctx, rom, size);
+    if (err == ERR_NONE) {
+        memcpy(batch->image, chip8_machine_const(ctx)->memory, MEMORY_SIZE);
+    }
+    chip8_destroy(ctx);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    const size_t s = batch->stride;
+    for (int r = 0; r < 16; r++) {
+        memset(batch->v[r], 0, s);
+        memset(batch->stack[r], 0, s * sizeof(uint16_t));
+    }
+    for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+        memset(batch->display[row], 0, s * sizeof(uint64_t));
+    }
+    memset(batch->i, 0, s * sizeof(uint16_t));
+    memset(batch->sp, 0, s);
+    memset(batch->delay_timer, 0, s);
+    memset(batch->sound_timer, 0, s);
+    memset(batch->keys_down, 0, s * sizeof(uint16_t));
+    memset(batch->keys_fresh, 0, s * sizeof(uint16_t));
+    memset(batch->timer_accumulator, 0, s * sizeof(uint64_t));
+    memset(batch->code_dirty, 0, s * sizeof(uint64_t));
+    memset(batch->error, 0, s);
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        batch->pc[l] = PROGRAM_START_ADDR;
+        rng_seed(&batch->rng[l], seeds ? seeds[l] : batch->config.seed);
+        memcpy(batch->memory[l], batch->image, MEMORY_SIZE);
+    }
+    memset(batch->image_decode, 0, sizeof(batch->image_decode));
+    batch->any_code_dirty = 0;
+    batch->ips_remainder = 0;
+    return ERR_NONE;
+}
+
+/* 레인별 처리 */
+
+static inline void lane_mem_write(struct chip8_batch *batch, const uint32_t lane, const uint16_t addr,
+                                  const uint8_t value) {
+    const uint16_t a = addr & MEMORY_ADDR_MASK;
+    batch->memory[lane][a] = value;
+    // chip8_ctx의 mem_write()와 같이 바로 앞 주소에서 시작하는 명령어의 페이지도 표시
+    const uint64_t pages = (1ULL << (a >> CODE_PAGE_SHIFT))
+            | (1ULL << (((a - 1) & MEMORY_ADDR_MASK) >> CODE_PAGE_SHIFT));
+    batch->code_dirty[lane] |= pages;
+    batch->any_code_dirty |= pages;
+}
+
+static inline uint16_t lane_opcode(const struct chip8_batch *batch, const uint32_t lane, const uint16_t addr) {
+    const uint8_t *memory = batch->memory[lane];
+    return (uint16_t) ((memory[addr] << 8) | memory[(addr + 1) & MEMORY_ADDR_MASK]);
+}
+
+static inline const struct chip8_insn *image_insn(struct chip8_batch *batch, const uint16_t addr) {
+    struct chip8_insn *in = &batch->image_decode[addr];
+    if (in->op == CHIP8_OP_UNDECODED) {
+        chip8_decode_insn(in, (uint16_t) ((batch->image[addr] << 8) | batch->image[(addr + 1) & MEMORY_ADDR_MASK]));
+    }
+    return in;
+}
+
+// 멤버 하나를 그룹에서 빼서 현재 pc에 남김 (이번 명령어는 실행하지 않음)
+static void leave_group(struct chip8_batch *batch, struct group *group, const uint32_t lane, const uint32_t steps) {
+    batch->member[lane] = 0;
+    batch->pc[lane] = group->pc;
+    batch->remaining[lane] -= steps;
+    --group->count;
+    if (group->pc < group->second_pc) {
+        group->second_pc = group->pc;
+    }
+}
+
+/*
+ * 그룹이 실행할 명령어
+ * 메모리를 쓴 적이 없는 페이지면 초기 이미지의 디코드를 그대로 쓰고,
+ * 쓴 적이 있으면 첫 멤버의 opcode와 다른 멤버는 그룹에서 뺀다. (다음 스케줄에서 따로 실행)
+ */
+static const struct chip8_insn *group_insn(struct chip8_batch *batch, struct group *group, const uint32_t steps,
+                                           struct chip8_insn *scratch) {
+    const uint16_t addr = group->pc & MEMORY_ADDR_MASK;
+    const uint64_t page = 1ULL << (addr >> CODE_PAGE_SHIFT);
+    const struct chip8_insn *image = image_insn(batch, addr);
+    if (!(batch->any_code_dirty & page)) {
+        return image;
+    }
+
+    int32_t leader = -1;
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (!batch->member[l]) {
+            continue;
+        }
+        const uint16_t opcode = batch->code_dirty[l] & page ? lane_opcode(batch, l, addr) : image->opcode;
+        if (leader < 0) {
+            leader = opcode;
+        } else if (opcode != leader) {
+            leave_group(batch, group, l, steps);
+        }
+    }
+    if (leader == image->opcode) {
+        return image;
+    }
+    chip8_decode_insn(scratch, (uint16_t) leader);
+    return scratch;
+}
+
+// 분기 결과(taken)에 따라 멤버 pc를 next 또는 next + 2로
+static enum group_result split_skip(struct chip8_batch *batch, const struct group *group, const uint32_t hits,
+                                    uint16_t *next) {
+    if (hits == group->count) {
+        *next += 2;
+        return GROUP_CONTINUE;
+    }
+    if (hits == 0) {
+        return GROUP_CONTINUE;
+    }
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (batch->member[l]) {
+            batch->pc[l] = (uint16_t) (*next + (batch->taken[l] ? 2 : 0));
+        }
+    }
+    return GROUP_SPLIT;
+}
+
+// 레인별로 계산한 pc(pc 배열)가 모두 같으면 그 pc로 계속, 아니면 갈라짐
+static enum group_result join_lane_pcs(const struct chip8_batch *batch, uint16_t *next) {
+    int32_t common = -1;
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (!batch->member[l]) {
+            continue;
+        }
+        if (common < 0) {
+            common = batch->pc[l];
+        } else if (batch->pc[l] != common) {
+            return GROUP_SPLIT;
+        }
+    }
+    *next = (uint16_t) common;
+    return GROUP_CONTINUE;
+}
+
+static inline uint64_t rotate_right64(const uint64_t value, const unsigned shift) {
+    return (value >> shift) | (value << ((64 - shift) & 63));
+}
+
+static void draw_lane(struct chip8_batch *batch, const uint32_t l, const struct chip8_insn *in) {
+    const uint8_t *memory = batch->memory[l];
+    const uint8_t x = batch->v[in->x][l] % DISPLAY_WIDTH;
+    const uint8_t y = batch->v[in->y][l] % DISPLAY_HEIGHT;
+    const bool wrap = !batch->config.clip_sprites;
+    const uint16_t i = batch->i[l];
+
+    uint64_t collision = 0;
+    for (uint8_t row = 0; row < in->n; ++row) {
+        uint8_t py = y + row;
+        if (py >= DISPLAY_HEIGHT) {
+            if (!wrap) {
+                break;
+            }
+            py -= DISPLAY_HEIGHT;
+        }
+        const uint64_t sprite_row = (uint64_t) memory[(i + row) & MEMORY_ADDR_MASK] << 56;
+        const uint64_t mask = wrap ? rotate_right64(sprite_row, x) : sprite_row >> x;
+        collision |= batch->display[py][l] & mask;
+        batch->display[py][l] ^= mask;
+    }
+    batch->v[0xF][l] = collision ? 1 : 0;
+}
+
+/*
+ * 그룹 전체에 명령어 하나 실행, 동작은 libchip8.c의 핸들러와 같음
+ * next는 호출 시 pc + 2 (chip8_ctx처럼 pc를 먼저 옮긴 뒤 실행), 그룹이 계속되면 다음 pc
+ */
+static enum group_result exec_group(struct chip8_batch *batch, const struct group *group,
+                                    const struct chip8_insn *in, uint16_t *next) {
+    const struct batch_kernels *k = batch->kernels;
+    const uint32_t s = batch->stride;
+    const uint8_t *m = batch->member;
+    uint8_t *vx = batch->v[in->x];
+    const uint8_t *vy = batch->v[in->y];
+    uint8_t *vf = batch->v[0xF];
+
+    switch ((enum chip8_op) in->op) {
+        case CHIP8_OP_CLS:
+            for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+                uint64_t *display = batch->display[row];
+                for (uint32_t l = 0; l < batch->lanes; l++) {
+                    display[l] = m[l] ? 0 : display[l];
+                }
+            }
+            return GROUP_CONTINUE;
+        case CHIP8_OP_RET:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    batch->pc[l] = batch->stack[batch->sp[l] & 0xF][l];
+                    --batch->sp[l];
+                }
+            }
+            return join_lane_pcs(batch, next);
+        case CHIP8_OP_SYS:
+            // chip8_ctx와 같이 정의되지 않은 opcode로 처리
+            return GROUP_ERROR;
+        case CHIP8_OP_JP:
+            *next = in->nnn;
+            return GROUP_CONTINUE;
+        case CHIP8_OP_CALL:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    ++batch->sp[l];
+                    batch->stack[batch->sp[l] & 0xF][l] = *next;
+                }
+            }
+            *next = in->nnn;
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SE_VX_KK:
+            return split_skip(batch, group, k->cond8(batch->taken, vx, NULL, in->kk, true, m, s), next);
+        case CHIP8_OP_SNE_VX_KK:
+            return split_skip(batch, group, k->cond8(batch->taken, vx, NULL, in->kk, false, m, s), next);
+        case CHIP8_OP_SE_VX_VY:
+            return split_skip(batch, group, k->cond8(batch->taken, vx, vy, 0, true, m, s), next);
+        case CHIP8_OP_SNE_VX_VY:
+            return split_skip(batch, group, k->cond8(batch->taken, vx, vy, 0, false, m, s), next);
+        case CHIP8_OP_LD_VX_KK:
+            k->alu8(ALU8_SET_IMM, vx, NULL, in->kk, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_ADD_VX_KK:
+            k->alu8(ALU8_ADD_IMM, vx, NULL, in->kk, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_VX_VY:
+            k->alu8(ALU8_MOV, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_OR:
+            k->alu8(ALU8_OR, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_AND:
+            k->alu8(ALU8_AND, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_XOR:
+            k->alu8(ALU8_XOR, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_ADD_VX_VY:
+            k->alu8(ALU8_ADD, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SUB:
+            k->alu8(ALU8_SUB, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SHR:
+            k->alu8(ALU8_SHR, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SUBN:
+            k->alu8(ALU8_SUBN, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SHL:
+            k->alu8(ALU8_SHL, vx, vy, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_I:
+            k->reg16(REG16_SET, batch->i, NULL, in->nnn, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_JP_V0:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    batch->pc[l] = (uint16_t) (in->nnn + batch->v[0][l]);
+                }
+            }
+            return join_lane_pcs(batch, next);
+        case CHIP8_OP_RND:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    vx[l] = rng_next_byte(&batch->rng[l]) & in->kk;
+                }
+            }
+            return GROUP_CONTINUE;
+        case CHIP8_OP_DRW:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    draw_lane(batch, l, in);
+                }
+            }
+            return GROUP_CONTINUE;
+        case CHIP8_OP_SKP:
+        case CHIP8_OP_SKNP: {
+            const bool want = in->op == CHIP8_OP_SKP;
+            uint32_t hits = 0;
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                const bool down = (batch->keys_down[l] >> (vx[l] & 0xF)) & 1;
+                const bool hit = m[l] && down == want;
+                batch->taken[l] = hit ? 0xFF : 0;
+                hits += hit;
+            }
+            return split_skip(batch, group, hits, next);
+        }
+        case CHIP8_OP_LD_VX_DT:
+            k->alu8(ALU8_MOV, vx, batch->delay_timer, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_VX_K: {
+            // 새로 눌린 키가 있는 레인만 진행, 없는 레인은 이 명령어에 남음
+            uint32_t ready = 0;
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l] && batch->keys_fresh[l]) {
+                    vx[l] = (uint8_t) __builtin_ctz(batch->keys_fresh[l]);
+                    ++ready;
+                }
+            }
+            if (ready == 0) {
+                return GROUP_WAIT_KEY;
+            }
+            if (ready == group->count) {
+                return GROUP_CONTINUE;
+            }
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    batch->pc[l] = batch->keys_fresh[l] ? *next : group->pc;
+                }
+            }
+            return GROUP_SPLIT;
+        }
+        case CHIP8_OP_LD_DT_VX:
+            k->alu8(ALU8_MOV, batch->delay_timer, vx, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_ST_VX:
+            k->alu8(ALU8_MOV, batch->sound_timer, vx, 0, vf, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_ADD_I_VX:
+            k->reg16(REG16_ADD_U8, batch->i, vx, 0, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_F_VX:
+            k->reg16(REG16_FONT, batch->i, vx, FONTSET_ADDR, m, s);
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_B_VX:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    const uint8_t value = vx[l];
+                    const uint16_t i = batch->i[l];
+                    lane_mem_write(batch, l, i, value / 100);
+                    lane_mem_write(batch, l, i + 1, (value % 100) / 10);
+                    lane_mem_write(batch, l, i + 2, value % 10);
+                }
+            }
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_MEM_VX:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    for (uint8_t r = 0; r <= in->x; r++) {
+                        lane_mem_write(batch, l, batch->i[l] + r, batch->v[r][l]);
+                    }
+                }
+            }
+            return GROUP_CONTINUE;
+        case CHIP8_OP_LD_VX_MEM:
+            for (uint32_t l = 0; l < batch->lanes; l++) {
+                if (m[l]) {
+                    for (uint8_t r = 0; r <= in->x; r++) {
+                        batch->v[r][l] = batch->memory[l][(batch->i[l] + r) & MEMORY_ADDR_MASK];
+                    }
+                }
+            }
+            return GROUP_CONTINUE;
+        default:
+            return GROUP_ERROR;
+    }
+}
+
+/*
+ * 다음 그룹: 남은 명령어가 있는 레인 중 pc가 가장 작은 레인들
+ * 가장 작은 pc부터 실행하면 분기로 뒤처진 레인이 앞선 레인이 기다리는 pc까지 따라와서 다시 합쳐진다.
+ */
+static bool schedule(struct chip8_batch *batch, struct group *group) {
+    uint32_t target = NO_PC;
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (batch->remaining[l] && batch->pc[l] < target) {
+            target = batch->pc[l];
+        }
+    }
+    if (target == NO_PC) {
+        return false;
+    }
+
+    group->pc = (uint16_t) target;
+    group->second_pc = NO_PC;
+    group->budget = UINT32_MAX;
+    group->count = 0;
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        const uint32_t remaining = batch->remaining[l];
+        const bool member = remaining && batch->pc[l] == target;
+        batch->member[l] = member ? 0xFF : 0;
+        if (member) {
+            ++group->count;
+            if (remaining < group->budget) {
+                group->budget = remaining;
+            }
+        } else if (remaining && batch->pc[l] < group->second_pc) {
+            group->second_pc = batch->pc[l];
+        }
+    }
+    ++batch->stats.schedules;
+    return true;
+}
+
+// 그룹 실행을 마치고 멤버의 pc/남은 명령어 반영
+static void finish_group(struct chip8_batch *batch, const struct group *group, const enum group_result result,
+                         const uint32_t steps) {
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (!batch->member[l]) {
+            continue;
+        }
+        switch (result) {
+            case GROUP_CONTINUE:
+                batch->pc[l] = group->pc;
+                batch->remaining[l] -= steps;
+                break;
+            case GROUP_SPLIT:
+                batch->remaining[l] -= steps;
+                break;
+            case GROUP_WAIT_KEY:
+                // 프레임 안에서는 새 키가 생기지 않으므로 남은 명령어를 모두 Fx0A 반복으로 씀
+                batch->stats.instructions += batch->remaining[l] - steps;
+                batch->pc[l] = group->pc;
+                batch->remaining[l] = 0;
+                break;
+            case GROUP_ERROR:
+                // chip8_ctx처럼 에러 난 명령어 다음 pc에서 멈춤
+                batch->pc[l] = (uint16_t) (group->pc + 2);
+                batch->error[l] = ERR_NO_SUPPORTED_OPCODE;
+                batch->remaining[l] = 0;
+                break;
+        }
+    }
+}
+
+errcode_t chip8_batch_step(struct chip8_batch *batch, const uint32_t count) {
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        batch->remaining[l] = batch->error[l] == ERR_NONE ? count : 0;
+    }
+
+    errcode_t err = ERR_NONE;
+    struct group group;
+    struct chip8_insn scratch;
+    while (schedule(batch, &group)) {
+        // 그룹 pc가 다른 그룹의 pc에 닿거나 갈라질 때까지 다시 스케줄하지 않고 이어서 실행
+        enum group_result result = GROUP_CONTINUE;
+        uint32_t steps = 0;
+        while (steps < group.budget) {
+            const struct chip8_insn *in = group_insn(batch, &group, steps, &scratch);
+            uint16_t next = (uint16_t) (group.pc + 2);
+            result = exec_group(batch, &group, in, &next);
+            ++steps;
+            batch->stats.instructions += group.count;
+            ++batch->stats.group_steps;
+            if (result != GROUP_CONTINUE) {
+                break;
+            }
+            group.pc = next;
+            if (group.pc >= group.second_pc) {
+                break;
+            }
+        }
+        if (result == GROUP_ERROR) {
+            err = ERR_NO_SUPPORTED_OPCODE;
+        }
+        finish_group(batch, &group, result, steps);
+    }
+    return err;
+}
+
+uint32_t chip8_batch_frame_budget(struct chip8_batch *batch) {
+    batch->ips_remainder += batch->config.ips;
+    const uint32_t budget = batch->ips_remainder / CHIP8_FRAMES_PER_SECOND;
+    batch->ips_remainder %= CHIP8_FRAMES_PER_SECOND;
+    return budget;
+}
+
+void chip8_batch_tick_timers(struct chip8_batch *batch) {
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        if (batch->error[l] != ERR_NONE) {
+            continue;
+        }
+        uint64_t accumulator = batch->timer_accumulator[l] + CHIP8_FRAME_INTERVAL_NS;
+        while (accumulator >= CHIP8_FRAME_INTERVAL_NS) {
+            if (batch->sound_timer[l] > 0) {
+                --batch->sound_timer[l];
+            }
+            if (batch->delay_timer[l] > 0) {
+                --batch->delay_timer[l];
+            }
+            accumulator -= CHIP8_FRAME_INTERVAL_NS;
+        }
+        batch->timer_accumulator[l] = accumulator;
+        batch->keys_fresh[l] = 0;
+    }
+}
+
+errcode_t chip8_batch_run_frame(struct chip8_batch *batch) {
+    const errcode_t err = chip8_batch_step(batch, chip8_batch_frame_budget(batch));
+    chip8_batch_tick_timers(batch);
+    return err;
+}
+
+void chip8_batch_set_keys(struct chip8_batch *batch, const uint32_t lane, const uint16_t down, const uint16_t pressed) {
+    batch->keys_down[lane] = down;
+    batch->keys_fresh[lane] = pressed;
+}
+
+void chip8_batch_framebuffer(const struct chip8_batch *batch, const uint32_t lane, uint64_t *rows) {
+    for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+        rows[row] = batch->display[row][lane];
+    }
+}
+
+errcode_t chip8_batch_lane_error(const struct chip8_batch *batch, const uint32_t lane) {
+    return (errcode_t) batch->error[lane];
+}
+
+void chip8_batch_get_state(const struct chip8_batch *batch, const uint32_t lane, struct chip8_state *state) {
+    memset(state, 0, sizeof(*state));
+    struct chip8 *chip = &state->chip;
+    memcpy(chip->memory, batch->memory[lane], MEMORY_SIZE);
+    for (int r = 0; r < 16; r++) {
+        chip->v[r] = batch->v[r][lane];
+        chip->stack[r] = batch->stack[r][lane];
+    }
+    for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+        chip->display[row] = batch->display[row][lane];
+    }
+    chip->sp = batch->sp[lane];
+    chip->i = batch->i[lane];
+    chip->pc = batch->pc[lane];
+    chip->delay_timer = batch->delay_timer[lane];
+    chip->sound_timer = batch->sound_timer[lane];
+    state->rng_state = batch->rng[lane].state;
+    state->timer_accumulator_ns = batch->timer_accumulator[lane];
+    state->ips_remainder = batch->ips_remainder;
+}
+
+void chip8_batch_set_state(struct chip8_batch *batch, const uint32_t lane, const struct chip8_state *state) {
+    const struct chip8 *chip = &state->chip;
+    memcpy(batch->memory[lane], chip->memory, MEMORY_SIZE);
+    for (int r = 0; r < 16; r++) {
+        batch->v[r][lane] = chip->v[r];
+        batch->stack[r][lane] = chip->stack[r];
+    }
+    for (int row = 0; row < DISPLAY_HEIGHT; row++) {
+        batch->display[row][lane] = chip->display[row];
+    }
+    batch->sp[lane] = chip->sp;
+    batch->i[lane] = chip->i;
+    batch->pc[lane] = chip->pc;
+    batch->delay_timer[lane] = chip->delay_timer;
+    batch->sound_timer[lane] = chip->sound_timer;
+    batch->rng[lane].state = state->rng_state;
+    batch->timer_accumulator[lane] = state->timer_accumulator_ns;
+    batch->error[lane] = ERR_NONE;
+
+    // 초기 이미지와 다른 페이지 표시 (페이지 첫 바이트가 바뀌면 앞 페이지 끝의 명령어도 영향)
+    uint64_t dirty = 0;
+    for (int page = 0; page < MEMORY_SIZE / CODE_PAGE_SIZE; page++) {
+        const size_t offset = (size_t) page * CODE_PAGE_SIZE;
+        if (memcmp(chip->memory + offset, batch->image + offset, CODE_PAGE_SIZE) != 0) {
+            dirty |= (1ULL << page) | (1ULL << ((page - 1) & (MEMORY_SIZE / CODE_PAGE_SIZE - 1)));
+        }
+    }
+    batch->code_dirty[lane] = dirty;
+    batch->any_code_dirty = 0;
+    for (uint32_t l = 0; l < batch->lanes; l++) {
+        batch->any_code_dirty |= batch->code_dirty[l];
+    }
+}
+
+void chip8_batch_get_stats(const struct chip8_batch *batch, struct chip8_batch_stats *stats) {
+    *stats = batch->stats;
+}
@@ -0,0 +1,75 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "errcode.h"
+#include "libchip8.h"
+
+/*
+ * libchip8 배치 엔진: 같은 ROM을 돌리는 인스턴스(레인) K개를 한 번에 실행
+ * 레지스터, I, pc, sp, 스택, 타이머, 화면, 키 입력은 레인별 배열(SoA)로 두고 메모리만 레인마다 4KB씩 따로 둔다.
+ *
+ * 실행은 pc가 같은 레인들을 한 그룹으로 묶어 디코드한 명령어 하나를 그룹 전체에 적용한다.
+ * 레지스터/비교 명령어는 바이트 배열 위의 마스크 연산이라 AVX2(실행 시 CPU 확인, 없으면 스칼라)로 32레인씩 처리하고,
+ * 메모리/스프라이트/난수처럼 레인마다 주소가 다른 명령어는 그룹 안에서 레인별로 처리한다.
+ * 그룹은 pc가 가장 작은 레인들로 정하고, 분기로 pc가 갈라지면 나눈 뒤 다시 pc가 가장 작은 그룹부터 실행해서
+ * 뒤처진 레인이 앞선 레인의 pc에 도착하면 다시 합쳐진다.
+ *
+ * 결과는 레인마다 같은 입력/시드의 chip8_ctx로 실행한 것과 같다. (정의되지 않은 opcode는 ERR_NO_SUPPORTED_OPCODE)
+ * 에러가 난 레인은 그 명령어 다음 pc에서 멈추고, 다시 적재하거나 상태를 설정하기 전까지 실행하지 않는다.
+ */
+
+#define CHIP8_BATCH_MAX_LANES 4096
+
+struct chip8_batch;
+
+struct chip8_batch_stats {
+    uint64_t instructions; // 레인별로 실행한 명령어 수 합
+    uint64_t group_steps;  // 그룹 단위로 실행한 명령어 수, instructions / group_steps = 평균 그룹 폭
+    uint64_t schedules;    // pc가 가장 작은 그룹을 다시 찾은 횟수
+};
+
+// 레인 lanes개, 설정(ips, 클리핑)은 모든 레인이 같음. 메모리가 부족하거나 lanes가 범위 밖이면 NULL
+struct chip8_batch *chip8_batch_create(const struct chip8_config *config, uint32_t lanes);
+
+void chip8_batch_destroy(struct chip8_batch *batch);
+
+uint32_t chip8_batch_lanes(const struct chip8_batch *batch);
+
+// 모든 레인을 초기 상태로 되돌리고 같은 ROM 적재, 레인 n의 난수 시드는 seeds[n] (NULL이면 모두 설정의 시드)
+errcode_t chip8_batch_load_rom_mem(struct chip8_batch *batch, const uint8_t *rom, size_t size, const uint64_t *seeds);
+
+// 모든 레인이 명령어 count개씩 실행 (에러 난 레인 제외), 이번 호출에서 에러 난 레인이 있으면 그 에러 코드
+errcode_t chip8_batch_step(struct chip8_batch *batch, uint32_t count);
+
+// chip8_frame_budget()과 같음 (모든 레인 공통)
+uint32_t chip8_batch_frame_budget(struct chip8_batch *batch);
+
+// 에러 나지 않은 레인의 60Hz 타이머 갱신, 새로 눌린 키 표시 초기화 (chip8_run_frame()은 에러가 나면 타이머를 진행하지 않음)
+void chip8_batch_tick_timers(struct chip8_batch *batch);
+
+// 한 프레임 실행: chip8_batch_frame_budget()개 명령어 실행 후 chip8_batch_tick_timers()
+errcode_t chip8_batch_run_frame(struct chip8_batch *batch);
+
+// 레인 하나의 키 입력, chip8_set_keys()와 같은 의미
+void chip8_batch_set_keys(struct chip8_batch *batch, uint32_t lane, uint16_t down, uint16_t pressed);
+
+// 레인 하나의 화면을 rows에 복사 (DISPLAY_HEIGHT개)
+void chip8_batch_framebuffer(const struct chip8_batch *batch, uint32_t lane, uint64_t *rows);
+
+// 레인의 마지막 에러, 없으면 ERR_NONE
+errcode_t chip8_batch_lane_error(const struct chip8_batch *batch, uint32_t lane);
+
+void chip8_batch_get_state(const struct chip8_batch *batch, uint32_t lane, struct chip8_state *state);
+
+// 레인 상태 설정, 에러 표시도 지움 (탐색에서 한 상태를 여러 레인에 복사해 갈라 실행하는 용도)
+// ips_remainder는 모든 레인이 같이 쓰므로 무시 (chip8_batch_get_state()는 공통 값을 돌려줌)
+void chip8_batch_set_state(struct chip8_batch *batch, uint32_t lane, const struct chip8_state *state);
+
+void chip8_batch_get_stats(const struct chip8_batch *batch, struct chip8_batch_stats *stats);
+
+#endif // BATCH_H
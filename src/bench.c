@@ -0,0 +1,516 @@
+/*
+ * chip8-bench: 헤드리스 처리량 벤치마크
+ *
+ * ROM마다 에뮬레이터(c_chip_8 --headless)를 별도 프로세스로 여러 번 실행해서
+ * 명령어/초, 명령어당 ns, 프레임/초, 최대 RSS를 측정하고 중앙값/MAD를 JSON으로 출력한다.
+ * 프로세스를 따로 띄우므로 실행마다 캐시/JIT 상태가 초기화되고, 최대 RSS는 wait4()의 rusage로 실행별로 얻는다.
+ * 입력은 기록 파일(--record 형식)로 스크립트해서 매번 같은 명령어 위치에 같은 키가 들어간다.
+ *
+ * 사용법: chip8-bench [options] [rom...] [-- emulator options]
+ *   ROM을 지정하지 않으면 --rom-dir의 *.ch8 전체
+ *   -- 뒤의 인자는 에뮬레이터에 그대로 전달 (예: -- --no-jit)
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#ifndef CHIP8_BENCH_EMULATOR
+#define CHIP8_BENCH_EMULATOR "./c_chip_8"
+#endif
+#ifndef CHIP8_BENCH_ROM_DIR
+#define CHIP8_BENCH_ROM_DIR "roms"
+#endif
+
+#define DEFAULT_INSTRUCTIONS 20000000ULL
+#define DEFAULT_REPEAT 5
+#define DEFAULT_WARMUP 1
+#define DEFAULT_IPS 1000000U // 프레임당 명령어가 충분히 많아야 프레임 처리 비용보다 명령어 실행 비용이 보임
+#define SCRIPT_KEYS_PER_SECOND 10 // 생성하는 입력 스크립트의 키 입력 빈도 (에뮬레이션 시간 기준)
+#define SCRIPT_SEED 0x0123456789ABCDEFULL
+#define MAX_ROMS 256
+#define MAX_REPEAT 100
+#define MAX_EMULATOR_ARGS 32
+#define OUTPUT_LINE_SIZE 256
+
+struct bench_config {
+    const char *emulator;
+    const char *rom_dir;
+    const char *input_path; // NULL이면 입력 스크립트 생성
+    const char *output_path; // NULL이면 stdout
+    uint64_t instructions;
+    uint32_t ips;
+    int repeat;
+    int warmup;
+    const char *extra_args[MAX_EMULATOR_ARGS];
+    int extra_count;
+};
+
+// 실행 한 번의 결과
+struct run_result {
+    uint64_t instructions;
+    uint32_t frames;
+    uint64_t elapsed_ns; // 에뮬레이터가 잰 실행 루프 시간
+    long peak_rss_kb;
+};
+
+struct summary {
+    double median;
+    double mad; // 중앙값으로부터의 절대 편차의 중앙값
+};
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [rom...] [-- emulator options]\n"
+            "  --emulator=PATH     실행할 에뮬레이터 (기본 %s)\n"
+            "  --rom-dir=DIR       ROM을 지정하지 않았을 때 실행할 *.ch8 디렉터리 (기본 %s)\n"
+            "  --instructions=N    실행마다 실행할 명령어 수 (기본 %llu)\n"
+            "  --ips=N             에뮬레이터 초당 명령어 수, 프레임 크기를 정함 (기본 %u)\n"
+            "  --repeat=N          측정 실행 횟수 (기본 %d, 최대 %d)\n"
+            "  --warmup=N          결과에서 제외할 사전 실행 횟수 (기본 %d)\n"
+            "  --input=FILE        입력 스크립트 (--record 형식, ips는 파일을 따름)\n"
+            "                      기본: 에뮬레이션 시간 1초에 %d번 키를 돌아가며 누르는 스크립트 생성\n"
+            "  --output=FILE       JSON 결과 파일 (기본 stdout)\n",
+            prog, CHIP8_BENCH_EMULATOR, CHIP8_BENCH_ROM_DIR, DEFAULT_INSTRUCTIONS, DEFAULT_IPS,
+            DEFAULT_REPEAT, MAX_REPEAT, DEFAULT_WARMUP, SCRIPT_KEYS_PER_SECOND);
+}
+
+static bool parse_u64(const char *arg, const uint64_t min, const uint64_t max, uint64_t *value) {
+    char *end;
+    errno = 0;
+    const unsigned long long parsed = strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < min || parsed > max) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, const int count) {
+    qsort(values, (size_t) count, sizeof(*values), compare_double);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+// 중앙값과 MAD, values는 정렬되면서 바뀜
+static struct summary summarize(double *values, const int count) {
+    struct summary result;
+    result.median = median(values, count);
+    for (int n = 0; n < count; n++) {
+        values[n] = values[n] > result.median ? values[n] - result.median : result.median - values[n];
+    }
+    result.mad = median(values, count);
+    return result;
+}
+
+// 에뮬레이션 시간 1초에 SCRIPT_KEYS_PER_SECOND번 키를 0~F 순서로 누르는 기록 파일 생성
+static bool write_input_script(FILE *fp, const uint32_t ips, const uint64_t instructions) {
+    fprintf(fp, "c_chip_8-replay 1\n");
+    fprintf(fp, "ips %" PRIu32 "\n", ips);
+    fprintf(fp, "clip 0\n");
+    fprintf(fp, "seed 0x%016llX\n", SCRIPT_SEED);
+
+    uint64_t step = ips / SCRIPT_KEYS_PER_SECOND;
+    if (step == 0) {
+        step = 1;
+    }
+    unsigned key = 0;
+    for (uint64_t at = step; at < instructions; at += step) {
+        fprintf(fp, "key %" PRIu64 " %X\n", at, key);
+        key = (key + 1) & 0xF;
+    }
+    // end 줄은 쓰지 않음: 종료는 --max-instructions로
+    return fflush(fp) == 0 && !ferror(fp);
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    const size_t len = strlen(name);
+    const size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static int compare_string(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+// dir의 *.ch8 경로를 이름순으로, 개수 반환 (에러면 -1)
+static int list_roms(const char *dir, char **roms, const int max) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Failed to open ROM directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    int count = 0;
+    const struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && count < max) {
+        if (entry->d_name[0] == '.' || !has_suffix(entry->d_name, ".ch8")) {
+            continue;
+        }
+        const size_t size = strlen(dir) + strlen(entry->d_name) + 2;
+        roms[count] = malloc(size);
+        if (!roms[count]) {
+            break;
+        }
+        snprintf(roms[count], size, "%s/%s", dir, entry->d_name);
+        ++count;
+    }
+    closedir(d);
+    qsort(roms, (size_t) count, sizeof(*roms), compare_string);
+    return count;
+}
+
+// 에뮬레이터를 한 번 실행하고 stdout의 결과 줄과 rusage를 읽음
+static bool run_once(const struct bench_config *config, const char *rom, const char *input,
+                     struct run_result *result) {
+    char max_arg[64];
+    char replay_arg[4096];
+    snprintf(max_arg, sizeof(max_arg), "--max-instructions=%llu", (unsigned long long) config->instructions);
+    snprintf(replay_arg, sizeof(replay_arg), "--replay=%s", input);
+
+    const char *argv[MAX_EMULATOR_ARGS + 8];
+    int argc = 0;
+    argv[argc++] = config->emulator;
+    argv[argc++] = "--headless";
+    argv[argc++] = max_arg;
+    argv[argc++] = replay_arg;
+    for (int n = 0; n < config->extra_count; n++) {
+        argv[argc++] = config->extra_args[n];
+    }
+    argv[argc++] = rom;
+    argv[argc] = NULL;
+
+    int pipe_fd[2];
+    if (pipe(pipe_fd) != 0) {
+        fprintf(stderr, "pipe failed: %s\n", strerror(errno));
+        return false;
+    }
+    const pid_t pid = fork();
+    if (pid < 0) {
+        fprintf(stderr, "fork failed: %s\n", strerror(errno));
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        return false;
+    }
+    if (pid == 0) {
+        dup2(pipe_fd[1], STDOUT_FILENO);
+        close(pipe_fd[0]);
+        close(pipe_fd[1]);
+        execv(config->emulator, (char *const *) argv);
+        fprintf(stderr, "Failed to run %s: %s\n", config->emulator, strerror(errno));
+        _exit(127);
+    }
+    close(pipe_fd[1]);
+
+    char line[OUTPUT_LINE_SIZE] = {0};
+    size_t used = 0;
+    ssize_t len;
+    // 결과는 한 줄뿐이지만 자식이 막히지 않도록 EOF까지 읽음
+    while ((len = read(pipe_fd[0], line + used, sizeof(line) - 1 - used)) != 0) {
+        if (len < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        used += (size_t) len;
+        if (used == sizeof(line) - 1) {
+            char discard[OUTPUT_LINE_SIZE];
+            while (read(pipe_fd[0], discard, sizeof(discard)) > 0) {
+            }
+            break;
+        }
+    }
+    close(pipe_fd[0]);
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, 0, &usage) < 0) {
+        fprintf(stderr, "wait4 failed: %s\n", strerror(errno));
+        return false;
+    }
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+        fprintf(stderr, "%s: emulator exited abnormally (status %d)\n", rom,
+                WIFEXITED(status) ? WEXITSTATUS(status) : -WTERMSIG(status));
+        return false;
+    }
+
+    unsigned long long instructions;
+    unsigned frames;
+    unsigned long long elapsed_ns;
+    if (sscanf(line, "{\"instructions\": %llu, \"frames\": %u, \"elapsed_ns\": %llu}",
+               &instructions, &frames, &elapsed_ns) != 3 || elapsed_ns == 0) {
+        fprintf(stderr, "%s: unexpected emulator output: %s\n", rom, line);
+        return false;
+    }
+    result->instructions = instructions;
+    result->frames = frames;
+    result->elapsed_ns = elapsed_ns;
+#ifdef __APPLE__
+    result->peak_rss_kb = usage.ru_maxrss / 1024; // macOS는 바이트 단위
+#else
+    result->peak_rss_kb = usage.ru_maxrss;
+#endif
+    return true;
+}
+
+static void print_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *) text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04X", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void print_summary(FILE *out, const char *name, const struct summary summary, const bool last) {
+    fprintf(out, "      \"%s\": {\"median\": %.3f, \"mad\": %.3f}%s\n", name, summary.median, summary.mad,
+            last ? "" : ",");
+}
+
+static void print_rom_result(FILE *out, const char *rom, const struct run_result *runs, const int count) {
+    double ips[MAX_REPEAT];
+    double ns_per_insn[MAX_REPEAT];
+    double fps[MAX_REPEAT];
+    double rss[MAX_REPEAT];
+    for (int n = 0; n < count; n++) {
+        const double seconds = (double) runs[n].elapsed_ns / 1e9;
+        ips[n] = (double) runs[n].instructions / seconds;
+        ns_per_insn[n] = (double) runs[n].elapsed_ns / (double) runs[n].instructions;
+        fps[n] = (double) runs[n].frames / seconds;
+        rss[n] = (double) runs[n].peak_rss_kb;
+    }
+
+    const char *name = strrchr(rom, '/') ? strrchr(rom, '/') + 1 : rom;
+    fprintf(out, "    {\n      \"rom\": ");
+    print_json_string(out, name);
+    fprintf(out, ",\n      \"instructions\": %" PRIu64 ",\n      \"frames\": %" PRIu32 ",\n",
+            runs[0].instructions, runs[0].frames);
+    print_summary(out, "instructions_per_second", summarize(ips, count), false);
+    print_summary(out, "ns_per_instruction", summarize(ns_per_insn, count), false);
+    print_summary(out, "frames_per_second", summarize(fps, count), false);
+    print_summary(out, "peak_rss_kb", summarize(rss, count), false);
+    fprintf(out, "      \"elapsed_ns\": [");
+    for (int n = 0; n < count; n++) {
+        fprintf(out, "%s%" PRIu64, n ? ", " : "", runs[n].elapsed_ns);
+    }
+    fprintf(out, "]\n    }");
+}
+
+static int parse_args(int argc, char *argv[], struct bench_config *config) {
+    enum { OPT_EMULATOR = 0x100, OPT_ROM_DIR, OPT_INSTRUCTIONS, OPT_IPS, OPT_REPEAT, OPT_WARMUP, OPT_INPUT, OPT_OUTPUT };
+    static const struct option long_options[] = {
+        {"emulator", required_argument, NULL, OPT_EMULATOR},
+        {"rom-dir", required_argument, NULL, OPT_ROM_DIR},
+        {"instructions", required_argument, NULL, OPT_INSTRUCTIONS},
+        {"ips", required_argument, NULL, OPT_IPS},
+        {"repeat", required_argument, NULL, OPT_REPEAT},
+        {"warmup", required_argument, NULL, OPT_WARMUP},
+        {"input", required_argument, NULL, OPT_INPUT},
+        {"output", required_argument, NULL, OPT_OUTPUT},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    uint64_t value;
+    while ((opt = getopt_long(argc, argv, "+h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case OPT_EMULATOR:
+                config->emulator = optarg;
+                break;
+            case OPT_ROM_DIR:
+                config->rom_dir = optarg;
+                break;
+            case OPT_INSTRUCTIONS:
+                if (!parse_u64(optarg, 1, UINT64_MAX, &config->instructions)) {
+                    fprintf(stderr, "Invalid --instructions: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case OPT_IPS:
+                if (!parse_u64(optarg, 1, 100000000, &value)) {
+                    fprintf(stderr, "Invalid --ips: %s\n", optarg);
+                    return -1;
+                }
+                config->ips = (uint32_t) value;
+                break;
+            case OPT_REPEAT:
+                if (!parse_u64(optarg, 1, MAX_REPEAT, &value)) {
+                    fprintf(stderr, "Invalid --repeat: %s\n", optarg);
+                    return -1;
+                }
+                config->repeat = (int) value;
+                break;
+            case OPT_WARMUP:
+                if (!parse_u64(optarg, 0, MAX_REPEAT, &value)) {
+                    fprintf(stderr, "Invalid --warmup: %s\n", optarg);
+                    return -1;
+                }
+                config->warmup = (int) value;
+                break;
+            case OPT_INPUT:
+                config->input_path = optarg;
+                break;
+            case OPT_OUTPUT:
+                config->output_path = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(0);
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+
+    // 옵션 뒤는 ROM 목록, "--" 뒤는 에뮬레이터 인자 (ROM 없이 "--"가 오면 getopt_long이 이미 건너뜀)
+    int rom_end = argc;
+    int extra_start = argc;
+    if (optind > 1 && strcmp(argv[optind - 1], "--") == 0) {
+        rom_end = optind;
+        extra_start = optind;
+    } else {
+        for (int n = optind; n < argc; n++) {
+            if (strcmp(argv[n], "--") == 0) {
+                rom_end = n;
+                extra_start = n + 1;
+                break;
+            }
+        }
+    }
+    if (argc - extra_start > MAX_EMULATOR_ARGS) {
+        fprintf(stderr, "Too many emulator options (max %d)\n", MAX_EMULATOR_ARGS);
+        return -1;
+    }
+    for (int n = extra_start; n < argc; n++) {
+        config->extra_args[config->extra_count++] = argv[n];
+    }
+    return rom_end;
+}
+
+int main(int argc, char *argv[]) {
+    struct bench_config config = {
+        .emulator = CHIP8_BENCH_EMULATOR,
+        .rom_dir = CHIP8_BENCH_ROM_DIR,
+        .input_path = NULL,
+        .output_path = NULL,
+        .instructions = DEFAULT_INSTRUCTIONS,
+        .ips = DEFAULT_IPS,
+        .repeat = DEFAULT_REPEAT,
+        .warmup = DEFAULT_WARMUP,
+        .extra_count = 0
+    };
+    const int rom_end = parse_args(argc, argv, &config);
+    if (rom_end < 0) {
+        return 1;
+    }
+
+    char *roms[MAX_ROMS];
+    int rom_count = 0;
+    bool owned_roms = false;
+    for (int n = optind; n < rom_end && rom_count < MAX_ROMS; n++) {
+        roms[rom_count++] = argv[n];
+    }
+    if (rom_count == 0) {
+        rom_count = list_roms(config.rom_dir, roms, MAX_ROMS);
+        owned_roms = true;
+        if (rom_count <= 0) {
+            fprintf(stderr, "No ROMs to run\n");
+            return 1;
+        }
+    }
+
+    // 입력 스크립트, 지정하지 않았으면 임시 파일로 생성
+    char script_path[] = "/tmp/chip8-bench-XXXXXX";
+    const char *input = config.input_path;
+    if (!input) {
+        const int fd = mkstemp(script_path);
+        FILE *fp = fd >= 0 ? fdopen(fd, "w") : NULL;
+        if (!fp || !write_input_script(fp, config.ips, config.instructions)) {
+            fprintf(stderr, "Failed to write input script: %s\n", strerror(errno));
+            return 1;
+        }
+        fclose(fp);
+        input = script_path;
+    }
+
+    FILE *out = stdout;
+    if (config.output_path) {
+        out = fopen(config.output_path, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open %s: %s\n", config.output_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"emulator\": ");
+    print_json_string(out, config.emulator);
+    fprintf(out, ",\n  \"emulator_args\": [");
+    for (int n = 0; n < config.extra_count; n++) {
+        fprintf(out, "%s", n ? ", " : "");
+        print_json_string(out, config.extra_args[n]);
+    }
+    fprintf(out, "],\n  \"input\": ");
+    print_json_string(out, config.input_path ? config.input_path : "generated");
+    fprintf(out, ",\n  \"repeat\": %d,\n  \"warmup\": %d,\n  \"results\": [\n", config.repeat, config.warmup);
+
+    int failures = 0;
+    bool first = true;
+    for (int r = 0; r < rom_count; r++) {
+        struct run_result runs[MAX_REPEAT];
+        bool ok = true;
+        for (int n = 0; ok && n < config.warmup + config.repeat; n++) {
+            struct run_result result;
+            ok = run_once(&config, roms[r], input, &result);
+            if (ok && n >= config.warmup) {
+                runs[n - config.warmup] = result;
+            }
+        }
+        if (!ok) {
+            ++failures;
+            continue;
+        }
+        // 실패한 ROM은 빠지므로 구분 쉼표는 항목 앞에
+        fprintf(out, "%s", first ? "" : ",\n");
+        print_rom_result(out, roms[r], runs, config.repeat);
+        first = false;
+        // 진행 상황은 stderr로 (JSON 출력과 섞이지 않도록)
+        double ns[MAX_REPEAT];
+        for (int n = 0; n < config.repeat; n++) {
+            ns[n] = (double) runs[n].elapsed_ns / (double) runs[n].instructions;
+        }
+        fprintf(stderr, "%s: %.2f ns/instruction\n", roms[r], median(ns, config.repeat));
+    }
+    fprintf(out, "%s  ]\n}\n", first ? "" : "\n");
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    if (!config.input_path) {
+        unlink(script_path);
+    }
+    if (owned_roms) {
+        for (int r = 0; r < rom_count; r++) {
+            free(roms[r]);
+        }
+    }
+    return failures ? 1 : 0;
+}
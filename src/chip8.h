@@ -7,11 +7,23 @@
 #define DISPLAY_HEIGHT      32
 #define DISPLAY_WIDTH_BYTES   (DISPLAY_WIDTH / 8) // 8bit = 1byte라고 가정
 
+// 디스플레이 한 행 = uint64_t 하나, 최상위 비트가 x = 0
+#define DISPLAY_ROW_BYTE(row, b) ((uint8_t) ((row) >> (56 - 8 * (b)))) // 행의 b번째 바이트 (픽셀 8b ~ 8b+7)
+
+#define MEMORY_SIZE         4096
+#define MEMORY_ADDR_MASK    (MEMORY_SIZE - 1)
+#define CODE_PAGE_SHIFT     6 // 코드 캐시 무효화 단위, 64바이트 페이지 * 64개 = 4KB
+#define CODE_PAGE_SIZE      (1 << CODE_PAGE_SHIFT)
+
+#define FONTSET_ADDR        0x50 // TODO: 이름 Base addr이 더 나은듯?
+#define FONT_SIZE           40 // 0x28, 8 byte
+#define PROGRAM_START_ADDR  0x200
+
 #define PIXEL_ON_STR   "██" // 글자는 가로로 기니까 크기를 맞추기 위해서 2글자씩 사용
 #define PIXEL_OFF_STR  "  "
 
 struct chip8 {
-    uint8_t memory[4096];       // 최대 4kb
+    uint8_t memory[MEMORY_SIZE]; // 최대 4kb
     uint16_t stack[16];         // 2^8 - 서브루틴 중첨 처리
     uint8_t sp;                 // 스택 포인터 (2^8로 충분)
     uint16_t i;                 // 메모리 주소 저장용 레지스터
@@ -19,7 +31,7 @@ struct chip8 {
     uint8_t v[16];              // 범용 레지스터
     uint8_t delay_timer;        // 딜레이
     uint8_t sound_timer;        // 사운드
-    uint8_t display[DISPLAY_WIDTH_BYTES * DISPLAY_HEIGHT]; // 64 * 32 디스플레이
+    uint64_t display[DISPLAY_HEIGHT]; // 64 * 32 디스플레이, 행마다 64비트
 };
 
 #endif // CHIP8_H
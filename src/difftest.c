@@ -0,0 +1,758 @@
+/*
+ * chip8-difftest: 실행 엔진 차등 테스트
+ *
+ * 같은 프로그램/시드/키 입력을 기준 엔진(chip8_ctx, chip8_run_frame())과 다른 실행 경로로 돌리고
+ * 프레임마다 에러 코드와 실행 상태(struct chip8_state) 전체를 비교한다.
+ *   batch  배치 엔진(batch.c)의 레인별 결과, 중간에 레인끼리 상태를 섞는 chip8_batch_set_state() 포함
+ *   clone  chip8_clone()(풀/malloc)과 chip8_copy()로 만든 복제본, 복제 뒤 원본을 다른 입력으로 돌려도 영향이 없는지와
+ *          chip8_state_hash()가 chip8_hash_machine()과 같은지
+ *   jit    JIT 블록 + 인터프리터(c_chip_8의 execute_native()와 같은 순서), CHIP8_JIT 빌드에서만
+ * batch.c와 JIT은 opcode 의미를 따로 구현하므로 libchip8.c의 명령어 처리를 바꾸면 여기서 어긋난 곳이 보인다.
+ *
+ * 프로그램은 ROM 파일과 생성 프로그램이다. 생성 프로그램은 모든 명령어 계열(0NNN, 정의되지 않은 5xy1 포함)을 섞은 코드로
+ * [PROGRAM_START_ADDR, CODE_END)를 채운다. Fx29 뒤의 Fx33/Fx55는 코드 영역에 쓸 수 있어서 self-modifying code도 생긴다.
+ *
+ * 사용법: chip8-difftest [options] [rom...]
+ *   ROM을 지정하지 않으면 --rom-dir의 *.ch8 전체, 어긋난 곳이 있으면 종료 코드 1
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "libchip8.h"
+
+#ifdef CHIP8_JIT
+#include "jit.h"
+#endif
+
+#ifndef CHIP8_DIFFTEST_ROM_DIR
+#define CHIP8_DIFFTEST_ROM_DIR "roms"
+#endif
+
+#define DEFAULT_FRAMES 600 // 에뮬레이션 시간 10초
+#define DEFAULT_PROGRAMS 64
+#define DEFAULT_LANES 16
+#define DEFAULT_IPS 700U
+#define DEFAULT_SEED 0x0123456789ABCDEFULL
+#define ROM_MAX_SIZE (MEMORY_SIZE - PROGRAM_START_ADDR)
+#define MAX_ROMS 256
+#define MAX_PROGRAMS 4096
+#define MAX_FRAMES 100000
+#define MAX_REPORTS 10 // 검사마다 자세히 출력하는 불일치 수
+
+// 생성 프로그램: 코드는 [PROGRAM_START_ADDR, CODE_END), 끝에 처음으로 돌아가는 JP 두 개 (skip이 첫 번째를 건너뛸 수 있음)
+// 메모리 쓰기/읽기(Fx33/Fx55/Fx65/Dxyn)의 I는 Annn이면 [DATA_ADDR, DATA_END), Fx29면 폰트 영역부터 0x50A까지
+#define CODE_END  0xE00
+#define DATA_ADDR 0xE00
+#define DATA_END  0xFF0 // Fx55 x=F가 I + 15까지 씀
+
+struct difftest_program {
+    char name[64];
+    uint8_t data[ROM_MAX_SIZE];
+    size_t size;
+};
+
+struct difftest_config {
+    const char *rom_dir;
+    uint32_t frames;
+    uint32_t programs;
+    uint32_t lanes;
+    uint32_t ips;
+    uint64_t seed;
+};
+
+// 검사별 결과
+struct difftest_result {
+    const char *name;
+    uint64_t runs;      // 비교한 인스턴스(레인/복제본) 수
+    uint64_t frames;    // 비교한 프레임 수 합
+    uint64_t errors;    // 두 쪽 모두 같은 에러로 멈춘 인스턴스 수
+    uint64_t mismatches;
+};
+
+static inline uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    return *state = x;
+}
+
+// 키 입력 생성: 프레임마다 25% 확률로 키 하나를 누르고 있고, 12.5% 확률로 새로 누른 키 하나
+static void random_keys(uint64_t *rng, uint16_t *down, uint16_t *pressed) {
+    *down = xorshift64(rng) % 4 == 0 ? (uint16_t) (1u << (xorshift64(rng) % 16)) : 0;
+    *pressed = xorshift64(rng) % 8 == 0 ? (uint16_t) (1u << (xorshift64(rng) % 16)) : 0;
+}
+
+static uint16_t random_opcode(uint64_t *rng) {
+    const uint16_t x = (uint16_t) ((xorshift64(rng) % 16) << 8);
+    const uint16_t y = (uint16_t) ((xorshift64(rng) % 16) << 4);
+    const uint16_t kk = (uint16_t) (xorshift64(rng) & 0xFF);
+    const uint16_t code = (uint16_t) (PROGRAM_START_ADDR + 2 * (xorshift64(rng) % ((CODE_END - PROGRAM_START_ADDR) / 2)));
+    const uint16_t data = (uint16_t) (DATA_ADDR + xorshift64(rng) % (DATA_END - DATA_ADDR));
+    static const uint16_t skip_kk[] = {0, 1, 2, 3};
+    static const uint16_t alu[] = {0x0, 0x1, 0x2, 0x3, 0x4, 0x5, 0x6, 0x7, 0xE};
+    static const uint16_t rand_mask[] = {0x01, 0x03, 0x07, 0xFF};
+    static const uint16_t misc[] = {0xF007, 0xF015, 0xF018, 0xF029, 0xF033, 0xF055, 0xF065};
+    const unsigned k = (unsigned) (xorshift64(rng) % 100);
+    if (k < 8) {
+        return 0x1000 | code;
+    }
+    if (k < 10) {
+        return 0x2000 | code; // 되돌아오지 않는 호출, 16단을 넘으면 스택 인덱스가 감싸짐
+    }
+    if (k < 18) {
+        const uint16_t value = xorshift64(rng) % 5 ? skip_kk[xorshift64(rng) % 4] : kk;
+        return (xorshift64(rng) % 2 ? 0x3000 : 0x4000) | x | value;
+    }
+    if (k < 22) {
+        return (xorshift64(rng) % 2 ? 0x5000 : 0x9000) | x | y;
+    }
+    if (k < 30) {
+        return 0x6000 | x | kk;
+    }
+    if (k < 36) {
+        return 0x7000 | x | kk;
+    }
+    if (k < 52) {
+        return 0x8000 | x | y | alu[xorshift64(rng) % 9];
+    }
+    if (k < 56) {
+        return 0xA000 | data;
+    }
+    if (k < 64) {
+        return 0xC000 | x | rand_mask[xorshift64(rng) % 4];
+    }
+    if (k < 70) {
+        return 0xD000 | x | y | (uint16_t) (xorshift64(rng) % 16);
+    }
+    if (k < 74) {
+        return (xorshift64(rng) % 2 ? 0xE09E : 0xE0A1) | x;
+    }
+    if (k < 75) {
+        return 0xF00A | x;
+    }
+    if (k < 90) {
+        return misc[xorshift64(rng) % 7] | x;
+    }
+    if (k < 91) {
+        // 0NNN과 정의되지 않은 opcode, 모든 엔진이 같은 위치에서 같은 에러로 멈춰야 함 (드물게, 대부분 실행이 끝까지 가도록)
+        const unsigned pick = (unsigned) (xorshift64(rng) % 8);
+        return pick == 0 ? code : pick == 1 ? 0x0000 : pick == 2 ? 0x5001 | x : 0x7001 | x;
+    }
+    if (k < 93) {
+        return 0x00E0;
+    }
+    return 0x7001 | x;
+}
+
+static inline void put_opcode(struct difftest_program *program, const uint16_t addr, const uint16_t opcode) {
+    program->data[addr - PROGRAM_START_ADDR] = (uint8_t) (opcode >> 8);
+    program->data[addr - PROGRAM_START_ADDR + 1] = (uint8_t) opcode;
+}
+
+static void generate_program(struct difftest_program *program, const uint32_t index, const uint64_t seed) {
+    uint64_t rng = seed ^ ((uint64_t) (index + 1) * 0x9E3779B97F4A7C15ULL);
+    if (!rng) {
+        rng = 1;
+    }
+    snprintf(program->name, sizeof(program->name), "generated-%04" PRIu32, index);
+    for (uint16_t addr = PROGRAM_START_ADDR; addr < CODE_END - 4; addr += 2) {
+        put_opcode(program, addr, random_opcode(&rng));
+    }
+    put_opcode(program, CODE_END - 4, 0x1000 | PROGRAM_START_ADDR);
+    put_opcode(program, CODE_END - 2, 0x1000 | PROGRAM_START_ADDR);
+    for (uint16_t data = DATA_ADDR; data < MEMORY_SIZE; data++) {
+        program->data[data - PROGRAM_START_ADDR] = (uint8_t) xorshift64(&rng);
+    }
+    program->size = MEMORY_SIZE - PROGRAM_START_ADDR;
+}
+
+/*
+ * 상태 비교, 같으면 NULL, 다르면 처음 다른 항목 이름
+ * struct chip8_state는 패딩이 있어서 memcmp()로 비교하지 않는다.
+ */
+static const char *compare_state(const struct chip8_state *a, const struct chip8_state *b) {
+    if (a->chip.pc != b->chip.pc) {
+        return "pc";
+    }
+    if (a->chip.i != b->chip.i) {
+        return "i";
+    }
+    if (memcmp(a->chip.v, b->chip.v, sizeof(a->chip.v)) != 0) {
+        return "v";
+    }
+    if (a->chip.sp != b->chip.sp) {
+        return "sp";
+    }
+    if (memcmp(a->chip.stack, b->chip.stack, sizeof(a->chip.stack)) != 0) {
+        return "stack";
+    }
+    if (a->chip.delay_timer != b->chip.delay_timer || a->chip.sound_timer != b->chip.sound_timer) {
+        return "timers";
+    }
+    if (memcmp(a->chip.memory, b->chip.memory, sizeof(a->chip.memory)) != 0) {
+        return "memory";
+    }
+    if (memcmp(a->chip.display, b->chip.display, sizeof(a->chip.display)) != 0) {
+        return "display";
+    }
+    if (a->rng_state != b->rng_state) {
+        return "rng_state";
+    }
+    if (a->timer_accumulator_ns != b->timer_accumulator_ns) {
+        return "timer_accumulator_ns";
+    }
+    if (a->ips_remainder != b->ips_remainder) {
+        return "ips_remainder";
+    }
+    return NULL;
+}
+
+static void report_mismatch(struct difftest_result *result, const struct difftest_program *program,
+                            const uint32_t frame, const char *where, const char *what) {
+    if (result->mismatches++ < MAX_REPORTS) {
+        fprintf(stderr, "[%s] %s frame %" PRIu32 " %s: %s differs\n", result->name, program->name, frame, where, what);
+    }
+}
+
+// 에러 코드와 상태가 같은지, 다르면 보고하고 false
+static bool check_frame(struct difftest_result *result, const struct difftest_program *program, const uint32_t frame,
+                        const char *where, const errcode_t expected_err, const struct chip8_state *expected,
+                        const errcode_t err, const struct chip8_state *state) {
+    if (err != expected_err) {
+        char what[64];
+        snprintf(what, sizeof(what), "error (%d != %d)", err, expected_err);
+        report_mismatch(result, program, frame, where, what);
+        return false;
+    }
+    const char *what = compare_state(expected, state);
+    if (what) {
+        report_mismatch(result, program, frame, where, what);
+        return false;
+    }
+    return true;
+}
+
+static struct chip8_ctx *create_ctx(const struct difftest_config *config, const struct difftest_program *program,
+                                    const uint64_t seed) {
+    const struct chip8_config vm_config = {.ips = config->ips, .clip_sprites = false, .seed = seed};
+    struct chip8_ctx *ctx = chip8_create(&vm_config);
+    if (ctx && chip8_load_rom_mem(ctx, program->data, program->size) != ERR_NONE) {
+        chip8_destroy(ctx);
+        return NULL;
+    }
+    return ctx;
+}
+
+static inline uint64_t lane_seed(const struct difftest_config *config, const uint32_t lane) {
+    return config->seed ^ ((uint64_t) lane * 1000003 + 1);
+}
+
+/*
+ * 배치 vs chip8_ctx
+ * 레인마다 시드와 키 입력이 다르고, 프레임 중간(frames / 2)에 레인 l에 레인 (l * 7 + 3) % K의 상태를 넣어 섞는다.
+ */
+static bool check_batch(const struct difftest_config *config, const struct difftest_program *program,
+                        struct difftest_result *result) {
+    const uint32_t lanes = config->lanes;
+    struct chip8_batch *batch = NULL;
+    struct chip8_ctx **ctx = calloc(lanes, sizeof(*ctx));
+    uint64_t *seeds = calloc(lanes, sizeof(*seeds));
+    bool *live = calloc(lanes, sizeof(*live));
+    struct chip8_state *states = calloc(lanes, sizeof(*states));
+    bool ok = ctx && seeds && live && states;
+    if (ok) {
+        const struct chip8_config vm_config = {.ips = config->ips, .clip_sprites = false, .seed = 0};
+        batch = chip8_batch_create(&vm_config, lanes);
+        for (uint32_t l = 0; l < lanes && ok; l++) {
+            seeds[l] = lane_seed(config, l);
+            ctx[l] = create_ctx(config, program, seeds[l]);
+            live[l] = true;
+            ok = ctx[l] != NULL;
+        }
+        ok = ok && batch && chip8_batch_load_rom_mem(batch, program->data, program->size, seeds) == ERR_NONE;
+    }
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+    }
+
+    uint64_t rng = config->seed ^ 0xBA7C4ULL;
+    uint32_t live_count = lanes;
+    for (uint32_t frame = 0; ok && frame < config->frames && live_count > 0; frame++) {
+        for (uint32_t l = 0; l < lanes; l++) {
+            uint16_t down, pressed;
+            random_keys(&rng, &down, &pressed);
+            chip8_set_keys(ctx[l], down, pressed);
+            chip8_batch_set_keys(batch, l, down, pressed);
+        }
+        if (frame == config->frames / 2) {
+            for (uint32_t l = 0; l < lanes; l++) {
+                chip8_get_state(ctx[l], &states[l]);
+            }
+            for (uint32_t l = 0; l < lanes; l++) {
+                const uint32_t from = (l * 7 + 3) % lanes;
+                if (live[l] && live[from]) {
+                    chip8_set_state(ctx[l], &states[from]);
+                    chip8_batch_set_state(batch, l, &states[from]);
+                }
+            }
+        }
+        chip8_batch_run_frame(batch);
+        for (uint32_t l = 0; l < lanes; l++) {
+            if (!live[l]) {
+                continue;
+            }
+            struct chip8_state expected, state;
+            const errcode_t expected_err = chip8_run_frame(ctx[l]);
+            chip8_get_state(ctx[l], &expected);
+            chip8_batch_get_state(batch, l, &state);
+            char where[32];
+            snprintf(where, sizeof(where), "lane %" PRIu32, l);
+            ++result->frames;
+            if (!check_frame(result, program, frame, where, expected_err, &expected,
+                             chip8_batch_lane_error(batch, l), &state)) {
+                live[l] = false;
+                --live_count;
+            } else if (expected_err != ERR_NONE) {
+                ++result->errors;
+                live[l] = false;
+                --live_count;
+            }
+        }
+    }
+    result->runs += lanes;
+
+    chip8_batch_destroy(batch);
+    for (uint32_t l = 0; ctx && l < lanes; l++) {
+        chip8_destroy(ctx[l]);
+    }
+    free(ctx);
+    free(seeds);
+    free(live);
+    free(states);
+    return ok;
+}
+
+/*
+ * 복제본 vs 복제하지 않은 인스턴스
+ * 원본과 기준 인스턴스를 frames / 3까지 같이 돌린 뒤 원본을 풀/malloc/chip8_copy()로 복제하고,
+ * 원본은 다른 키 입력으로 계속 돌려서 복제본이 원본과 공유하는 것이 없는지 확인한다.
+ */
+#define CLONE_COUNT 3
+
+static bool check_clone(const struct difftest_config *config, const struct difftest_program *program,
+                        struct chip8_pool *pool, struct difftest_result *result) {
+    static const char *const clone_names[CLONE_COUNT] = {"pool clone", "malloc clone", "copy"};
+    const uint64_t seed = lane_seed(config, 0);
+    struct chip8_ctx *reference = create_ctx(config, program, seed);
+    struct chip8_ctx *source = create_ctx(config, program, seed);
+    struct chip8_ctx *clones[CLONE_COUNT] = {NULL};
+    bool live[CLONE_COUNT] = {true, true, true};
+    bool ok = reference && source;
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+    }
+
+    uint64_t rng = config->seed ^ 0xC10EULL;
+    uint64_t source_rng = config->seed ^ 0x50CEULL;
+    const uint32_t split = config->frames / 3;
+    errcode_t err = ERR_NONE;
+    uint32_t frame = 0;
+    for (; ok && frame < split && err == ERR_NONE; frame++) {
+        uint16_t down, pressed;
+        random_keys(&rng, &down, &pressed);
+        chip8_set_keys(reference, down, pressed);
+        chip8_set_keys(source, down, pressed);
+        err = chip8_run_frame(reference);
+        chip8_run_frame(source);
+    }
+    if (ok && err == ERR_NONE) {
+        // 해시 추적 상태도 복제되는지 보도록 원본의 해시를 한 번 계산해둔다
+        chip8_state_hash(source);
+        clones[0] = chip8_clone(source, pool);
+        clones[1] = chip8_clone(source, NULL);
+        const struct chip8_config vm_config = {.ips = config->ips, .clip_sprites = false, .seed = ~seed};
+        clones[2] = chip8_create(&vm_config);
+        if (clones[2]) {
+            chip8_copy(clones[2], source);
+        }
+        ok = clones[0] && clones[1] && clones[2];
+        if (!ok) {
+            fprintf(stderr, "Out of memory\n");
+        }
+    }
+
+    for (; ok && frame < config->frames && err == ERR_NONE && (live[0] || live[1] || live[2]); frame++) {
+        uint16_t down, pressed;
+        random_keys(&source_rng, &down, &pressed);
+        chip8_set_keys(source, down, pressed);
+        chip8_run_frame(source);
+
+        random_keys(&rng, &down, &pressed);
+        chip8_set_keys(reference, down, pressed);
+        err = chip8_run_frame(reference);
+        struct chip8_state expected;
+        chip8_get_state(reference, &expected);
+        const uint64_t expected_hash = chip8_hash_machine(chip8_machine_const(reference));
+        for (int n = 0; n < CLONE_COUNT; n++) {
+            if (!live[n]) {
+                continue;
+            }
+            chip8_set_keys(clones[n], down, pressed);
+            const errcode_t clone_err = chip8_run_frame(clones[n]);
+            struct chip8_state state;
+            chip8_get_state(clones[n], &state);
+            ++result->frames;
+            if (!check_frame(result, program, frame, clone_names[n], err, &expected, clone_err, &state)) {
+                live[n] = false;
+            } else if (chip8_state_hash(clones[n]) != expected_hash) {
+                report_mismatch(result, program, frame, clone_names[n], "state hash");
+                live[n] = false;
+            }
+        }
+    }
+    if (ok && err != ERR_NONE) {
+        ++result->errors;
+    }
+    result->runs += CLONE_COUNT;
+
+    for (int n = 0; n < CLONE_COUNT; n++) {
+        chip8_destroy(clones[n]);
+    }
+    chip8_destroy(source);
+    chip8_destroy(reference);
+    return ok;
+}
+
+#ifdef CHIP8_JIT
+static uint64_t written_pages;
+
+static inline void sync_written_pages(void) {
+    if (written_pages) {
+        jit_notify_write(written_pages);
+        written_pages = 0;
+    }
+}
+
+// c_chip_8의 execute_native()에서 AOT/플라이트 레코더를 뺀 것
+static errcode_t execute_jit(struct chip8_ctx *ctx, const uint32_t budget) {
+    struct chip8 *chip = chip8_machine(ctx);
+    uint32_t executed = 0;
+    sync_written_pages();
+    while (executed < budget) {
+        if (chip->pc <= MEMORY_ADDR_MASK) {
+            const struct jit_block *block = jit_get_block(chip, chip->pc);
+            if (block->fn && block->count <= budget - executed) {
+                block->fn(chip);
+                executed += block->count;
+                continue;
+            }
+        }
+        const errcode_t err = chip8_step(ctx, 1);
+        if (err != ERR_NONE) {
+            return err;
+        }
+        sync_written_pages();
+        ++executed;
+    }
+    return ERR_NONE;
+}
+
+// JIT + 인터프리터 vs 인터프리터
+static bool check_jit(const struct difftest_config *config, const struct difftest_program *program,
+                      struct difftest_result *result) {
+    const uint64_t seed = lane_seed(config, 0);
+    struct chip8_ctx *reference = create_ctx(config, program, seed);
+    struct chip8_ctx *ctx = create_ctx(config, program, seed);
+    const bool ok = reference && ctx;
+    if (!ok) {
+        fprintf(stderr, "Out of memory\n");
+    } else {
+        // 번역된 블록은 pc로만 찾으므로 프로그램이 바뀌면 모두 버린다
+        jit_flush();
+        written_pages = 0;
+        chip8_set_write_watch(ctx, &written_pages);
+    }
+
+    uint64_t rng = config->seed ^ 0x717ULL;
+    for (uint32_t frame = 0; ok && frame < config->frames; frame++) {
+        uint16_t down, pressed;
+        random_keys(&rng, &down, &pressed);
+        chip8_set_keys(reference, down, pressed);
+        chip8_set_keys(ctx, down, pressed);
+        const errcode_t expected_err = chip8_run_frame(reference);
+        errcode_t err = execute_jit(ctx, chip8_frame_budget(ctx));
+        if (err == ERR_NONE) {
+            chip8_tick_timers(ctx);
+        }
+        struct chip8_state expected, state;
+        chip8_get_state(reference, &expected);
+        chip8_get_state(ctx, &state);
+        ++result->frames;
+        if (!check_frame(result, program, frame, "jit", expected_err, &expected, err, &state)) {
+            break;
+        }
+        if (expected_err != ERR_NONE) {
+            ++result->errors;
+            break;
+        }
+    }
+    result->runs += 1;
+
+    chip8_destroy(ctx);
+    chip8_destroy(reference);
+    return ok;
+}
+#endif
+
+static bool parse_u64(const char *arg, const uint64_t min, const uint64_t max, uint64_t *value) {
+    char *end;
+    errno = 0;
+    const unsigned long long parsed = strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < min || parsed > max) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    const size_t len = strlen(name);
+    const size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static int compare_string(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+// dir의 *.ch8 경로를 이름순으로, 개수 반환 (에러면 -1)
+static int list_roms(const char *dir, char **paths, const int max) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Failed to open ROM directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    int count = 0;
+    const struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && count < max) {
+        if (entry->d_name[0] == '.' || !has_suffix(entry->d_name, ".ch8")) {
+            continue;
+        }
+        const size_t size = strlen(dir) + strlen(entry->d_name) + 2;
+        paths[count] = malloc(size);
+        if (!paths[count]) {
+            break;
+        }
+        snprintf(paths[count], size, "%s/%s", dir, entry->d_name);
+        ++count;
+    }
+    closedir(d);
+    qsort(paths, (size_t) count, sizeof(*paths), compare_string);
+    return count;
+}
+
+static bool load_rom(const char *path, struct difftest_program *program) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open ROM %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    const char *name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    snprintf(program->name, sizeof(program->name), "%s", name);
+    program->size = fread(program->data, 1, sizeof(program->data), fp);
+    const bool too_large = fgetc(fp) != EOF;
+    const bool failed = ferror(fp) != 0;
+    fclose(fp);
+    if (too_large || failed) {
+        fprintf(stderr, "%s: %s\n", path, too_large ? "ROM too large" : "read failed");
+        return false;
+    }
+    return true;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [rom...]\n"
+            "  --frames=N     프로그램마다 실행할 프레임 수 (기본 %d)\n"
+            "  --programs=N   ROM과 함께 실행할 생성 프로그램 수 (기본 %d)\n"
+            "  --lanes=N      배치 검사의 레인 수 (기본 %d)\n"
+            "  --ips=N        초당 명령어 수, 프레임당 명령어 = N / 60 (기본 %u)\n"
+            "  --seed=N       생성 프로그램/키 입력/레인 시드\n"
+            "  --rom-dir=DIR  ROM을 지정하지 않았을 때 실행할 *.ch8 디렉터리 (기본 %s)\n",
+            prog, DEFAULT_FRAMES, DEFAULT_PROGRAMS, DEFAULT_LANES, DEFAULT_IPS, CHIP8_DIFFTEST_ROM_DIR);
+}
+
+static int parse_args(int argc, char *argv[], struct difftest_config *config) {
+    enum { OPT_FRAMES = 0x100, OPT_PROGRAMS, OPT_LANES, OPT_IPS, OPT_SEED, OPT_ROM_DIR };
+    static const struct option long_options[] = {
+        {"frames", required_argument, NULL, OPT_FRAMES},
+        {"programs", required_argument, NULL, OPT_PROGRAMS},
+        {"lanes", required_argument, NULL, OPT_LANES},
+        {"ips", required_argument, NULL, OPT_IPS},
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"rom-dir", required_argument, NULL, OPT_ROM_DIR},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    uint64_t value;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case OPT_FRAMES:
+                if (!parse_u64(optarg, 1, MAX_FRAMES, &value)) {
+                    fprintf(stderr, "Invalid --frames: %s\n", optarg);
+                    return -1;
+                }
+                config->frames = (uint32_t) value;
+                break;
+            case OPT_PROGRAMS:
+                if (!parse_u64(optarg, 0, MAX_PROGRAMS, &value)) {
+                    fprintf(stderr, "Invalid --programs: %s\n", optarg);
+                    return -1;
+                }
+                config->programs = (uint32_t) value;
+                break;
+            case OPT_LANES:
+                if (!parse_u64(optarg, 1, CHIP8_BATCH_MAX_LANES, &value)) {
+                    fprintf(stderr, "Invalid --lanes: %s\n", optarg);
+                    return -1;
+                }
+                config->lanes = (uint32_t) value;
+                break;
+            case OPT_IPS:
+                if (!parse_u64(optarg, 1, CHIP8_MAX_IPS, &value)) {
+                    fprintf(stderr, "Invalid --ips: %s\n", optarg);
+                    return -1;
+                }
+                config->ips = (uint32_t) value;
+                break;
+            case OPT_SEED: {
+                char *end;
+                errno = 0;
+                config->seed = strtoull(optarg, &end, 0);
+                if (errno != 0 || *end != '\0') {
+                    fprintf(stderr, "Invalid --seed: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            }
+            case OPT_ROM_DIR:
+                config->rom_dir = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+    return 1;
+}
+
+int main(int argc, char *argv[]) {
+    struct difftest_config config = {
+        .rom_dir = CHIP8_DIFFTEST_ROM_DIR,
+        .frames = DEFAULT_FRAMES,
+        .programs = DEFAULT_PROGRAMS,
+        .lanes = DEFAULT_LANES,
+        .ips = DEFAULT_IPS,
+        .seed = DEFAULT_SEED,
+    };
+    const int parsed = parse_args(argc, argv, &config);
+    if (parsed <= 0) {
+        return parsed < 0 ? 1 : 0;
+    }
+
+    /* 프로그램: ROM + 생성 프로그램 */
+    char *paths[MAX_ROMS];
+    int rom_count = 0;
+    bool owned_paths = false;
+    for (int n = optind; n < argc && rom_count < MAX_ROMS; n++) {
+        paths[rom_count++] = argv[n];
+    }
+    if (rom_count == 0) {
+        rom_count = list_roms(config.rom_dir, paths, MAX_ROMS);
+        owned_paths = true;
+        if (rom_count < 0) {
+            return 1;
+        }
+    }
+    const size_t program_count = (size_t) rom_count + config.programs;
+    struct difftest_program *programs = calloc(program_count, sizeof(*programs));
+    if (!programs) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int n = 0; n < rom_count; n++) {
+        if (!load_rom(paths[n], &programs[n])) {
+            return 1;
+        }
+    }
+    for (uint32_t n = 0; n < config.programs; n++) {
+        generate_program(&programs[(size_t) rom_count + n], n, config.seed);
+    }
+
+    struct chip8_pool *pool = chip8_pool_create();
+    if (!pool) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+#ifdef CHIP8_JIT
+    if (!jit_init()) {
+        fprintf(stderr, "Failed to initialize JIT\n");
+        return 1;
+    }
+#endif
+
+    struct difftest_result batch = {.name = "batch"};
+    struct difftest_result clone = {.name = "clone"};
+#ifdef CHIP8_JIT
+    struct difftest_result jit = {.name = "jit"};
+#endif
+    bool ok = true;
+    for (size_t n = 0; n < program_count && ok; n++) {
+        ok = check_batch(&config, &programs[n], &batch)
+             && check_clone(&config, &programs[n], pool, &clone);
+#ifdef CHIP8_JIT
+        ok = ok && check_jit(&config, &programs[n], &jit);
+#endif
+    }
+
+    const struct difftest_result *results[] = {
+        &batch,
+        &clone,
+#ifdef CHIP8_JIT
+        &jit,
+#endif
+    };
+    uint64_t mismatches = 0;
+    printf("%zu programs (%d ROMs, %" PRIu32 " generated), %" PRIu32 " frames, ips %" PRIu32 "\n",
+           program_count, rom_count, config.programs, config.frames, config.ips);
+    for (size_t n = 0; n < sizeof(results) / sizeof(results[0]); n++) {
+        const struct difftest_result *r = results[n];
+        printf("  %-6s %8" PRIu64 " runs %10" PRIu64 " frames %6" PRIu64 " stopped on error %6" PRIu64 " mismatches\n",
+               r->name, r->runs, r->frames, r->errors, r->mismatches);
+        mismatches += r->mismatches;
+    }
+
+#ifdef CHIP8_JIT
+    jit_shutdown();
+#endif
+    chip8_pool_destroy(pool);
+    free(programs);
+    for (int n = 0; owned_paths && n < rom_count; n++) {
+        free(paths[n]);
+    }
+    return ok && mismatches == 0 ? 0 : 1;
+}
@@ -11,7 +11,8 @@ typedef enum {
     ERR_NO_SUPPORTED_OPCODE,
     ERR_FILE_NOT_FOUND,
     ERR_ROM_TOO_LARGE,
-    ERR_THREAD_CREATION_FAILED
+    ERR_THREAD_CREATION_FAILED,
+    ERR_EVENT_LOOP_FAILED
 } errcode_t;
 
 #endif // ERRCODE_H
@@ -0,0 +1,949 @@
+/*
+ * chip8-farm: 여러 에뮬레이터 인스턴스를 한 프로세스에서 병렬 실행
+ *
+ * 인스턴스(libchip8 컨텍스트 + 키패드 + 입력 위치) N개를 work-stealing 스레드 풀(workpool.c)에 올리고,
+ * 작업 한 번에 인스턴스 하나를 한 프레임(ips / 60개 명령어 + 60Hz 타이머) 실행한 뒤 다시 큐에 넣는다.
+ * 대기(busy-wait) 없이 최대 속도로 실행하므로 세션마다 프로세스를 띄워 코어를 하나씩 잡을 필요가 없다.
+ *
+ * 입력은 c_chip_8 --replay와 같은 규칙으로 넣는다. (명령어 수 기준, 키패드 시각은 에뮬레이션 시각)
+ * 그래서 --replay로 같은 기록을 넣은 인스턴스는 c_chip_8 --headless --replay와 같은 상태로 끝나고,
+ * 스레드 수를 바꿔 여러 번 실행해도 인스턴스별 최종 상태 해시가 같아야 한다.
+ *
+ * --batch=K면 같은 ROM을 돌리는 인스턴스를 K개씩 배치 엔진(batch.c) 하나에 레인으로 묶고, 작업 한 번에 배치 하나를
+ * 한 프레임 실행한다. 입력 기록은 모든 인스턴스가 같으므로 프레임 안에서 입력 위치도 모든 레인이 같다.
+ * 레인별 결과는 chip8_ctx와 같으므로 상태 해시는 --batch 없이 실행한 것과 같아야 한다.
+ *
+ * 결과는 스레드 수별로 전체 명령어/초, 첫 실행 대비 배율, 프레임 지연(작업 한 번 실행 시간)과
+ * 프레임 간격(같은 인스턴스의 프레임 완료 사이 시간, 큐 대기 포함)의 분위수를 JSON으로 출력한다.
+ *
+ * 사용법: chip8-farm [options] [rom...]
+ *   ROM을 지정하지 않으면 --rom-dir의 *.ch8 전체, 인스턴스에 순서대로 돌아가며 배정
+ */
+#include <dirent.h>
+#include <errno.h>
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "batch.h"
+#include "keypad.h"
+#include "libchip8.h"
+#include "replay.h"
+#include "workpool.h"
+
+#ifndef CHIP8_FARM_ROM_DIR
+#define CHIP8_FARM_ROM_DIR "roms"
+#endif
+
+#define DEFAULT_INSTANCES 64
+#define DEFAULT_FRAMES 600 // 에뮬레이션 시간 10초
+#define DEFAULT_IPS 500U
+#define DEFAULT_SEED 0x0123456789ABCDEFULL
+#define SCRIPT_KEYS_PER_SECOND 10 // 생성하는 입력의 키 입력 빈도 (chip8-bench와 같음)
+#define KEY_HOLD_NS 100000000ULL  // c_chip_8의 INPUT_HOLD_NS와 같음
+#define ROM_MAX_SIZE (MEMORY_SIZE - PROGRAM_START_ADDR)
+#define MAX_ROMS 256
+#define MAX_INSTANCES 65536
+#define MAX_RUNS 16
+
+/*
+ * 지연 히스토그램: 2의 거듭제곱 구간마다 8칸 (상대 오차 12.5% 이하), 0..7ns는 1ns 단위
+ * 인스턴스마다 두 개씩 있어도 몇 KB라서 프레임마다 할당 없이 센다.
+ */
+#define LATENCY_SUB_BITS 3
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_BUCKETS (64 * LATENCY_SUB_COUNT)
+
+struct latency {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint64_t samples;
+    uint64_t max;
+};
+
+struct farm_rom {
+    const char *path;
+    const char *name;
+    uint8_t data[ROM_MAX_SIZE];
+    size_t size;
+};
+
+struct farm_config {
+    const char *rom_dir;
+    const char *replay_path; // NULL이면 입력 생성
+    const char *output_path; // NULL이면 stdout
+    unsigned threads[MAX_RUNS];
+    int run_count;
+    unsigned instances;
+    uint64_t frames;         // 인스턴스당 최대 프레임 수, 0이면 기록이 끝날 때까지
+    bool frames_set;
+    uint32_t ips;
+    uint64_t seed;
+    uint32_t batch;          // 배치 하나의 최대 레인 수, 0이면 인스턴스마다 chip8_ctx
+};
+
+// 인스턴스 하나 = 풀의 작업 하나, 캐시 라인 정렬 (키패드가 요구하고, 인스턴스끼리 라인을 나누지 않도록)
+struct farm_instance {
+    struct keypad keypad;
+    struct chip8_ctx *vm;        // --batch면 NULL (배치의 레인으로 실행)
+    const struct farm_rom *rom;
+    const struct replay *script; // 모든 인스턴스가 공유, 읽기만 함
+    size_t next_event;
+    uint64_t max_frames;         // 0이면 제한 없음
+
+    uint64_t instructions;
+    uint64_t frames;
+    errcode_t error;
+    uint64_t hash;               // 끝난 뒤 머신 상태 해시 (chip8_hash_machine())
+
+    uint64_t last_frame_end_ns;
+    struct latency frame_latency;  // 작업 한 번(한 프레임) 실행 시간
+    struct latency frame_interval; // 같은 인스턴스의 프레임 완료 사이 시간
+} __attribute__((aligned(WORKPOOL_CACHE_LINE)));
+
+// --batch: 같은 ROM 인스턴스 여러 개를 배치 엔진 하나로 실행, 풀의 작업 하나
+struct farm_batch {
+    struct chip8_batch *vm;
+    struct farm_instance **lanes; // 레인 n = lanes[n]
+    uint32_t count;
+    uint32_t live;                // 에러 나지 않은 레인 수
+} __attribute__((aligned(WORKPOOL_CACHE_LINE)));
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static unsigned latency_bucket(const uint64_t ns) {
+    if (ns < LATENCY_SUB_COUNT) {
+        return (unsigned) ns;
+    }
+    const int msb = 63 - __builtin_clzll(ns);
+    const unsigned sub = (unsigned) (ns >> (msb - LATENCY_SUB_BITS)) & (LATENCY_SUB_COUNT - 1);
+    return (unsigned) (msb - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT + sub;
+}
+
+// 구간에 속하는 가장 큰 값
+static uint64_t latency_bucket_upper(const unsigned bucket) {
+    if (bucket < LATENCY_SUB_COUNT) {
+        return bucket;
+    }
+    const int msb = (int) (bucket / LATENCY_SUB_COUNT) + LATENCY_SUB_BITS - 1;
+    const uint64_t sub = bucket % LATENCY_SUB_COUNT;
+    const int shift = msb - LATENCY_SUB_BITS;
+    return ((LATENCY_SUB_COUNT + sub + 1) << shift) - 1;
+}
+
+static void latency_add(struct latency *latency, const uint64_t ns) {
+    ++latency->counts[latency_bucket(ns)];
+    ++latency->samples;
+    if (ns > latency->max) {
+        latency->max = ns;
+    }
+}
+
+static void latency_merge(struct latency *into, const struct latency *from) {
+    for (int n = 0; n < LATENCY_BUCKETS; n++) {
+        into->counts[n] += from->counts[n];
+    }
+    into->samples += from->samples;
+    if (from->max > into->max) {
+        into->max = from->max;
+    }
+}
+
+// 분위수 (구간 상한, 최댓값을 넘지 않음)
+static uint64_t latency_percentile(const struct latency *latency, const double fraction) {
+    if (!latency->samples) {
+        return 0;
+    }
+    const uint64_t rank = (uint64_t) ((double) latency->samples * fraction);
+    uint64_t seen = 0;
+    for (unsigned n = 0; n < LATENCY_BUCKETS; n++) {
+        seen += latency->counts[n];
+        if (seen > rank) {
+            const uint64_t upper = latency_bucket_upper(n);
+            return upper < latency->max ? upper : latency->max;
+        }
+    }
+    return latency->max;
+}
+
+static inline uint64_t next_event_instruction(const struct farm_instance *inst) {
+    return inst->next_event < inst->script->count ? inst->script->events[inst->next_event].instruction
+                                                  : REPLAY_NO_END;
+}
+
+static void press_due_keys(struct farm_instance *inst, const uint64_t instruction, const uint64_t frame_ns) {
+    while (next_event_instruction(inst) <= instruction) {
+        keypad_press(&inst->keypad, inst->script->events[inst->next_event++].key, frame_ns);
+    }
+}
+
+static void sync_keys(struct farm_instance *inst) {
+    chip8_set_keys(inst->vm, keypad_down_mask(&inst->keypad), inst->keypad.fresh);
+}
+
+/*
+ * 한 프레임 실행, c_chip_8의 재생 프레임(execute_replay_frame)과 같은 순서
+ * 프레임 시작 위치까지의 입력 -> 키패드 프레임 시작 -> 프레임 중간 입력 위치마다 나눠 실행 -> 타이머
+ * 기록의 end가 프레임 중간이면 c_chip_8처럼 그 프레임은 세지 않고 타이머도 갱신하지 않음
+ * 마지막 프레임이면 false
+ */
+static bool emulate_frame(struct farm_instance *inst) {
+    const struct replay *script = inst->script;
+    const uint64_t frame_ns = inst->frames * CHIP8_FRAME_INTERVAL_NS;
+    const uint64_t start = inst->instructions;
+    const uint32_t frame_budget = chip8_frame_budget(inst->vm);
+    uint32_t budget = frame_budget;
+    bool last = false;
+
+    if (script->end != REPLAY_NO_END && script->end - start <= budget) {
+        budget = script->end > start ? (uint32_t) (script->end - start) : 0;
+        last = true;
+    }
+
+    press_due_keys(inst, start, frame_ns);
+    keypad_begin_frame(&inst->keypad, frame_ns);
+    sync_keys(inst);
+
+    uint32_t done = 0;
+    while (done < budget) {
+        const uint64_t now = start + done;
+        if (next_event_instruction(inst) <= now) {
+            press_due_keys(inst, now, frame_ns);
+            keypad_drain(&inst->keypad);
+            sync_keys(inst);
+        }
+
+        uint32_t count = budget - done;
+        const uint64_t next = next_event_instruction(inst);
+        if (next - now < count) {
+            count = (uint32_t) (next - now);
+        }
+        const errcode_t err = chip8_step(inst->vm, count);
+        if (err != ERR_NONE) {
+            inst->error = err;
+            return false;
+        }
+        done += count;
+    }
+    inst->instructions += budget;
+    if (budget < frame_budget) {
+        return false; // 기록의 end에서 끝난 프레임
+    }
+    ++inst->frames;
+    chip8_tick_timers(inst->vm);
+
+    return !last && (!inst->max_frames || inst->frames < inst->max_frames);
+}
+
+// 풀 작업: 프레임 하나 실행하고 지연 기록, 끝났으면 상태 해시를 남기고 false
+static bool run_instance_frame(void *task, void *arg) {
+    struct farm_instance *inst = task;
+    (void) arg;
+
+    const uint64_t begin = now_ns();
+    const bool more = emulate_frame(inst);
+    const uint64_t end = now_ns();
+
+    latency_add(&inst->frame_latency, end - begin);
+    if (inst->last_frame_end_ns) {
+        latency_add(&inst->frame_interval, end - inst->last_frame_end_ns);
+    }
+    inst->last_frame_end_ns = end;
+
+    if (!more) {
+        inst->hash = chip8_hash_machine(chip8_machine_const(inst->vm));
+    }
+    return more;
+}
+
+static void sync_lane_keys(struct farm_batch *batch, const uint32_t lane) {
+    struct farm_instance *inst = batch->lanes[lane];
+    chip8_batch_set_keys(batch->vm, lane, keypad_down_mask(&inst->keypad), inst->keypad.fresh);
+}
+
+// 에러 나지 않은 첫 레인, 모든 레인이 같은 기록을 같은 명령어 수만큼 실행하므로 입력 위치는 이 레인 기준
+static const struct farm_instance *lead_lane(const struct farm_batch *batch) {
+    for (uint32_t lane = 0; lane < batch->count; lane++) {
+        if (batch->lanes[lane]->error == ERR_NONE) {
+            return batch->lanes[lane];
+        }
+    }
+    return NULL;
+}
+
+/*
+ * 배치 한 프레임 실행, emulate_frame()과 같은 순서를 모든 레인에 적용
+ * 입력 위치에서 나눠 실행할 때마다 레인별 키 입력을 다시 넣는다. 에러 난 레인은 그 자리에서 멈춤
+ */
+static bool emulate_batch_frame(struct farm_batch *batch) {
+    const struct farm_instance *lead = lead_lane(batch);
+    const struct replay *script = lead->script;
+    const uint64_t frames = lead->frames + 1;
+    const uint64_t max_frames = lead->max_frames;
+    const uint64_t frame_ns = lead->frames * CHIP8_FRAME_INTERVAL_NS;
+    const uint64_t start = lead->instructions;
+    const uint32_t frame_budget = chip8_batch_frame_budget(batch->vm);
+    uint32_t budget = frame_budget;
+    bool last = false;
+
+    if (script->end != REPLAY_NO_END && script->end - start <= budget) {
+        budget = script->end > start ? (uint32_t) (script->end - start) : 0;
+        last = true;
+    }
+
+    for (uint32_t lane = 0; lane < batch->count; lane++) {
+        struct farm_instance *inst = batch->lanes[lane];
+        if (inst->error == ERR_NONE) {
+            press_due_keys(inst, start, frame_ns);
+            keypad_begin_frame(&inst->keypad, frame_ns);
+            sync_lane_keys(batch, lane);
+        }
+    }
+
+    uint32_t done = 0;
+    while (done < budget && batch->live > 0) {
+        lead = lead_lane(batch);
+        const uint64_t now = start + done;
+        if (next_event_instruction(lead) <= now) {
+            for (uint32_t lane = 0; lane < batch->count; lane++) {
+                struct farm_instance *inst = batch->lanes[lane];
+                if (inst->error == ERR_NONE) {
+                    press_due_keys(inst, now, frame_ns);
+                    keypad_drain(&inst->keypad);
+                    sync_lane_keys(batch, lane);
+                }
+            }
+        }
+
+        uint32_t count = budget - done;
+        const uint64_t next = next_event_instruction(lead);
+        if (next - now < count) {
+            count = (uint32_t) (next - now);
+        }
+        if (chip8_batch_step(batch->vm, count) != ERR_NONE) {
+            for (uint32_t lane = 0; lane < batch->count; lane++) {
+                struct farm_instance *inst = batch->lanes[lane];
+                const errcode_t err = chip8_batch_lane_error(batch->vm, lane);
+                if (inst->error == ERR_NONE && err != ERR_NONE) {
+                    inst->error = err;
+                    --batch->live;
+                }
+            }
+        }
+        done += count;
+    }
+    const bool partial = budget < frame_budget; // 기록의 end에서 끝난 프레임, emulate_frame()과 같이 세지 않음
+    for (uint32_t lane = 0; lane < batch->count; lane++) {
+        struct farm_instance *inst = batch->lanes[lane];
+        if (inst->error == ERR_NONE) {
+            inst->instructions += budget;
+            inst->frames += !partial;
+        }
+    }
+    if (!partial) {
+        chip8_batch_tick_timers(batch->vm);
+    }
+
+    return batch->live > 0 && !last && (!max_frames || frames < max_frames);
+}
+
+// 풀 작업: 배치 한 프레임 실행, 지연은 레인마다 같은 값으로 기록
+static bool run_batch_frame(void *task, void *arg) {
+    struct farm_batch *batch = task;
+    (void) arg;
+
+    const uint64_t begin = now_ns();
+    const bool more = emulate_batch_frame(batch);
+    const uint64_t end = now_ns();
+
+    for (uint32_t lane = 0; lane < batch->count; lane++) {
+        struct farm_instance *inst = batch->lanes[lane];
+        latency_add(&inst->frame_latency, end - begin);
+        if (inst->last_frame_end_ns) {
+            latency_add(&inst->frame_interval, end - inst->last_frame_end_ns);
+        }
+        inst->last_frame_end_ns = end;
+    }
+
+    if (!more) {
+        struct chip8_state state;
+        for (uint32_t lane = 0; lane < batch->count; lane++) {
+            chip8_batch_get_state(batch->vm, lane, &state);
+            batch->lanes[lane]->hash = chip8_hash_machine(&state.chip);
+        }
+    }
+    return more;
+}
+
+static bool parse_u64(const char *arg, const uint64_t min, const uint64_t max, uint64_t *value) {
+    char *end;
+    errno = 0;
+    const unsigned long long parsed = strtoull(arg, &end, 10);
+    if (errno != 0 || *end != '\0' || parsed < min || parsed > max) {
+        return false;
+    }
+    *value = parsed;
+    return true;
+}
+
+// "1,2,4,8" 형식의 스레드 수 목록
+static bool parse_threads(const char *arg, struct farm_config *config) {
+    config->run_count = 0;
+    const char *p = arg;
+    while (*p) {
+        char *end;
+        errno = 0;
+        const unsigned long value = strtoul(p, &end, 10);
+        if (errno != 0 || end == p || value == 0 || value > WORKPOOL_MAX_THREADS
+            || config->run_count == MAX_RUNS || (*end != ',' && *end != '\0')) {
+            return false;
+        }
+        config->threads[config->run_count++] = (unsigned) value;
+        p = *end == ',' ? end + 1 : end;
+    }
+    return config->run_count > 0;
+}
+
+static bool has_suffix(const char *name, const char *suffix) {
+    const size_t len = strlen(name);
+    const size_t suffix_len = strlen(suffix);
+    return len >= suffix_len && strcmp(name + len - suffix_len, suffix) == 0;
+}
+
+static int compare_string(const void *a, const void *b) {
+    return strcmp(*(char *const *) a, *(char *const *) b);
+}
+
+// dir의 *.ch8 경로를 이름순으로, 개수 반환 (에러면 -1)
+static int list_roms(const char *dir, char **paths, const int max) {
+    DIR *d = opendir(dir);
+    if (!d) {
+        fprintf(stderr, "Failed to open ROM directory %s: %s\n", dir, strerror(errno));
+        return -1;
+    }
+    int count = 0;
+    const struct dirent *entry;
+    while ((entry = readdir(d)) != NULL && count < max) {
+        if (entry->d_name[0] == '.' || !has_suffix(entry->d_name, ".ch8")) {
+            continue;
+        }
+        const size_t size = strlen(dir) + strlen(entry->d_name) + 2;
+        paths[count] = malloc(size);
+        if (!paths[count]) {
+            break;
+        }
+        snprintf(paths[count], size, "%s/%s", dir, entry->d_name);
+        ++count;
+    }
+    closedir(d);
+    qsort(paths, (size_t) count, sizeof(*paths), compare_string);
+    return count;
+}
+
+static bool load_rom(const char *path, struct farm_rom *rom) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Failed to open ROM %s: %s\n", path, strerror(errno));
+        return false;
+    }
+    rom->path = path;
+    rom->name = strrchr(path, '/') ? strrchr(path, '/') + 1 : path;
+    rom->size = fread(rom->data, 1, sizeof(rom->data), fp);
+    const bool too_large = fgetc(fp) != EOF;
+    const bool failed = ferror(fp) != 0;
+    fclose(fp);
+    if (too_large || failed) {
+        fprintf(stderr, "%s: %s\n", path, too_large ? "ROM too large" : "read failed");
+        return false;
+    }
+    return true;
+}
+
+// 생성 입력: 에뮬레이션 시간 1초에 SCRIPT_KEYS_PER_SECOND번 키를 0~F 순서로 누름 (chip8-bench 스크립트와 같은 패턴)
+static bool generate_script(struct replay *script, const uint32_t ips, const uint64_t frames, const uint64_t seed) {
+    memset(script, 0, sizeof(*script));
+    script->mode = REPLAY_PLAY;
+    script->ips = ips;
+    script->seed = seed;
+    script->end = REPLAY_NO_END;
+
+    // 프레임마다 ips / 60 (+ 나머지 이월)이므로 전체 명령어 수는 frames * ips / 60 이하
+    const uint64_t instructions = frames * ips / CHIP8_FRAMES_PER_SECOND + 1;
+    uint64_t step = ips / SCRIPT_KEYS_PER_SECOND;
+    if (step == 0) {
+        step = 1;
+    }
+    script->count = (size_t) (instructions / step);
+    script->events = malloc((script->count ? script->count : 1) * sizeof(*script->events));
+    if (!script->events) {
+        return false;
+    }
+    for (size_t n = 0; n < script->count; n++) {
+        script->events[n].instruction = (n + 1) * step;
+        script->events[n].key = (uint8_t) (n & 0xF);
+    }
+    return true;
+}
+
+static void print_json_string(FILE *out, const char *text) {
+    fputc('"', out);
+    for (const unsigned char *p = (const unsigned char *) text; *p; p++) {
+        if (*p == '"' || *p == '\\') {
+            fprintf(out, "\\%c", *p);
+        } else if (*p < 0x20) {
+            fprintf(out, "\\u%04X", *p);
+        } else {
+            fputc(*p, out);
+        }
+    }
+    fputc('"', out);
+}
+
+static void print_latency(FILE *out, const char *name, const struct latency *latency) {
+    fprintf(out, "\"%s\": {\"p50\": %" PRIu64 ", \"p99\": %" PRIu64 ", \"max\": %" PRIu64 "}", name,
+            latency_percentile(latency, 0.50), latency_percentile(latency, 0.99), latency->max);
+}
+
+static void destroy_instances(struct farm_instance *instances, const unsigned count) {
+    for (unsigned n = 0; n < count; n++) {
+        chip8_destroy(instances[n].vm);
+    }
+    free(instances);
+}
+
+// 기록을 재생하면 c_chip_8과 같도록 기록의 시드 그대로, 생성 입력이면 인스턴스마다 다른 시드
+static uint64_t instance_seed(const struct farm_config *config, const struct replay *script, const unsigned n) {
+    return config->replay_path ? script->seed : script->seed ^ ((n + 1) * 0xD1B54A32D192ED03ULL);
+}
+
+// 인스턴스 count개 생성, n번 인스턴스는 roms[n % rom_count], --batch면 컨텍스트는 만들지 않음
+static struct farm_instance *create_instances(const struct farm_config *config, const struct replay *script,
+                                              const struct farm_rom *roms, const int rom_count) {
+    void *memory = NULL;
+    if (posix_memalign(&memory, WORKPOOL_CACHE_LINE, config->instances * sizeof(struct farm_instance)) != 0) {
+        return NULL;
+    }
+    struct farm_instance *instances = memory;
+    memset(instances, 0, config->instances * sizeof(*instances));
+
+    for (unsigned n = 0; n < config->instances; n++) {
+        struct farm_instance *inst = &instances[n];
+        inst->rom = &roms[n % (unsigned) rom_count];
+        inst->script = script;
+        inst->max_frames = config->frames;
+        keypad_init(&inst->keypad, KEY_HOLD_NS);
+        if (config->batch) {
+            continue;
+        }
+
+        const struct chip8_config vm_config = {
+            .ips = script->ips,
+            .clip_sprites = script->clip_sprites,
+            .seed = instance_seed(config, script, n)
+        };
+        inst->vm = chip8_create(&vm_config);
+        if (!inst->vm || chip8_load_rom_mem(inst->vm, inst->rom->data, inst->rom->size) != ERR_NONE) {
+            destroy_instances(instances, n + 1);
+            return NULL;
+        }
+    }
+    return instances;
+}
+
+static void destroy_batches(struct farm_batch *batches, const unsigned count) {
+    for (unsigned n = 0; n < count; n++) {
+        chip8_batch_destroy(batches[n].vm);
+        free(batches[n].lanes);
+    }
+    free(batches);
+}
+
+// 같은 ROM 인스턴스(n, n + rom_count, ...)를 config->batch개씩 배치로 묶음, 배치 수는 *count
+static struct farm_batch *create_batches(const struct farm_config *config, const struct replay *script,
+                                         struct farm_instance *instances, const int rom_count, unsigned *count) {
+    const unsigned roms = (unsigned) rom_count < config->instances ? (unsigned) rom_count : config->instances;
+    unsigned total = 0;
+    for (unsigned r = 0; r < roms; r++) {
+        const unsigned members = (config->instances - r + roms - 1) / roms;
+        total += (members + config->batch - 1) / config->batch;
+    }
+
+    void *memory = NULL;
+    if (posix_memalign(&memory, WORKPOOL_CACHE_LINE, total * sizeof(struct farm_batch)) != 0) {
+        return NULL;
+    }
+    struct farm_batch *batches = memory;
+    memset(batches, 0, total * sizeof(*batches));
+
+    const struct chip8_config vm_config = {.ips = script->ips, .clip_sprites = script->clip_sprites, .seed = script->seed};
+    uint64_t *seeds = malloc(config->batch * sizeof(*seeds));
+    unsigned made = 0;
+    for (unsigned r = 0; r < roms && seeds; r++) {
+        for (unsigned first = r; first < config->instances; first += config->batch * roms) {
+            struct farm_batch *batch = &batches[made++];
+            for (unsigned n = first; n < config->instances && batch->count < config->batch; n += roms) {
+                ++batch->count;
+            }
+            batch->live = batch->count;
+            batch->lanes = malloc(batch->count * sizeof(*batch->lanes));
+            batch->vm = chip8_batch_create(&vm_config, batch->count);
+            if (!batch->lanes || !batch->vm) {
+                destroy_batches(batches, made);
+                free(seeds);
+                return NULL;
+            }
+            for (uint32_t lane = 0; lane < batch->count; lane++) {
+                const unsigned n = first + lane * roms;
+                batch->lanes[lane] = &instances[n];
+                seeds[lane] = instance_seed(config, script, n);
+            }
+            const struct farm_rom *rom = batch->lanes[0]->rom;
+            if (chip8_batch_load_rom_mem(batch->vm, rom->data, rom->size, seeds) != ERR_NONE) {
+                destroy_batches(batches, made);
+                free(seeds);
+                return NULL;
+            }
+        }
+    }
+    free(seeds);
+    if (made != total) {
+        destroy_batches(batches, made);
+        return NULL;
+    }
+    *count = total;
+    return batches;
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [rom...]\n"
+            "  --threads=N[,N...]  워커 스레드 수, 여러 개면 각각 실행해서 비교 (기본: 온라인 코어 수)\n"
+            "  --instances=N       인스턴스 수, ROM은 순서대로 돌아가며 배정 (기본 %d)\n"
+            "  --frames=N          인스턴스당 실행할 프레임 수, 0이면 기록이 끝날 때까지 (기본 %d)\n"
+            "  --ips=N             초당 명령어 수, 프레임당 명령어 = N / 60 (기본 %u)\n"
+            "  --seed=N            생성 입력의 난수 시드, 인스턴스마다 다르게 섞음\n"
+            "  --replay=FILE       모든 인스턴스에 넣을 입력 기록 (--record 형식, ips/클리핑/시드는 파일을 따름)\n"
+            "                      기록에 end가 있으면 --frames를 지정하지 않았을 때 거기까지 실행\n"
+            "  --batch=K           같은 ROM 인스턴스를 K개씩 배치 엔진 하나로 실행 (SIMD, 기본 0 = 인스턴스마다 따로)\n"
+            "  --rom-dir=DIR       ROM을 지정하지 않았을 때 실행할 *.ch8 디렉터리 (기본 %s)\n"
+            "  --output=FILE       JSON 결과 파일 (기본 stdout)\n",
+            prog, DEFAULT_INSTANCES, DEFAULT_FRAMES, DEFAULT_IPS, CHIP8_FARM_ROM_DIR);
+}
+
+static int parse_args(int argc, char *argv[], struct farm_config *config) {
+    enum { OPT_THREADS = 0x100, OPT_INSTANCES, OPT_FRAMES, OPT_IPS, OPT_SEED, OPT_REPLAY, OPT_BATCH, OPT_ROM_DIR,
+        OPT_OUTPUT };
+    static const struct option long_options[] = {
+        {"threads", required_argument, NULL, OPT_THREADS},
+        {"instances", required_argument, NULL, OPT_INSTANCES},
+        {"frames", required_argument, NULL, OPT_FRAMES},
+        {"ips", required_argument, NULL, OPT_IPS},
+        {"seed", required_argument, NULL, OPT_SEED},
+        {"replay", required_argument, NULL, OPT_REPLAY},
+        {"batch", required_argument, NULL, OPT_BATCH},
+        {"rom-dir", required_argument, NULL, OPT_ROM_DIR},
+        {"output", required_argument, NULL, OPT_OUTPUT},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    uint64_t value;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case OPT_THREADS:
+                if (!parse_threads(optarg, config)) {
+                    fprintf(stderr, "Invalid --threads: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            case OPT_INSTANCES:
+                if (!parse_u64(optarg, 1, MAX_INSTANCES, &value)) {
+                    fprintf(stderr, "Invalid --instances: %s\n", optarg);
+                    return -1;
+                }
+                config->instances = (unsigned) value;
+                break;
+            case OPT_FRAMES:
+                if (!parse_u64(optarg, 0, UINT32_MAX, &config->frames)) {
+                    fprintf(stderr, "Invalid --frames: %s\n", optarg);
+                    return -1;
+                }
+                config->frames_set = true;
+                break;
+            case OPT_IPS:
+                if (!parse_u64(optarg, 1, CHIP8_MAX_IPS, &value)) {
+                    fprintf(stderr, "Invalid --ips: %s\n", optarg);
+                    return -1;
+                }
+                config->ips = (uint32_t) value;
+                break;
+            case OPT_SEED: {
+                char *end;
+                errno = 0;
+                config->seed = strtoull(optarg, &end, 0);
+                if (errno != 0 || *end != '\0') {
+                    fprintf(stderr, "Invalid --seed: %s\n", optarg);
+                    return -1;
+                }
+                break;
+            }
+            case OPT_REPLAY:
+                config->replay_path = optarg;
+                break;
+            case OPT_BATCH:
+                if (!parse_u64(optarg, 0, CHIP8_BATCH_MAX_LANES, &value)) {
+                    fprintf(stderr, "Invalid --batch: %s\n", optarg);
+                    return -1;
+                }
+                config->batch = (uint32_t) value;
+                break;
+            case OPT_ROM_DIR:
+                config->rom_dir = optarg;
+                break;
+            case OPT_OUTPUT:
+                config->output_path = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                exit(0);
+            default:
+                print_usage(argv[0]);
+                return -1;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    struct farm_config config = {
+        .rom_dir = CHIP8_FARM_ROM_DIR,
+        .replay_path = NULL,
+        .output_path = NULL,
+        .run_count = 0,
+        .instances = DEFAULT_INSTANCES,
+        .frames = DEFAULT_FRAMES,
+        .frames_set = false,
+        .ips = DEFAULT_IPS,
+        .seed = DEFAULT_SEED,
+        .batch = 0
+    };
+    if (parse_args(argc, argv, &config) < 0) {
+        return 1;
+    }
+    if (config.run_count == 0) {
+        const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        config.threads[0] = cpus < 1 ? 1 : cpus > WORKPOOL_MAX_THREADS ? WORKPOOL_MAX_THREADS : (unsigned) cpus;
+        config.run_count = 1;
+    }
+
+    /* 입력 */
+    struct replay script;
+    if (config.replay_path) {
+        if (replay_load(&script, config.replay_path) != ERR_NONE) {
+            return 1;
+        }
+        if (!config.frames_set && script.end != REPLAY_NO_END) {
+            config.frames = 0;
+        }
+    } else if (config.frames != 0 && !generate_script(&script, config.ips, config.frames, config.seed)) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    if (config.frames == 0 && (!config.replay_path || script.end == REPLAY_NO_END)) {
+        fprintf(stderr, "--frames=0 needs a recording with an end line\n");
+        if (config.replay_path) {
+            free(script.events);
+        }
+        return 1;
+    }
+
+    /* ROM */
+    char *paths[MAX_ROMS];
+    int rom_count = 0;
+    bool owned_paths = false;
+    for (int n = optind; n < argc && rom_count < MAX_ROMS; n++) {
+        paths[rom_count++] = argv[n];
+    }
+    if (rom_count == 0) {
+        rom_count = list_roms(config.rom_dir, paths, MAX_ROMS);
+        owned_paths = true;
+        if (rom_count <= 0) {
+            fprintf(stderr, "No ROMs to run\n");
+            return 1;
+        }
+    }
+    struct farm_rom *roms = calloc((size_t) rom_count, sizeof(*roms));
+    if (!roms) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+    for (int n = 0; n < rom_count; n++) {
+        if (!load_rom(paths[n], &roms[n])) {
+            return 1;
+        }
+    }
+
+    FILE *out = stdout;
+    if (config.output_path) {
+        out = fopen(config.output_path, "w");
+        if (!out) {
+            fprintf(stderr, "Failed to open %s: %s\n", config.output_path, strerror(errno));
+            return 1;
+        }
+    }
+
+    fprintf(out, "{\n  \"instances\": %u,\n  \"frames\": %" PRIu64 ",\n  \"ips\": %" PRIu32 ",\n  \"batch\": %" PRIu32
+            ",\n  \"input\": ", config.instances, config.frames, script.ips, config.batch);
+    print_json_string(out, config.replay_path ? config.replay_path : "generated");
+    fprintf(out, ",\n  \"roms\": [");
+    for (int n = 0; n < rom_count; n++) {
+        fprintf(out, "%s", n ? ", " : "");
+        print_json_string(out, roms[n].name);
+    }
+    fprintf(out, "],\n  \"runs\": [\n");
+
+    // 첫 실행의 인스턴스별 상태 해시, 이후 실행과 비교
+    uint64_t *hashes = malloc(config.instances * sizeof(*hashes));
+    struct latency *total_latency = malloc(sizeof(*total_latency));
+    struct latency *total_interval = malloc(sizeof(*total_interval));
+    void **tasks = malloc(config.instances * sizeof(*tasks));
+    if (!hashes || !total_latency || !total_interval || !tasks) {
+        fprintf(stderr, "Out of memory\n");
+        return 1;
+    }
+
+    bool deterministic = true;
+    int failures = 0;
+    double first_rate = 0;
+    for (int r = 0; r < config.run_count; r++) {
+        const unsigned threads = config.threads[r];
+        struct farm_instance *instances = create_instances(&config, &script, roms, rom_count);
+        struct workpool_worker_stats *stats = calloc(threads, sizeof(*stats));
+        struct farm_batch *batches = NULL;
+        unsigned task_count = config.instances;
+        if (instances && config.batch) {
+            batches = create_batches(&config, &script, instances, rom_count, &task_count);
+        }
+        if (!instances || !stats || (config.batch && !batches)) {
+            fprintf(stderr, "Failed to create %u instances\n", config.instances);
+            return 1;
+        }
+        for (unsigned n = 0; n < task_count; n++) {
+            tasks[n] = batches ? (void *) &batches[n] : (void *) &instances[n];
+        }
+
+        const uint64_t start = now_ns();
+        const errcode_t err = workpool_run(tasks, task_count, threads, batches ? run_batch_frame : run_instance_frame,
+                                           NULL, stats);
+        const uint64_t elapsed_ns = now_ns() - start;
+        if (err != ERR_NONE) {
+            fprintf(stderr, "Worker pool failed with %u threads (error %d)\n", threads, err);
+            return 1;
+        }
+
+        uint64_t instructions = 0;
+        uint64_t frames = 0;
+        unsigned errors = 0;
+        memset(total_latency, 0, sizeof(*total_latency));
+        memset(total_interval, 0, sizeof(*total_interval));
+        for (unsigned n = 0; n < config.instances; n++) {
+            const struct farm_instance *inst = &instances[n];
+            instructions += inst->instructions;
+            frames += inst->frames;
+            errors += inst->error != ERR_NONE;
+            latency_merge(total_latency, &inst->frame_latency);
+            latency_merge(total_interval, &inst->frame_interval);
+            if (r == 0) {
+                hashes[n] = inst->hash;
+            } else if (hashes[n] != inst->hash) {
+                deterministic = false;
+            }
+        }
+        uint64_t steals = 0;
+        uint64_t failed_steals = 0;
+        for (unsigned n = 0; n < threads; n++) {
+            steals += stats[n].steals;
+            failed_steals += stats[n].failed_steals;
+        }
+        // 배치 엔진에서 그룹(pc가 같은 레인 묶음) 하나가 명령어 하나를 실행할 때 평균 레인 수
+        struct chip8_batch_stats total_batch = {0, 0, 0};
+        for (unsigned n = 0; batches && n < task_count; n++) {
+            struct chip8_batch_stats batch_stats;
+            chip8_batch_get_stats(batches[n].vm, &batch_stats);
+            total_batch.instructions += batch_stats.instructions;
+            total_batch.group_steps += batch_stats.group_steps;
+        }
+        const double group_width = total_batch.group_steps
+                ? (double) total_batch.instructions / (double) total_batch.group_steps : 1.0;
+        const double rate = (double) instructions / ((double) elapsed_ns / 1e9);
+        if (r == 0) {
+            first_rate = rate;
+        }
+
+        fprintf(out, "    {\n      \"threads\": %u,\n      \"elapsed_ns\": %" PRIu64 ",\n", threads, elapsed_ns);
+        fprintf(out, "      \"instructions\": %" PRIu64 ",\n      \"frames\": %" PRIu64 ",\n", instructions, frames);
+        fprintf(out, "      \"instructions_per_second\": %.0f,\n      \"speedup\": %.3f,\n", rate,
+                first_rate > 0 ? rate / first_rate : 0.0);
+        fprintf(out, "      \"steals\": %" PRIu64 ",\n      \"failed_steals\": %" PRIu64 ",\n", steals, failed_steals);
+        fprintf(out, "      \"tasks\": %u,\n      \"group_width\": %.2f,\n", task_count, group_width);
+        fprintf(out, "      \"errors\": %u,\n      ", errors);
+        print_latency(out, "frame_ns", total_latency);
+        fprintf(out, ",\n      ");
+        print_latency(out, "frame_interval_ns", total_interval);
+        fprintf(out, ",\n      \"per_instance\": [\n");
+        for (unsigned n = 0; n < config.instances; n++) {
+            const struct farm_instance *inst = &instances[n];
+            fprintf(out, "        {\"id\": %u, \"rom\": ", n);
+            print_json_string(out, inst->rom->name);
+            fprintf(out, ", \"instructions\": %" PRIu64 ", \"frames\": %" PRIu64 ", \"error\": %d, "
+                    "\"state_hash\": \"0x%016" PRIX64 "\", ", inst->instructions, inst->frames, inst->error, inst->hash);
+            print_latency(out, "frame_ns", &inst->frame_latency);
+            fprintf(out, ", ");
+            print_latency(out, "frame_interval_ns", &inst->frame_interval);
+            fprintf(out, "}%s\n", n + 1 < config.instances ? "," : "");
+        }
+        fprintf(out, "      ]\n    }%s\n", r + 1 < config.run_count ? "," : "");
+
+        // 진행 상황은 stderr로 (JSON 출력과 섞이지 않도록)
+        fprintf(stderr, "threads %u: %.1f M instructions/s (x%.2f), frame p99 %" PRIu64 " ns, %" PRIu64
+                " steals%s\n", threads, rate / 1e6, first_rate > 0 ? rate / first_rate : 0.0,
+                latency_percentile(total_latency, 0.99), steals, errors ? ", errors" : "");
+        failures += errors != 0;
+
+        free(stats);
+        if (batches) {
+            destroy_batches(batches, task_count);
+        }
+        destroy_instances(instances, config.instances);
+    }
+    fprintf(out, "  ],\n  \"deterministic\": %s\n}\n", deterministic ? "true" : "false");
+    if (!deterministic) {
+        fprintf(stderr, "State hashes differ between runs\n");
+    }
+
+    if (out != stdout) {
+        fclose(out);
+    }
+    free(tasks);
+    free(total_interval);
+    free(total_latency);
+    free(hashes);
+    free(roms);
+    free(script.events);
+    if (owned_paths) {
+        for (int n = 0; n < rom_count; n++) {
+            free(paths[n]);
+        }
+    }
+    return failures || !deterministic ? 1 : 0;
+}
@@ -0,0 +1,180 @@
+#include <fcntl.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "flight.h"
+#include "opcodes.h"
+
+/*
+ * 덤프 출력 버퍼
+ * 시그널 핸들러에서도 쓰므로 stdio/snprintf 대신 직접 숫자를 포맷하고 write()로 내보낸다.
+ */
+struct dump_buf {
+    int fd;
+    size_t len;
+    char data[4096];
+};
+
+static void buf_flush(struct dump_buf *buf) {
+    size_t off = 0;
+    while (off < buf->len) {
+        const ssize_t n = write(buf->fd, buf->data + off, buf->len - off);
+        if (n <= 0) {
+            break; // 덤프 실패는 무시 (이미 죽어가는 중)
+        }
+        off += (size_t) n;
+    }
+    buf->len = 0;
+}
+
+static void buf_str(struct dump_buf *buf, const char *str) {
+    for (; *str; str++) {
+        if (buf->len == sizeof(buf->data)) {
+            buf_flush(buf);
+        }
+        buf->data[buf->len++] = *str;
+    }
+}
+
+// 고정 자릿수 16진수
+static void buf_hex(struct dump_buf *buf, const uint64_t value, const int digits) {
+    static const char hex[] = "0123456789ABCDEF";
+    char tmp[17];
+    for (int n = 0; n < digits; n++) {
+        tmp[n] = hex[(value >> (4 * (digits - 1 - n))) & 0xF];
+    }
+    tmp[digits] = '\0';
+    buf_str(buf, tmp);
+}
+
+static void buf_dec(struct dump_buf *buf, uint64_t value) {
+    char tmp[21];
+    int pos = sizeof(tmp) - 1;
+    tmp[pos] = '\0';
+    do {
+        tmp[--pos] = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value);
+    buf_str(buf, tmp + pos);
+}
+
+static void dump_registers(struct dump_buf *buf, const uint16_t pc, const uint16_t i, const uint8_t sp,
+                           const uint8_t delay_timer, const uint8_t sound_timer,
+                           const uint8_t *v, const uint16_t *stack) {
+    buf_str(buf, "  PC=");
+    buf_hex(buf, pc, 4);
+    buf_str(buf, " I=");
+    buf_hex(buf, i, 4);
+    buf_str(buf, " SP=");
+    buf_dec(buf, sp);
+    buf_str(buf, " DT=");
+    buf_hex(buf, delay_timer, 2);
+    buf_str(buf, " ST=");
+    buf_hex(buf, sound_timer, 2);
+    buf_str(buf, "\n  V0-VF:");
+    for (int n = 0; n < 16; n++) {
+        buf_str(buf, " ");
+        buf_hex(buf, v[n], 2);
+    }
+    buf_str(buf, "\n  stack:");
+    for (int n = 0; n < 16; n++) {
+        buf_str(buf, " ");
+        buf_hex(buf, stack[n], 3);
+    }
+    buf_str(buf, "\n");
+}
+
+void flight_init(struct flight_recorder *flight, const struct chip8 *chip, const char *path) {
+    memset(flight, 0, sizeof(*flight));
+    flight->chip = chip;
+    strncpy(flight->path, path, sizeof(flight->path) - 1);
+}
+
+void flight_dump(const struct flight_recorder *flight, const char *reason, const int code) {
+    struct dump_buf buf;
+    buf.len = 0;
+    buf.fd = open(flight->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (buf.fd < 0) {
+        return;
+    }
+
+    buf_str(&buf, "CHIP-8 flight recorder\nreason: ");
+    buf_str(&buf, reason);
+    buf_str(&buf, " (");
+    buf_dec(&buf, (uint64_t) code);
+    buf_str(&buf, ")\nrecorded entries: ");
+    buf_dec(&buf, flight->head);
+
+    const struct chip8 *chip = flight->chip;
+    buf_str(&buf, "\n\ncurrent state:\n");
+    dump_registers(&buf, chip->pc, chip->i, chip->sp, chip->delay_timer, chip->sound_timer, chip->v, chip->stack);
+
+    // 스냅샷, 오래된 것부터
+    buf_str(&buf, "\nframe start snapshots (oldest first, #n = entries recorded before it):\n");
+    const uint64_t snap_first = flight->snapshot_head > FLIGHT_SNAPSHOT_COUNT
+                                ? flight->snapshot_head - FLIGHT_SNAPSHOT_COUNT : 0;
+    for (uint64_t s = snap_first; s < flight->snapshot_head; s++) {
+        const struct flight_snapshot *snap = &flight->snapshots[s & (FLIGHT_SNAPSHOT_COUNT - 1)];
+        buf_str(&buf, "#");
+        buf_dec(&buf, snap->seq);
+        buf_str(&buf, "\n");
+        dump_registers(&buf, snap->pc, snap->i, snap->sp, snap->delay_timer, snap->sound_timer,
+                       snap->v, snap->stack);
+    }
+
+    // 명령어, 오래된 것부터. 마지막 항목이 종료 직전에 실행(시도)한 명령어
+    buf_str(&buf, "\nlast instructions (oldest first):\n");
+    const uint64_t first = flight->head > FLIGHT_RING_SIZE ? flight->head - FLIGHT_RING_SIZE : 0;
+    for (uint64_t e = first; e < flight->head; e++) {
+        const struct flight_entry *entry = &flight->entries[e & (FLIGHT_RING_SIZE - 1)];
+        buf_str(&buf, "#");
+        buf_dec(&buf, e);
+        buf_str(&buf, "  ");
+        buf_hex(&buf, entry->pc, 3);
+        buf_str(&buf, "  ");
+        buf_hex(&buf, entry->opcode, 4);
+        buf_str(&buf, "  I=");
+        buf_hex(&buf, entry->i, 3);
+        buf_str(&buf, "  ");
+        buf_str(&buf, chip8_op_name(chip8_decode_op(entry->opcode)));
+        if (entry->count > 1) {
+            buf_str(&buf, "  (JIT block, ");
+            buf_dec(&buf, entry->count);
+            buf_str(&buf, " instructions)");
+        }
+        buf_str(&buf, "\n");
+    }
+
+    buf_flush(&buf);
+    close(buf.fd);
+}
+
+static struct flight_recorder *signal_flight;
+
+// SIGSEGV가 스택 오버플로여도 덤프할 수 있도록 별도 스택에서 실행
+static char signal_stack[16384];
+
+static void handle_fatal_signal(const int sig) {
+    flight_dump(signal_flight, sig == SIGSEGV ? "SIGSEGV" : "SIGABRT", sig);
+    // SA_RESETHAND로 기본 동작이 복원됐으므로 다시 보내서 원래대로 종료
+    raise(sig);
+}
+
+void flight_install_signal_handlers(struct flight_recorder *flight) {
+    signal_flight = flight;
+
+    stack_t stack;
+    stack.ss_sp = signal_stack;
+    stack.ss_size = sizeof(signal_stack);
+    stack.ss_flags = 0;
+    sigaltstack(&stack, NULL);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = handle_fatal_signal;
+    action.sa_flags = SA_RESETHAND | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGABRT, &action, NULL);
+    sigaction(SIGSEGV, &action, NULL);
+}
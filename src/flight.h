@@ -0,0 +1,83 @@
+#ifndef FLIGHT_H
+#define FLIGHT_H
+
+#include <stdint.h>
+
+#include "chip8.h"
+
+/*
+ * 플라이트 레코더
+ * 마지막 FLIGHT_RING_SIZE개의 실행 명령어와 프레임 시작 시점의 레지스터 스냅샷을 메모리 링 버퍼에 항상 기록한다.
+ * 기록은 일반 store만 쓰고 (락, 원자적 연산, I/O 없음), 파일 출력은 에러 종료나 SIGABRT/SIGSEGV 때만 한다.
+ * 덤프는 시그널 핸들러에서도 호출되므로 async-signal-safe 함수(open/write/close)만 쓴다.
+ */
+
+#define FLIGHT_RING_SIZE      1024 // 2의 거듭제곱
+#define FLIGHT_SNAPSHOT_COUNT 8    // 2의 거듭제곱
+
+// 실행한 명령어 하나 (JIT 블록은 시작 주소 하나로 count개 명령어를 기록)
+struct flight_entry {
+    uint16_t pc;
+    uint16_t opcode;
+    uint16_t i;        // 실행 직전 I
+    uint16_t count;    // 이 항목이 나타내는 명령어 수
+};
+
+// 레지스터 스냅샷
+struct flight_snapshot {
+    uint64_t seq;      // 스냅샷 시점까지 기록된 항목 수
+    uint16_t pc;
+    uint16_t i;
+    uint16_t stack[16];
+    uint8_t v[16];
+    uint8_t sp;
+    uint8_t delay_timer;
+    uint8_t sound_timer;
+};
+
+struct flight_recorder {
+    struct flight_entry entries[FLIGHT_RING_SIZE];
+    struct flight_snapshot snapshots[FLIGHT_SNAPSHOT_COUNT];
+    uint64_t head;          // 지금까지 기록된 항목 수, 다음 항목 위치는 head % FLIGHT_RING_SIZE
+    uint64_t snapshot_head; // 지금까지 찍은 스냅샷 수
+    const struct chip8 *chip; // 덤프 시 현재 상태를 읽을 대상
+    char path[256];         // 덤프 파일 경로 (시그널 핸들러에서 포맷하지 않도록 미리 저장)
+};
+
+void flight_init(struct flight_recorder *flight, const struct chip8 *chip, const char *path);
+
+// SIGABRT/SIGSEGV가 오면 덤프하고 기본 동작(코어 덤프 등)으로 다시 종료
+void flight_install_signal_handlers(struct flight_recorder *flight);
+
+// 덤프 파일 작성, reason은 사람이 읽을 종료 원인, code는 에러 코드나 시그널 번호
+// async-signal-safe, 실패해도 아무것도 하지 않음
+void flight_dump(const struct flight_recorder *flight, const char *reason, int code);
+
+// seq번째 항목 기록, seq는 호출하는 쪽이 레지스터에 들고 있는 값 (flight->head를 읽지 않아 의존성이 생기지 않음)
+static inline void flight_record(struct flight_recorder *flight, const uint64_t seq, const uint16_t pc,
+                                 const uint16_t opcode, const uint16_t i, const uint16_t count) {
+    struct flight_entry *entry = &flight->entries[seq & (FLIGHT_RING_SIZE - 1)];
+    entry->pc = pc;
+    entry->opcode = opcode;
+    entry->i = i;
+    entry->count = count;
+    flight->head = seq + 1;
+}
+
+static inline void flight_snapshot(struct flight_recorder *flight) {
+    const struct chip8 *chip = flight->chip;
+    struct flight_snapshot *snap = &flight->snapshots[flight->snapshot_head & (FLIGHT_SNAPSHOT_COUNT - 1)];
+    snap->seq = flight->head;
+    snap->pc = chip->pc;
+    snap->i = chip->i;
+    for (int n = 0; n < 16; n++) {
+        snap->stack[n] = chip->stack[n];
+        snap->v[n] = chip->v[n];
+    }
+    snap->sp = chip->sp;
+    snap->delay_timer = chip->delay_timer;
+    snap->sound_timer = chip->sound_timer;
+    ++flight->snapshot_head;
+}
+
+#endif // FLIGHT_H
@@ -0,0 +1,692 @@
+#include <stddef.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "jit.h"
+#include "log.h"
+#include "opcodes.h"
+
+#define JIT_CODE_SIZE        (1 << 20) // 번역 코드 버퍼 1MB, 가득 차면 전체 폐기 후 다시 번역
+#define JIT_MAX_BLOCK_INSNS  64
+#define JIT_MAX_BLOCK_BYTES  2048      // 블록 하나가 차지할 수 있는 최대 코드 크기 (여유있게 잡음)
+
+/* x86-64 레지스터 번호 */
+enum {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15
+};
+
+#define REG_STATE RDI // struct chip8 * (System V 첫 번째 인자), 블록 안에서 계속 유지
+#define REG_TMP   RAX // 임시 레지스터, setcc 결과와 동적 pc 계산에 사용
+
+/* 조건 코드 (Jcc, SETcc 하위 니블) */
+#define CC_B  0x2 // carry
+#define CC_E  0x4
+#define CC_NE 0x5
+#define CC_A  0x7 // unsigned >
+
+/* V 레지스터와 I를 담아둘 host 레지스터 후보, 블록에서 쓰는 것만 차례대로 할당 */
+static const uint8_t host_regs[] = {
+    RCX, RDX, RSI, R8, R9, R10, R11,   // caller-saved
+    RBX, RBP, R12, R13, R14, R15       // callee-saved, 쓰면 push/pop
+};
+#define HOST_REG_COUNT ((int) sizeof(host_regs))
+
+#define OFF_V(x)    ((uint32_t) (offsetof(struct chip8, v) + (x)))
+#define OFF_I       ((uint32_t) offsetof(struct chip8, i))
+#define OFF_PC      ((uint32_t) offsetof(struct chip8, pc))
+#define OFF_SP      ((uint32_t) offsetof(struct chip8, sp))
+#define OFF_STACK   ((uint32_t) offsetof(struct chip8, stack))
+#define OFF_DT      ((uint32_t) offsetof(struct chip8, delay_timer))
+#define OFF_ST      ((uint32_t) offsetof(struct chip8, sound_timer))
+
+uint64_t jit_code_pages = 0;
+
+static uint8_t *code_buf = NULL;
+static size_t code_used = 0;
+static bool code_writable = false; // W^X: 번역할 때만 RW, 실행할 때는 RX
+static struct jit_block blocks[MEMORY_SIZE];
+
+/* 블록 번역 계획: 어떤 명령어를 몇 개, 어떤 레지스터로 번역할지 */
+struct block_plan {
+    struct chip8_insn insns[JIT_MAX_BLOCK_INSNS];
+    uint16_t start;
+    uint16_t count;
+    bool terminated;        // 마지막 명령어가 분기(점프/호출/복귀/스킵)인지
+    int8_t vreg[16];        // V 레지스터 -> host_regs 인덱스, -1은 미사용
+    int8_t ireg;            // I -> host_regs 인덱스, -1은 미사용
+    uint16_t v_dirty;       // 블록에서 값이 바뀌는 V 레지스터
+    bool i_dirty;
+    int used;               // 할당한 host 레지스터 수
+};
+
+enum insn_kind {
+    KIND_FALLBACK,   // 번역하지 않음, 블록은 이 명령어 직전에서 끝나고 인터프리터가 실행
+    KIND_STRAIGHT,   // 블록 중간에 올 수 있는 명령어
+    KIND_BRANCH      // 블록의 마지막 명령어
+};
+
+static enum insn_kind insn_kind(const struct chip8_insn *in, uint16_t *v_read, uint16_t *v_write,
+                                bool *i_read, bool *i_write) {
+    const uint16_t bx = (uint16_t) (1u << in->x);
+    const uint16_t by = (uint16_t) (1u << in->y);
+    const uint16_t bf = (uint16_t) (1u << 0xF);
+
+    *v_read = 0;
+    *v_write = 0;
+    *i_read = false;
+    *i_write = false;
+
+    switch (in->op) {
+        case CHIP8_OP_LD_VX_KK:
+        case CHIP8_OP_LD_VX_DT:
+            *v_write = bx;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_ADD_VX_KK:
+            *v_read = bx;
+            *v_write = bx;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_LD_VX_VY:
+            *v_read = by;
+            *v_write = bx;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_OR:
+        case CHIP8_OP_AND:
+        case CHIP8_OP_XOR:
+            *v_read = bx | by;
+            *v_write = bx;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_ADD_VX_VY:
+        case CHIP8_OP_SUB:
+        case CHIP8_OP_SUBN:
+            *v_read = bx | by;
+            *v_write = bx | bf;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_SHR:
+        case CHIP8_OP_SHL:
+            *v_read = bx;
+            *v_write = bx | bf;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_LD_DT_VX:
+        case CHIP8_OP_LD_ST_VX:
+            *v_read = bx;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_LD_I:
+            *i_write = true;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_ADD_I_VX:
+            *v_read = bx;
+            *i_read = true;
+            *i_write = true;
+            return KIND_STRAIGHT;
+        case CHIP8_OP_JP:
+        case CHIP8_OP_CALL:
+        case CHIP8_OP_RET:
+            return KIND_BRANCH;
+        case CHIP8_OP_JP_V0:
+            *v_read = 1;
+            return KIND_BRANCH;
+        case CHIP8_OP_SE_VX_KK:
+        case CHIP8_OP_SNE_VX_KK:
+            *v_read = bx;
+            return KIND_BRANCH;
+        case CHIP8_OP_SE_VX_VY:
+        case CHIP8_OP_SNE_VX_VY:
+            *v_read = bx | by;
+            return KIND_BRANCH;
+        default:
+            // CLS, SYS, RND, DRW, 키 입력, Fx29, Fx33, Fx55, Fx65
+            return KIND_FALLBACK;
+    }
+}
+
+static int popcount16(uint16_t v) {
+    int n = 0;
+    for (; v; v &= v - 1) {
+        ++n;
+    }
+    return n;
+}
+
+// pc부터 번역할 명령어와 레지스터 할당을 정함
+static void plan_block(const struct chip8 *chip, const uint16_t start, struct block_plan *plan) {
+    memset(plan, 0, sizeof(*plan));
+    memset(plan->vreg, -1, sizeof(plan->vreg));
+    plan->ireg = -1;
+    plan->start = start;
+
+    uint16_t used_v = 0;
+    uint16_t addr = start;
+    while (plan->count < JIT_MAX_BLOCK_INSNS && addr + 1 < MEMORY_SIZE) {
+        struct chip8_insn in;
+        chip8_decode_insn(&in, (uint16_t) ((chip->memory[addr] << 8) | chip->memory[addr + 1]));
+
+        uint16_t v_read, v_write;
+        bool i_read, i_write;
+        const enum insn_kind kind = insn_kind(&in, &v_read, &v_write, &i_read, &i_write);
+        if (kind == KIND_FALLBACK) {
+            break;
+        }
+
+        // host 레지스터가 모자라면 이 명령어 직전에서 블록을 끊음
+        const uint16_t new_v = (uint16_t) ((v_read | v_write) & ~used_v);
+        const bool new_i = (i_read || i_write) && plan->ireg < 0;
+        if (plan->used + popcount16(new_v) + (new_i ? 1 : 0) > HOST_REG_COUNT) {
+            break;
+        }
+        for (int v = 0; v < 16; ++v) {
+            if (new_v & (1u << v)) {
+                plan->vreg[v] = (int8_t) plan->used++;
+            }
+        }
+        if (new_i) {
+            plan->ireg = (int8_t) plan->used++;
+        }
+        used_v |= new_v;
+        plan->v_dirty |= v_write;
+        plan->i_dirty = plan->i_dirty || i_write;
+
+        plan->insns[plan->count++] = in;
+        addr += 2;
+
+        if (kind == KIND_BRANCH) {
+            plan->terminated = true;
+            break;
+        }
+    }
+}
+
+/*
+ * x86-64 코드 생성
+ * 바이트 연산은 항상 REX 접두사를 붙여 sil/dil/bpl, r8b-r15b를 모두 같은 방식으로 다룬다.
+ */
+struct emitter {
+    uint8_t *p;
+};
+
+static void emit_u8(struct emitter *e, const uint8_t b) {
+    *e->p++ = b;
+}
+
+static void emit_u16(struct emitter *e, const uint16_t v) {
+    memcpy(e->p, &v, sizeof(v)); // x86은 little-endian
+    e->p += sizeof(v);
+}
+
+static void emit_u32(struct emitter *e, const uint32_t v) {
+    memcpy(e->p, &v, sizeof(v));
+    e->p += sizeof(v);
+}
+
+static void emit_rex(struct emitter *e, const int w, const int reg, const int rm) {
+    emit_u8(e, (uint8_t) (0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3)));
+}
+
+static void emit_modrm_rr(struct emitter *e, const int reg, const int rm) {
+    emit_u8(e, (uint8_t) (0xC0 | ((reg & 7) << 3) | (rm & 7)));
+}
+
+// [rdi + disp32]
+static void emit_modrm_state(struct emitter *e, const int reg, const uint32_t disp) {
+    emit_u8(e, (uint8_t) (0x80 | ((reg & 7) << 3) | (REG_STATE & 7)));
+    emit_u32(e, disp);
+}
+
+// [rdi + rax * 2 + disp32], 스택 접근용
+static void emit_modrm_stack(struct emitter *e, const int reg) {
+    emit_u8(e, (uint8_t) (0x84 | ((reg & 7) << 3)));
+    emit_u8(e, (uint8_t) (0x40 | (RAX << 3) | (REG_STATE & 7)));
+    emit_u32(e, OFF_STACK);
+}
+
+// op r/m8, r8 (mov 0x88, add 0x00, or 0x08, and 0x20, sub 0x28, xor 0x30, cmp 0x38)
+static void emit_alu8_rr(struct emitter *e, const uint8_t opc, const int dst, const int src) {
+    emit_rex(e, 0, src, dst);
+    emit_u8(e, opc);
+    emit_modrm_rr(e, src, dst);
+}
+
+static void emit_mov8_ri(struct emitter *e, const int dst, const uint8_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, (uint8_t) (0xB0 + (dst & 7)));
+    emit_u8(e, imm);
+}
+
+// 0x80 /ext ib (add 0, cmp 7)
+static void emit_alu8_ri(struct emitter *e, const int ext, const int dst, const uint8_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, 0x80);
+    emit_modrm_rr(e, ext, dst);
+    emit_u8(e, imm);
+}
+
+// 0xD0 /ext (shl 4, shr 5), 1비트 shift
+static void emit_shift8(struct emitter *e, const int ext, const int dst) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, 0xD0);
+    emit_modrm_rr(e, ext, dst);
+}
+
+static void emit_neg8(struct emitter *e, const int dst) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, 0xF6);
+    emit_modrm_rr(e, 3, dst);
+}
+
+static void emit_setcc_tmp(struct emitter *e, const uint8_t cc) {
+    emit_u8(e, 0x0F);
+    emit_u8(e, (uint8_t) (0x90 | cc));
+    emit_modrm_rr(e, 0, REG_TMP);
+}
+
+static void emit_load8(struct emitter *e, const int dst, const uint32_t disp) {
+    emit_rex(e, 0, dst, REG_STATE);
+    emit_u8(e, 0x8A);
+    emit_modrm_state(e, dst, disp);
+}
+
+static void emit_store8(struct emitter *e, const uint32_t disp, const int src) {
+    emit_rex(e, 0, src, REG_STATE);
+    emit_u8(e, 0x88);
+    emit_modrm_state(e, src, disp);
+}
+
+// 0x80 /ext ib [rdi + disp32] (add 0, sub 5)
+static void emit_alu8_mi(struct emitter *e, const int ext, const uint32_t disp, const uint8_t imm) {
+    emit_u8(e, 0x80);
+    emit_modrm_state(e, ext, disp);
+    emit_u8(e, imm);
+}
+
+static void emit_movzx32_r8(struct emitter *e, const int dst, const int src) {
+    emit_rex(e, 0, dst, src);
+    emit_u8(e, 0x0F);
+    emit_u8(e, 0xB6);
+    emit_modrm_rr(e, dst, src);
+}
+
+static void emit_movzx32_m8(struct emitter *e, const int dst, const uint32_t disp) {
+    emit_rex(e, 0, dst, REG_STATE);
+    emit_u8(e, 0x0F);
+    emit_u8(e, 0xB6);
+    emit_modrm_state(e, dst, disp);
+}
+
+static void emit_movzx32_m16(struct emitter *e, const int dst, const uint32_t disp) {
+    emit_rex(e, 0, dst, REG_STATE);
+    emit_u8(e, 0x0F);
+    emit_u8(e, 0xB7);
+    emit_modrm_state(e, dst, disp);
+}
+
+static void emit_store16(struct emitter *e, const uint32_t disp, const int src) {
+    emit_u8(e, 0x66);
+    emit_rex(e, 0, src, REG_STATE);
+    emit_u8(e, 0x89);
+    emit_modrm_state(e, src, disp);
+}
+
+static void emit_store16_imm(struct emitter *e, const uint32_t disp, const uint16_t imm) {
+    emit_u8(e, 0x66);
+    emit_u8(e, 0xC7);
+    emit_modrm_state(e, 0, disp);
+    emit_u16(e, imm);
+}
+
+static void emit_mov32_ri(struct emitter *e, const int dst, const uint32_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, (uint8_t) (0xB8 + (dst & 7)));
+    emit_u32(e, imm);
+}
+
+static void emit_add32_rr(struct emitter *e, const int dst, const int src) {
+    emit_rex(e, 0, src, dst);
+    emit_u8(e, 0x01);
+    emit_modrm_rr(e, src, dst);
+}
+
+static void emit_add32_ri(struct emitter *e, const int dst, const uint32_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, 0x81);
+    emit_modrm_rr(e, 0, dst);
+    emit_u32(e, imm);
+}
+
+// 0x83 /4 ib, and r32, imm8
+static void emit_and32_ri8(struct emitter *e, const int dst, const uint8_t imm) {
+    emit_rex(e, 0, 0, dst);
+    emit_u8(e, 0x83);
+    emit_modrm_rr(e, 4, dst);
+    emit_u8(e, imm);
+}
+
+static void emit_push(struct emitter *e, const int reg) {
+    if (reg >= R8) {
+        emit_u8(e, 0x41);
+    }
+    emit_u8(e, (uint8_t) (0x50 + (reg & 7)));
+}
+
+static void emit_pop(struct emitter *e, const int reg) {
+    if (reg >= R8) {
+        emit_u8(e, 0x41);
+    }
+    emit_u8(e, (uint8_t) (0x58 + (reg & 7)));
+}
+
+static bool is_callee_saved(const int reg) {
+    return reg == RBX || reg == RBP || reg >= R12;
+}
+
+#define HV(x) (host_regs[plan->vreg[(x)]])
+
+// VF = 임시 레지스터(setcc 결과), x가 F면 연산 결과가 VF를 덮어쓰므로 생략
+static void emit_set_vf(struct emitter *e, const struct block_plan *plan, const uint8_t x) {
+    if (x != 0xF) {
+        emit_alu8_rr(e, 0x88, HV(0xF), REG_TMP);
+    }
+}
+
+// 분기 명령어: 다음 pc를 계산해서 REG_TMP에 넣음. 정적으로 정해지면 false
+static bool emit_branch(struct emitter *e, const struct block_plan *plan,
+                        const struct chip8_insn *in, const uint16_t next_pc, uint16_t *static_pc) {
+    switch (in->op) {
+        case CHIP8_OP_JP:
+            *static_pc = in->nnn;
+            return false;
+        case CHIP8_OP_CALL:
+            // ++sp; stack[sp & 0xF] = next_pc;
+            emit_alu8_mi(e, 0, OFF_SP, 1);
+            emit_movzx32_m8(e, RAX, OFF_SP);
+            emit_and32_ri8(e, RAX, 0xF);
+            emit_u8(e, 0x66);
+            emit_u8(e, 0xC7);
+            emit_modrm_stack(e, 0);
+            emit_u16(e, next_pc);
+            *static_pc = in->nnn;
+            return false;
+        case CHIP8_OP_RET:
+            // pc = stack[sp & 0xF]; --sp;
+            emit_movzx32_m8(e, RAX, OFF_SP);
+            emit_and32_ri8(e, RAX, 0xF);
+            emit_u8(e, 0x0F);
+            emit_u8(e, 0xB7);
+            emit_modrm_stack(e, RAX);
+            emit_alu8_mi(e, 5, OFF_SP, 1);
+            return true;
+        case CHIP8_OP_JP_V0:
+            emit_movzx32_r8(e, RAX, HV(0));
+            emit_add32_ri(e, RAX, in->nnn);
+            return true;
+        default:
+            break;
+    }
+
+    // 스킵: tmp = next_pc; 조건이 맞으면 tmp = next_pc + 2
+    emit_mov32_ri(e, REG_TMP, next_pc);
+    uint8_t no_skip_cc;
+    switch (in->op) {
+        case CHIP8_OP_SE_VX_KK:
+            emit_alu8_ri(e, 7, HV(in->x), in->kk);
+            no_skip_cc = CC_NE;
+            break;
+        case CHIP8_OP_SNE_VX_KK:
+            emit_alu8_ri(e, 7, HV(in->x), in->kk);
+            no_skip_cc = CC_E;
+            break;
+        case CHIP8_OP_SE_VX_VY:
+            emit_alu8_rr(e, 0x38, HV(in->x), HV(in->y));
+            no_skip_cc = CC_NE;
+            break;
+        default: // CHIP8_OP_SNE_VX_VY
+            emit_alu8_rr(e, 0x38, HV(in->x), HV(in->y));
+            no_skip_cc = CC_E;
+            break;
+    }
+    emit_u8(e, (uint8_t) (0x70 | no_skip_cc));
+    uint8_t *rel = e->p;
+    emit_u8(e, 0);
+    emit_mov32_ri(e, REG_TMP, (uint32_t) next_pc + 2);
+    *rel = (uint8_t) (e->p - (rel + 1)); // 바로 뒤 mov를 건너뛰는 거리
+    return true;
+}
+
+static void emit_straight(struct emitter *e, const struct block_plan *plan, const struct chip8_insn *in) {
+    const uint8_t x = in->x;
+    const uint8_t y = in->y;
+
+    switch (in->op) {
+        case CHIP8_OP_LD_VX_KK:
+            emit_mov8_ri(e, HV(x), in->kk);
+            break;
+        case CHIP8_OP_ADD_VX_KK:
+            emit_alu8_ri(e, 0, HV(x), in->kk);
+            break;
+        case CHIP8_OP_LD_VX_VY:
+            emit_alu8_rr(e, 0x88, HV(x), HV(y));
+            break;
+        case CHIP8_OP_OR:
+            emit_alu8_rr(e, 0x08, HV(x), HV(y));
+            break;
+        case CHIP8_OP_AND:
+            emit_alu8_rr(e, 0x20, HV(x), HV(y));
+            break;
+        case CHIP8_OP_XOR:
+            emit_alu8_rr(e, 0x30, HV(x), HV(y));
+            break;
+        case CHIP8_OP_ADD_VX_VY:
+            // VF = carry
+            emit_alu8_rr(e, 0x00, HV(x), HV(y));
+            emit_setcc_tmp(e, CC_B);
+            emit_set_vf(e, plan, x);
+            break;
+        case CHIP8_OP_SUB:
+            // 인터프리터와 같이 VF = Vx > Vy 를 먼저 쓰고, 그 다음 Vx -= Vy
+            // (x나 y가 F면 바뀐 VF 값으로 계산됨)
+            emit_alu8_rr(e, 0x38, HV(x), HV(y));
+            emit_setcc_tmp(e, CC_A);
+            emit_alu8_rr(e, 0x88, HV(0xF), REG_TMP);
+            emit_alu8_rr(e, 0x28, HV(x), HV(y));
+            break;
+        case CHIP8_OP_SUBN:
+            // VF = Vy > Vx 를 먼저 쓰고, 그 다음 Vx = Vy - Vx
+            emit_alu8_rr(e, 0x38, HV(y), HV(x));
+            emit_setcc_tmp(e, CC_A);
+            emit_alu8_rr(e, 0x88, HV(0xF), REG_TMP);
+            if (x == y) {
+                emit_mov8_ri(e, HV(x), 0);
+            } else {
+                emit_neg8(e, HV(x));
+                emit_alu8_rr(e, 0x00, HV(x), HV(y));
+            }
+            break;
+        case CHIP8_OP_SHR:
+            // shift 후 CF = 밀려난 비트
+            if (x == 0xF) {
+                // VF = VF & 1 을 먼저 쓰고 shift 하므로 항상 0
+                emit_mov8_ri(e, HV(x), 0);
+                break;
+            }
+            emit_shift8(e, 5, HV(x));
+            emit_setcc_tmp(e, CC_B);
+            emit_set_vf(e, plan, x);
+            break;
+        case CHIP8_OP_SHL:
+            emit_shift8(e, 4, HV(x));
+            emit_setcc_tmp(e, CC_B);
+            if (x == 0xF) {
+                // VF = 최상위 비트를 먼저 쓰고 shift 하므로 (최상위 비트 << 1)
+                emit_shift8(e, 4, REG_TMP);
+                emit_alu8_rr(e, 0x88, HV(x), REG_TMP);
+                break;
+            }
+            emit_set_vf(e, plan, x);
+            break;
+        case CHIP8_OP_LD_VX_DT:
+            emit_load8(e, HV(x), OFF_DT);
+            break;
+        case CHIP8_OP_LD_DT_VX:
+            emit_store8(e, OFF_DT, HV(x));
+            break;
+        case CHIP8_OP_LD_ST_VX:
+            emit_store8(e, OFF_ST, HV(x));
+            break;
+        case CHIP8_OP_LD_I:
+            emit_mov32_ri(e, host_regs[plan->ireg], in->nnn);
+            break;
+        case CHIP8_OP_ADD_I_VX:
+            // I는 16비트, 상위 비트는 저장할 때 버려짐
+            emit_movzx32_r8(e, RAX, HV(x));
+            emit_add32_rr(e, host_regs[plan->ireg], RAX);
+            break;
+        default:
+            break;
+    }
+}
+
+static void emit_block(struct emitter *e, const struct block_plan *plan) {
+    // prologue: callee-saved 레지스터 보존, 쓰는 레지스터 적재
+    for (int r = 0; r < plan->used; ++r) {
+        if (is_callee_saved(host_regs[r])) {
+            emit_push(e, host_regs[r]);
+        }
+    }
+    for (int v = 0; v < 16; ++v) {
+        if (plan->vreg[v] >= 0) {
+            emit_load8(e, host_regs[plan->vreg[v]], OFF_V(v));
+        }
+    }
+    if (plan->ireg >= 0) {
+        emit_movzx32_m16(e, host_regs[plan->ireg], OFF_I);
+    }
+
+    // 본문
+    const uint16_t straight_count = plan->terminated ? plan->count - 1 : plan->count;
+    for (uint16_t k = 0; k < straight_count; ++k) {
+        emit_straight(e, plan, &plan->insns[k]);
+    }
+
+    uint16_t exit_pc = (uint16_t) (plan->start + straight_count * 2);
+    bool dynamic_pc = false;
+    if (plan->terminated) {
+        dynamic_pc = emit_branch(e, plan, &plan->insns[plan->count - 1],
+                                 (uint16_t) (exit_pc + 2), &exit_pc);
+    }
+
+    // epilogue: 바뀐 레지스터와 pc를 되돌려 씀
+    for (int v = 0; v < 16; ++v) {
+        if (plan->v_dirty & (1u << v)) {
+            emit_store8(e, OFF_V(v), host_regs[plan->vreg[v]]);
+        }
+    }
+    if (plan->i_dirty) {
+        emit_store16(e, OFF_I, host_regs[plan->ireg]);
+    }
+    if (dynamic_pc) {
+        emit_store16(e, OFF_PC, REG_TMP);
+    } else {
+        emit_store16_imm(e, OFF_PC, exit_pc);
+    }
+    for (int r = plan->used - 1; r >= 0; --r) {
+        if (is_callee_saved(host_regs[r])) {
+            emit_pop(e, host_regs[r]);
+        }
+    }
+    emit_u8(e, 0xC3); // ret
+}
+
+/*
+ * 코드 버퍼 보호 속성 전환
+ * RWX 매핑은 SELinux, 하드닝된 커널, macOS hardened runtime에서 거부되므로 쓰기와 실행을 동시에 허용하지 않는다.
+ */
+static bool set_code_writable(const bool writable) {
+    if (code_writable == writable) {
+        return true;
+    }
+    if (mprotect(code_buf, JIT_CODE_SIZE, writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC) != 0) {
+        log_error("JIT code buffer mprotect failed");
+        return false;
+    }
+    code_writable = writable;
+    return true;
+}
+
+bool jit_init(void) {
+    if (code_buf) {
+        return true;
+    }
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_JIT
+    flags |= MAP_JIT; // macOS hardened runtime은 MAP_JIT 없이 실행 권한 전환을 허용하지 않음
+#endif
+    void *mem = mmap(NULL, JIT_CODE_SIZE, PROT_READ | PROT_WRITE, flags, -1, 0);
+    if (mem == MAP_FAILED) {
+        log_error("JIT code buffer mmap failed");
+        return false;
+    }
+    code_buf = mem;
+    code_writable = true;
+    jit_flush();
+    return true;
+}
+
+void jit_shutdown(void) {
+    if (code_buf) {
+        munmap(code_buf, JIT_CODE_SIZE);
+        code_buf = NULL;
+        code_writable = false;
+    }
+    jit_flush();
+}
+
+void jit_flush(void) {
+    memset(blocks, 0, sizeof(blocks));
+    code_used = 0;
+    jit_code_pages = 0;
+    // 버퍼를 다시 채울 것이므로 RW로 되돌림
+    if (code_buf) {
+        set_code_writable(true);
+    }
+}
+
+const struct jit_block *jit_get_block(const struct chip8 *chip, const uint16_t pc) {
+    struct jit_block *block = &blocks[pc & MEMORY_ADDR_MASK];
+    if (block->compiled) {
+        return block;
+    }
+    block->compiled = true;
+
+    struct block_plan plan;
+    plan_block(chip, pc & MEMORY_ADDR_MASK, &plan);
+    if (plan.count == 0) {
+        return block;
+    }
+
+    if (code_used + JIT_MAX_BLOCK_BYTES > JIT_CODE_SIZE) {
+        log_debug("JIT code buffer full, flushing");
+        jit_flush();
+        block->compiled = true;
+    }
+
+    // 실패하면 fn이 NULL로 남아 인터프리터가 처리
+    if (!set_code_writable(true)) {
+        return block;
+    }
+    struct emitter e = {code_buf + code_used};
+    emit_block(&e, &plan);
+    if (!set_code_writable(false)) {
+        return block;
+    }
+
+    block->fn = (jit_block_fn) (void *) (code_buf + code_used);
+    block->count = plan.count;
+    code_used += (size_t) (e.p - (code_buf + code_used));
+
+    // 블록이 걸친 페이지 표시
+    const uint16_t first_page = plan.start >> CODE_PAGE_SHIFT;
+    const uint16_t last_page = (plan.start + plan.count * 2 - 1) >> CODE_PAGE_SHIFT;
+    for (uint16_t page = first_page; page <= last_page; ++page) {
+        jit_code_pages |= 1ULL << page;
+    }
+    return block;
+}
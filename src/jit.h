@@ -0,0 +1,43 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chip8.h"
+
+/*
+ * x86-64 기본 블록 JIT
+ * pc에서 시작하는 직선 코드(점프/호출/스킵 등에서 끝남)를 네이티브 코드로 번역해 실행한다.
+ * Dxyn, 키 입력, 난수, 메모리 쓰기 명령어 등은 번역하지 않고 인터프리터가 처리한다.
+ */
+
+typedef void (*jit_block_fn)(struct chip8 *chip);
+
+struct jit_block {
+    jit_block_fn fn;    // 번역된 코드, NULL이면 pc에서 번역 가능한 블록이 없음
+    uint16_t count;     // 블록이 실행하는 명령어 수
+    bool compiled;      // 번역 시도 여부
+};
+
+// 번역된 코드가 있는 페이지 비트맵 (디코드 캐시와 같은 64바이트 페이지 단위)
+extern uint64_t jit_code_pages;
+
+bool jit_init(void);
+
+void jit_shutdown(void);
+
+// 번역된 블록 전체 폐기
+void jit_flush(void);
+
+// pc에서 시작하는 블록을 찾고, 없으면 번역한다. 번역할 수 없으면 fn이 NULL
+const struct jit_block *jit_get_block(const struct chip8 *chip, uint16_t pc);
+
+// 메모리 쓰기 시 호출, 번역된 코드가 있는 페이지에 쓰면 전체 폐기 (self-modifying code)
+static inline void jit_notify_write(const uint64_t page_mask) {
+    if (jit_code_pages & page_mask) {
+        jit_flush();
+    }
+}
+
+#endif // JIT_H
@@ -0,0 +1,91 @@
+#include <string.h>
+
+#include "keypad.h"
+
+void keypad_init(struct keypad *keypad, const uint64_t hold_ns) {
+    memset(keypad, 0, sizeof(*keypad));
+    keypad->hold_ns = hold_ns;
+}
+
+void keypad_press(struct keypad *keypad, const uint8_t key, const uint64_t time_ns) {
+    // 비트를 먼저 켜서 이벤트가 처리되기 전에도 눌림이 보이게 함
+    __atomic_fetch_or(&keypad->pressed, (uint16_t) (1u << key), __ATOMIC_RELEASE);
+
+    const uint32_t head = keypad->head;
+    const uint32_t tail = __atomic_load_n(&keypad->tail, __ATOMIC_ACQUIRE);
+    if (head - tail == KEYPAD_RING_SIZE) {
+        __atomic_fetch_add(&keypad->dropped, 1, __ATOMIC_RELAXED);
+        return;
+    }
+
+    struct key_event *event = &keypad->ring[head & (KEYPAD_RING_SIZE - 1)];
+    event->time_ns = time_ns;
+    event->key = key;
+    __atomic_store_n(&keypad->head, head + 1, __ATOMIC_RELEASE);
+}
+
+void keypad_drain(struct keypad *keypad) {
+    const uint32_t head = __atomic_load_n(&keypad->head, __ATOMIC_ACQUIRE);
+    uint32_t tail = keypad->tail;
+    uint16_t pressed = 0;
+
+    while (tail != head) {
+        const struct key_event *event = &keypad->ring[tail & (KEYPAD_RING_SIZE - 1)];
+        const uint16_t bit = (uint16_t) (1u << event->key);
+        keypad->press_time_ns[event->key] = event->time_ns;
+        keypad->fresh |= bit;
+        pressed |= bit;
+        ++tail;
+    }
+    __atomic_store_n(&keypad->tail, tail, __ATOMIC_RELEASE);
+
+    // 조회 중에 만료로 꺼졌을 수 있는 비트를 다시 켬
+    if (pressed) {
+        __atomic_fetch_or(&keypad->pressed, pressed, __ATOMIC_RELEASE);
+    }
+}
+
+void keypad_begin_frame(struct keypad *keypad, const uint64_t now_ns) {
+    keypad->now_ns = now_ns;
+    keypad->fresh = 0;
+    keypad_drain(keypad);
+}
+
+bool keypad_pop(struct keypad *keypad, struct key_event *event) {
+    const uint32_t head = __atomic_load_n(&keypad->head, __ATOMIC_ACQUIRE);
+    const uint32_t tail = keypad->tail;
+    if (tail == head) {
+        return false;
+    }
+    *event = keypad->ring[tail & (KEYPAD_RING_SIZE - 1)];
+    __atomic_store_n(&keypad->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+uint16_t keypad_down_mask(struct keypad *keypad) {
+    uint16_t mask = 0;
+    for (uint8_t key = 0; key < KEYPAD_KEY_COUNT; key++) {
+        if (keypad_is_down(keypad, key)) {
+            mask |= (uint16_t) (1u << key);
+        }
+    }
+    return mask;
+}
+
+void keypad_save(struct keypad *keypad, struct keypad_snapshot *snapshot) {
+    memset(snapshot, 0, sizeof(*snapshot));
+    snapshot->down = keypad_down_mask(keypad);
+    snapshot->fresh = keypad->fresh;
+    for (uint8_t key = 0; key < KEYPAD_KEY_COUNT; key++) {
+        snapshot->press_offset_ns[key] = (int64_t) (keypad->press_time_ns[key] - keypad->now_ns);
+    }
+}
+
+void keypad_restore(struct keypad *keypad, const struct keypad_snapshot *snapshot, const uint64_t now_ns) {
+    keypad->now_ns = now_ns;
+    keypad->fresh = snapshot->fresh;
+    for (uint8_t key = 0; key < KEYPAD_KEY_COUNT; key++) {
+        keypad->press_time_ns[key] = now_ns + (uint64_t) snapshot->press_offset_ns[key];
+    }
+    __atomic_store_n(&keypad->pressed, snapshot->down, __ATOMIC_RELEASE);
+}
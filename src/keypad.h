@@ -0,0 +1,106 @@
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * lock-free 키패드
+ * - 입력 스레드(생산자)는 눌린 키 비트를 원자적으로 켜고, 눌린 시각과 함께 이벤트를 SPSC 링 버퍼에 넣는다.
+ * - 에뮬레이션 스레드(소비자)는 링 버퍼를 비우면서 키마다 눌린 시각을 기록하고,
+ *   키를 조회할 때 눌린 시각 + 유지 시간이 지났으면 그때 비트를 끈다. (틱마다 감소시키는 루프 없음)
+ * 양쪽 모두 락을 잡지 않으므로 에뮬레이션 스레드는 입력 때문에 멈추지 않는다.
+ */
+
+#define KEYPAD_KEY_COUNT 16
+#define KEYPAD_RING_SIZE 64 // 2의 거듭제곱
+
+#define KEYPAD_CACHE_LINE 64
+
+struct key_event {
+    uint64_t time_ns; // CLOCK_MONOTONIC 기준 눌린 시각
+    uint8_t key;
+};
+
+struct keypad {
+    /* 생산자가 쓰는 값 */
+    uint32_t head __attribute__((aligned(KEYPAD_CACHE_LINE)));
+    uint32_t dropped; // 링 버퍼가 가득 차서 버린 이벤트 수
+
+    /* 소비자가 쓰는 값 */
+    uint32_t tail __attribute__((aligned(KEYPAD_CACHE_LINE)));
+    uint64_t hold_ns;                          // 눌린 뒤 키가 유지되는 시간
+    uint64_t now_ns;                           // 만료 판단 기준 시각, 프레임마다 갱신
+    uint64_t press_time_ns[KEYPAD_KEY_COUNT];
+    uint16_t fresh;                            // 이번 프레임에 새로 눌린 키 (Fx0A용)
+
+    /* 양쪽이 쓰는 값 */
+    uint16_t pressed __attribute__((aligned(KEYPAD_CACHE_LINE))); // 비트 n = 키 n
+
+    struct key_event ring[KEYPAD_RING_SIZE];
+};
+
+// 세이브 스테이트에 저장하는 키패드 상태, 시각은 저장 시점 기준 상대값이라 다른 프로세스에서도 복원 가능
+struct keypad_snapshot {
+    uint16_t down;                              // 눌린 키 비트 마스크 (만료된 키 제외)
+    uint16_t fresh;                             // 이번 프레임에 새로 눌린 키
+    uint32_t reserved;
+    int64_t press_offset_ns[KEYPAD_KEY_COUNT];  // 눌린 시각 - 기준 시각
+};
+
+void keypad_init(struct keypad *keypad, uint64_t hold_ns);
+
+/* 생산자 (입력 스레드) */
+
+// 키 눌림 전달, 링 버퍼가 가득 차면 이벤트는 버리지만 눌림 비트는 켜짐
+void keypad_press(struct keypad *keypad, uint8_t key, uint64_t time_ns);
+
+/* 소비자 (에뮬레이션 스레드) */
+
+// 링 버퍼에 쌓인 이벤트 처리
+void keypad_drain(struct keypad *keypad);
+
+// 프레임 시작 시 호출: 기준 시각 갱신, 이전 프레임의 새 입력 표시 초기화 후 이벤트 처리
+void keypad_begin_frame(struct keypad *keypad, uint64_t now_ns);
+
+// 이벤트 하나를 키패드 상태에 반영하지 않고 꺼냄, 없으면 false (입력 기록 시 다른 키패드로 옮기는 용도)
+bool keypad_pop(struct keypad *keypad, struct key_event *event);
+
+static inline bool keypad_has_events(const struct keypad *keypad) {
+    return __atomic_load_n(&keypad->head, __ATOMIC_ACQUIRE) != keypad->tail;
+}
+
+// 키가 눌려 있는지, 유지 시간이 지난 키는 여기서 비트를 끔
+static inline bool keypad_is_down(struct keypad *keypad, const uint8_t key) {
+    if (keypad_has_events(keypad)) {
+        keypad_drain(keypad);
+    }
+    const uint16_t bit = (uint16_t) (1u << key);
+    if (!(__atomic_load_n(&keypad->pressed, __ATOMIC_ACQUIRE) & bit)) {
+        return false;
+    }
+    // 눌린 시각이 프레임 기준 시각보다 늦을 수 있으므로 뺄셈 대신 더해서 비교
+    if (keypad->now_ns >= keypad->press_time_ns[key] + keypad->hold_ns) {
+        __atomic_fetch_and(&keypad->pressed, (uint16_t) ~bit, __ATOMIC_RELEASE);
+        return false;
+    }
+    return true;
+}
+
+// 이번 프레임에 새로 눌린 키 중 가장 작은 번호, 없으면 -1
+static inline int keypad_first_fresh(struct keypad *keypad) {
+    if (keypad_has_events(keypad)) {
+        keypad_drain(keypad);
+    }
+    return keypad->fresh ? __builtin_ctz(keypad->fresh) : -1;
+}
+
+// 현재 눌린 키 비트 마스크 (만료된 키 제외)
+uint16_t keypad_down_mask(struct keypad *keypad);
+
+// 소비자 쪽 상태를 기준 시각(now_ns) 대비 상대 시각으로 저장 / 새 기준 시각으로 복원
+void keypad_save(struct keypad *keypad, struct keypad_snapshot *snapshot);
+
+void keypad_restore(struct keypad *keypad, const struct keypad_snapshot *snapshot, uint64_t now_ns);
+
+#endif // KEYPAD_H
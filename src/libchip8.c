@@ -0,0 +1,920 @@
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libchip8.h"
+#include "rng.h"
+
+// 명령어 디스패치 엔진 - CMake의 CHIP8_DISPATCH 옵션으로 선택
+#define CHIP8_DISPATCH_SWITCH 0 // opcode 상위 니블 기준 중첩 switch
+#define CHIP8_DISPATCH_TABLE  1 // opcode 64K 핸들러 테이블
+#ifndef CHIP8_DISPATCH
+#define CHIP8_DISPATCH CHIP8_DISPATCH_SWITCH
+#endif
+
+/*
+ * 인스턴스
+ * 디코드 캐시는 4KB 주소 공간 전체에 대해 주소별로 디코드된 명령어를 저장하고, 처음 실행될 때 채워진다.
+ * 메모리 쓰기는 mem_write()를 통해서만 하고, 쓰여진 페이지는 dirty 비트로 표시했다가
+ * 해당 페이지의 명령어를 fetch 할 때 그 페이지의 캐시 항목을 비운다.
+ * 디코드한 항목이 있는 페이지도 따로 표시해서, 복제할 때 디코드 캐시(32KB)는 실제로 쓴 페이지만 복사한다.
+ */
+struct chip8_ctx {
+    struct chip8 chip;
+    struct rng rng;                 // Cxkk 난수
+    struct chip8_config config;
+    uint64_t timer_accumulator;     // 60Hz 타이머 갱신에 쓰고 남은 시간 (ns)
+    uint32_t ips_remainder;         // ips / CHIP8_FRAMES_PER_SECOND의 나머지 누적
+    uint16_t keys_down;             // 비트 n = 키 n
+    uint16_t keys_fresh;            // 이번 프레임에 새로 눌린 키 (Fx0A용)
+    uint64_t dirty_pages;           // 비트 n = 페이지 n (CODE_PAGE_SIZE 바이트 단위), 디코드 캐시 무효화용
+    uint64_t decoded_pages;         // 디코드 캐시에 항목이 있을 수 있는 페이지, 나머지 페이지의 항목은 모두 비어 있음
+    uint64_t hash_dirty_pages;      // 마지막 해시 계산 뒤 쓰기가 있었던 페이지, 해시를 구할 때 이 페이지만 다시 계산
+    uint64_t memory_hash;           // page_hash 전체의 XOR (hash_dirty_pages 페이지는 옛 값)
+    uint64_t page_hash[MEMORY_SIZE / CODE_PAGE_SIZE]; // 페이지별 메모리 Zobrist 값의 XOR
+    uint64_t display_hash;          // 화면 행별 Zobrist 값의 XOR
+    bool display_hash_stale;        // CLS/DRW 뒤 display_hash를 다시 계산해야 함
+
+    /* 복제하지 않는 필드 (chip8_copy()) */
+    uint64_t *write_watch;          // NULL이 아니면 메모리 쓰기 페이지를 OR (chip8_set_write_watch())
+    struct flight_recorder *flight; // NULL이면 기록하지 않음
+    struct chip8_pool *pool;        // 풀에서 할당했으면 chip8_destroy()가 풀로 돌려줌
+    struct chip8_ctx *next_free;    // 풀의 빈 슬롯 목록
+
+    struct chip8_insn decode_cache[MEMORY_SIZE];
+};
+
+#define CHIP8_POOL_BLOCK 64 // 풀이 한 번에 할당하는 인스턴스 수
+
+struct pool_block {
+    struct pool_block *next;
+    struct chip8_ctx slots[CHIP8_POOL_BLOCK];
+};
+
+struct chip8_pool {
+    struct pool_block *blocks;
+    struct chip8_ctx *free_list;
+    struct chip8_pool_stats stats;
+};
+
+typedef errcode_t (*opcode_handler_t)(struct chip8_ctx *ctx, const struct chip8_insn *in);
+
+// CHIP-8 폰트 집합 (0–F, 총 16자 × 5바이트 = 80바이트)
+static const uint8_t chip8_fontset[80] = {
+    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
+    0x20, 0x60, 0x20, 0x20, 0x70, // 1
+    0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
+    0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
+    0x90, 0x90, 0xF0, 0x10, 0x10, // 4
+    0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
+    0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
+    0xF0, 0x10, 0x20, 0x40, 0x40, // 7
+    0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
+    0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
+    0xF0, 0x90, 0xF0, 0x90, 0x90, // A
+    0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
+    0xF0, 0x80, 0x80, 0x80, 0xF0, // C
+    0xE0, 0x90, 0x90, 0x90, 0xE0, // D
+    0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
+    0xF0, 0x80, 0xF0, 0x80, 0x80 // F
+};
+
+/*
+ * 상태 해시 (Zobrist)
+ * (위치, 값) 쌍마다 64비트 값을 정하고 전체를 XOR한다. 일부가 바뀌면 그 부분의 옛 값을 XOR로 빼고 새 값을 넣으면 되므로
+ * 메모리는 디코드 캐시처럼 쓰여진 페이지를 표시해뒀다가 해시를 구할 때 그 페이지(64바이트)만 다시 계산하고,
+ * 화면은 CLS/DRW가 있었을 때만 32행을 다시 계산한다. (쓰기마다 갱신하면 DRW/Fx55가 2~3배 느려짐) 무작위 테이블(메모리만 4096 * 256 * 8 = 8MB) 대신
+ * 위치와 값을 합친 정수를 splitmix64 finalizer(전단사)로 섞은 값을 쓴다. 영역마다 상위 비트가 다른 salt를 XOR해서 겹치지 않게 한다.
+ */
+#define ZOBRIST_MEMORY_SALT   0x9E3779B97F4A7C15ULL
+#define ZOBRIST_DISPLAY_SALT  0xC2B2AE3D27D4EB4FULL
+#define ZOBRIST_REGISTER_SALT 0x165667B19E3779F9ULL
+
+enum zobrist_register {
+    ZOBRIST_V = 0,      // v[0..15]
+    ZOBRIST_STACK = 16, // stack[0..15]
+    ZOBRIST_I = 32,
+    ZOBRIST_PC,
+    ZOBRIST_SP,
+    ZOBRIST_DELAY_TIMER,
+    ZOBRIST_SOUND_TIMER
+};
+
+static inline uint64_t zobrist_mix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t zobrist_memory(const uint16_t addr, const uint8_t value) {
+    return zobrist_mix(((uint64_t) addr << 8 | value) ^ ZOBRIST_MEMORY_SALT);
+}
+
+// 행 값은 64비트 전체라 (행, 값)을 정수 하나로 합칠 수 없으므로 값을 먼저 섞고 행 번호를 더해 한 번 더 섞음
+static inline uint64_t zobrist_display(const unsigned row, const uint64_t bits) {
+    return zobrist_mix(zobrist_mix(bits) + (row ^ ZOBRIST_DISPLAY_SALT));
+}
+
+static inline uint64_t zobrist_register(const unsigned slot, const uint16_t value) {
+    return zobrist_mix(((uint64_t) slot << 16 | value) ^ ZOBRIST_REGISTER_SALT);
+}
+
+static uint64_t hash_page(const struct chip8 *chip, const unsigned page) {
+    uint64_t hash = 0;
+    for (unsigned addr = page << CODE_PAGE_SHIFT; addr < (page + 1) << CODE_PAGE_SHIFT; addr++) {
+        hash ^= zobrist_memory((uint16_t) addr, chip->memory[addr]);
+    }
+    return hash;
+}
+
+static uint64_t hash_memory(const struct chip8 *chip) {
+    uint64_t hash = 0;
+    for (unsigned page = 0; page < MEMORY_SIZE / CODE_PAGE_SIZE; page++) {
+        hash ^= hash_page(chip, page);
+    }
+    return hash;
+}
+
+static uint64_t hash_display(const struct chip8 *chip) {
+    uint64_t hash = 0;
+    for (unsigned row = 0; row < DISPLAY_HEIGHT; row++) {
+        hash ^= zobrist_display(row, chip->display[row]);
+    }
+    return hash;
+}
+
+// 레지스터는 pc처럼 명령어마다 바뀌므로 쓸 때마다 갱신하지 않고 해시를 구할 때 계산 (37개)
+static uint64_t hash_registers(const struct chip8 *chip) {
+    uint64_t hash = 0;
+    for (unsigned n = 0; n < 16; n++) {
+        hash ^= zobrist_register(ZOBRIST_V + n, chip->v[n]);
+        hash ^= zobrist_register(ZOBRIST_STACK + n, chip->stack[n]);
+    }
+    hash ^= zobrist_register(ZOBRIST_I, chip->i);
+    hash ^= zobrist_register(ZOBRIST_PC, chip->pc);
+    hash ^= zobrist_register(ZOBRIST_SP, chip->sp);
+    hash ^= zobrist_register(ZOBRIST_DELAY_TIMER, chip->delay_timer);
+    return hash ^ zobrist_register(ZOBRIST_SOUND_TIMER, chip->sound_timer);
+}
+
+// 모든 페이지와 화면을 다시 계산하도록 표시 (page_hash와 memory_hash가 모두 0이라 XOR로 빼도 맞음)
+static void reset_hash(struct chip8_ctx *ctx) {
+    memset(ctx->page_hash, 0, sizeof(ctx->page_hash));
+    ctx->memory_hash = 0;
+    ctx->hash_dirty_pages = ~0ULL;
+    ctx->display_hash_stale = true;
+}
+
+static void reset_decode_cache(struct chip8_ctx *ctx) {
+    memset(ctx->decode_cache, 0, sizeof(ctx->decode_cache));
+    ctx->dirty_pages = 0;
+    ctx->decoded_pages = 0;
+}
+
+// 메모리/레지스터/화면/타이머/키 입력/난수를 초기 상태로, 폰트 적재
+static void reset_machine(struct chip8_ctx *ctx) {
+    memset(&ctx->chip, 0, sizeof(ctx->chip));
+    ctx->chip.pc = PROGRAM_START_ADDR;
+    memcpy(ctx->chip.memory + FONTSET_ADDR, chip8_fontset, sizeof(chip8_fontset));
+
+    rng_seed(&ctx->rng, ctx->config.seed);
+    ctx->timer_accumulator = 0;
+    ctx->ips_remainder = 0;
+    ctx->keys_down = 0;
+    ctx->keys_fresh = 0;
+    reset_decode_cache(ctx);
+    reset_hash(ctx);
+    if (ctx->write_watch) {
+        *ctx->write_watch = ~0ULL;
+    }
+}
+
+struct chip8_ctx *chip8_create(const struct chip8_config *config) {
+    struct chip8_ctx *ctx = malloc(sizeof(*ctx));
+    if (!ctx) {
+        return NULL;
+    }
+    ctx->config = *config;
+    ctx->flight = NULL;
+    ctx->write_watch = NULL;
+    ctx->pool = NULL;
+    reset_machine(ctx);
+    return ctx;
+}
+
+void chip8_destroy(struct chip8_ctx *ctx) {
+    if (ctx && ctx->pool) {
+        ctx->next_free = ctx->pool->free_list;
+        ctx->pool->free_list = ctx;
+        --ctx->pool->stats.in_use;
+        return;
+    }
+    free(ctx);
+}
+
+errcode_t chip8_load_rom_mem(struct chip8_ctx *ctx, const uint8_t *rom, const size_t size) {
+    if (size > MEMORY_SIZE - PROGRAM_START_ADDR) {
+        return ERR_ROM_TOO_LARGE;
+    }
+    reset_machine(ctx);
+    memcpy(ctx->chip.memory + PROGRAM_START_ADDR, rom, size);
+    return ERR_NONE;
+}
+
+static void flush_decode_page(struct chip8_ctx *ctx, const uint16_t page) {
+    memset(&ctx->decode_cache[page << CODE_PAGE_SHIFT], 0,
+           CODE_PAGE_SIZE * sizeof(ctx->decode_cache[0]));
+    ctx->dirty_pages &= ~(1ULL << page);
+    ctx->decoded_pages &= ~(1ULL << page);
+}
+
+static inline const struct chip8_insn *fetch_insn(struct chip8_ctx *ctx, const uint16_t pc) {
+    const uint16_t addr = pc & MEMORY_ADDR_MASK;
+    const uint16_t page = addr >> CODE_PAGE_SHIFT;
+
+    if (ctx->dirty_pages & (1ULL << page)) {
+        flush_decode_page(ctx, page);
+    }
+
+    struct chip8_insn *in = &ctx->decode_cache[addr];
+    if (in->op == CHIP8_OP_UNDECODED) {
+        const uint16_t opcode = (ctx->chip.memory[addr] << 8)
+                                | ctx->chip.memory[(addr + 1) & MEMORY_ADDR_MASK];
+        chip8_decode_insn(in, opcode);
+        ctx->decoded_pages |= 1ULL << page;
+    }
+    return in;
+}
+
+static inline void mem_write(struct chip8_ctx *ctx, const uint16_t addr, const uint8_t value) {
+    const uint16_t a = addr & MEMORY_ADDR_MASK;
+    ctx->chip.memory[a] = value;
+    const uint64_t page = 1ULL << (a >> CODE_PAGE_SHIFT);
+    ctx->hash_dirty_pages |= page;
+    // 2바이트 명령어이므로 바로 앞 주소에서 시작하는 명령어도 영향을 받음
+    const uint64_t pages = page | (1ULL << (((a - 1) & MEMORY_ADDR_MASK) >> CODE_PAGE_SHIFT));
+    ctx->dirty_pages |= pages;
+    if (ctx->write_watch) {
+        *ctx->write_watch |= pages;
+    }
+}
+
+/*
+ * 명령어 핸들러
+ * 각 명령어의 동작은 여기서 한 번만 정의하고, 디스패치 엔진(switch / table)은 이 핸들러를 호출만 한다.
+ * 호출 시점에 pc는 이미 다음 명령어를 가리킨다.
+ */
+static errcode_t exec_INVALID(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    (void) ctx;
+    (void) in;
+    return ERR_NO_SUPPORTED_OPCODE;
+}
+
+static errcode_t exec_CLS(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 00E0 - CLS
+    (void) in;
+    memset(ctx->chip.display, 0, sizeof(ctx->chip.display));
+    ctx->display_hash_stale = true;
+    return ERR_NONE;
+}
+
+static errcode_t exec_RET(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 00EE - RET
+    (void) in;
+    // 스택은 16칸, 깊이를 넘으면 감싸서 인스턴스 밖을 건드리지 않음
+    ctx->chip.pc = ctx->chip.stack[ctx->chip.sp & 0xF];
+    --ctx->chip.sp;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SYS(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 0NNN
+    // 기계어 루틴 실행 - 구현 X
+    /* This instruction is only used on the old computers
+     * on which Chip-8 was originally implemented.
+     * It is ignored by modern interpreters. */
+    // 실행할 수 없으므로 정의되지 않은 opcode와 같이 에러 (ROM 끝을 넘어 0x0000을 실행한 경우 등)
+    return exec_INVALID(ctx, in);
+}
+
+static errcode_t exec_JP(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 1nnn - JP addr
+    ctx->chip.pc = in->nnn;
+    return ERR_NONE;
+}
+
+static errcode_t exec_CALL(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 2nnn - CALL addr
+    ++ctx->chip.sp;
+    ctx->chip.stack[ctx->chip.sp & 0xF] = ctx->chip.pc;
+    ctx->chip.pc = in->nnn;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SE_VX_KK(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 3xkk - SE Vx, byte
+    if (ctx->chip.v[in->x] == in->kk) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_SNE_VX_KK(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 4xkk - SNE Vx, byte
+    if (ctx->chip.v[in->x] != in->kk) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_SE_VX_VY(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 5xy0 - SE Vx, Vy
+    if (ctx->chip.v[in->x] == ctx->chip.v[in->y]) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_VX_KK(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 6xkk - LD Vx, byte
+    ctx->chip.v[in->x] = in->kk;
+    return ERR_NONE;
+}
+
+static errcode_t exec_ADD_VX_KK(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 7xkk - ADD Vx, byte
+    const uint8_t vx = in->x;
+    ctx->chip.v[vx] = ctx->chip.v[vx] + in->kk;
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_VX_VY(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy0 - LD Vx, Vy
+    ctx->chip.v[in->x] = ctx->chip.v[in->y];
+    return ERR_NONE;
+}
+
+static errcode_t exec_OR(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy1 - OR Vx, Vy
+    ctx->chip.v[in->x] |= ctx->chip.v[in->y];
+    return ERR_NONE;
+}
+
+static errcode_t exec_AND(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy2 - AND Vx, Vy
+    ctx->chip.v[in->x] &= ctx->chip.v[in->y];
+    return ERR_NONE;
+}
+
+static errcode_t exec_XOR(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy3 - XOR Vx, Vy
+    ctx->chip.v[in->x] ^= ctx->chip.v[in->y];
+    return ERR_NONE;
+}
+
+static errcode_t exec_ADD_VX_VY(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy4 - ADD Vx, Vy
+    const uint8_t vx = in->x;
+    const uint16_t sum = ctx->chip.v[vx] + ctx->chip.v[in->y];
+
+    // set VF = carry
+    ctx->chip.v[0xF] = (sum > 0xFF) ? 1 : 0;
+
+    ctx->chip.v[vx] = sum & 0xFF;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SUB(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy5 - SUB Vx, Vy
+    const uint8_t vx = in->x;
+    const uint8_t vy = in->y;
+
+    // set VF = NOT borrow
+    ctx->chip.v[0xF] = (ctx->chip.v[vx] > ctx->chip.v[vy]);
+
+    ctx->chip.v[vx] = ctx->chip.v[vx] - ctx->chip.v[vy];
+    return ERR_NONE;
+}
+
+static errcode_t exec_SHR(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy6 - SHR Vx {, Vy}
+    // Shift Right, {, Vy}는 옵션. 일부 구현해서 사용함.
+    const uint8_t vx = in->x;
+
+    // set VF = least-significant bit
+    ctx->chip.v[0xF] = ctx->chip.v[vx] & 0x1;
+
+    // Vx를 2로 나눔
+    ctx->chip.v[vx] = ctx->chip.v[vx] >> 1;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SUBN(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xy7 - SUBN Vx, Vy
+    // Subtract with Borrow
+    const uint8_t vx = in->x;
+    const uint8_t vy = in->y;
+
+    // set VF = NOT borrow
+    ctx->chip.v[0xF] = (ctx->chip.v[vy] > ctx->chip.v[vx]);
+
+    ctx->chip.v[vx] = ctx->chip.v[vy] - ctx->chip.v[vx];
+    return ERR_NONE;
+}
+
+static errcode_t exec_SHL(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 8xyE - SHL Vx {, Vy}
+    // Shift Left
+    const uint8_t vx = in->x;
+
+    // set VF = most significant bit
+    ctx->chip.v[0xF] = (ctx->chip.v[vx] & 0x80) >> 7;
+
+    // Vx를 2로 곱함
+    ctx->chip.v[vx] = ctx->chip.v[vx] << 1;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SNE_VX_VY(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // 9xy0 - SNE Vx, Vy
+    if (ctx->chip.v[in->x] != ctx->chip.v[in->y]) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_I(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Annn - LD I, addr
+    ctx->chip.i = in->nnn;
+    return ERR_NONE;
+}
+
+static errcode_t exec_JP_V0(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Bnnn - JP V0, addr
+    ctx->chip.pc = in->nnn + ctx->chip.v[0];
+    return ERR_NONE;
+}
+
+static errcode_t exec_RND(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Cxkk - RND Vx, byte
+    ctx->chip.v[in->x] = rng_next_byte(&ctx->rng) & in->kk;
+    return ERR_NONE;
+}
+
+// 64비트 값을 오른쪽으로 회전, 화면 우측을 넘어간 픽셀이 좌측으로 감싸짐
+static inline uint64_t rotate_right64(const uint64_t value, const unsigned shift) {
+    return (value >> shift) | (value << ((64 - shift) & 63));
+}
+
+static errcode_t exec_DRW(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Dxyn - DRW Vx, Vy, nibble: draw n-byte sprite at (Vx, Vy)
+    struct chip8 *chip = &ctx->chip;
+    const uint8_t n = in->n;
+
+    // 시작 좌표는 항상 화면 안으로 감쌈, 그 뒤 화면을 넘어가는 픽셀은 wrap/clip 옵션을 따름
+    const uint8_t x = chip->v[in->x] % DISPLAY_WIDTH;
+    const uint8_t y = chip->v[in->y] % DISPLAY_HEIGHT;
+    const bool wrap = !ctx->config.clip_sprites;
+
+    // 스프라이트 한 줄(8픽셀)을 행 전체 폭의 마스크로 만들어 AND 한 번으로 충돌 감지, XOR 한 번으로 그리기
+    uint64_t collision = 0;
+    for (uint8_t row = 0; row < n; ++row) {
+        uint8_t py = y + row;
+        if (py >= DISPLAY_HEIGHT) {
+            if (!wrap) {
+                break;
+            }
+            // Y축 wrapping: 화면 아래를 넘어가면 위로
+            py -= DISPLAY_HEIGHT;
+        }
+
+        const uint64_t sprite_row = (uint64_t) chip->memory[(chip->i + row) & MEMORY_ADDR_MASK] << 56;
+        // X축: wrap이면 회전해서 좌측으로, clip이면 시프트로 밀려난 픽셀은 버림
+        const uint64_t mask = wrap ? rotate_right64(sprite_row, x) : sprite_row >> x;
+
+        collision |= chip->display[py] & mask;
+        chip->display[py] ^= mask;
+    }
+    // VF에 충돌 플래그 기록
+    chip->v[0xF] = collision ? 1 : 0;
+    ctx->display_hash_stale = true;
+    return ERR_NONE;
+}
+
+static errcode_t exec_SKP(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Ex9E - SKP Vx
+    const uint8_t keypad_idx = ctx->chip.v[in->x] & 0xF;
+
+    if (ctx->keys_down & (1u << keypad_idx)) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_SKNP(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // ExA1 - SKNP Vx
+    const uint8_t keypad_idx = ctx->chip.v[in->x] & 0xF;
+
+    if (!(ctx->keys_down & (1u << keypad_idx))) {
+        ctx->chip.pc += 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_VX_DT(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx07 - LD Vx, DT
+    ctx->chip.v[in->x] = ctx->chip.delay_timer;
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_VX_K(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx0A - LD Vx, K
+    // 이번 프레임에 새로 눌린 키가 있는지 확인, 여러 개면 가장 작은 번호 사용
+    if (ctx->keys_fresh) {
+        ctx->chip.v[in->x] = (uint8_t) __builtin_ctz(ctx->keys_fresh);
+    } else {
+        // 신규 입력이 없으면 이 명령어를 다시 수행하도록 pc값 수정
+        ctx->chip.pc -= 2;
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_DT_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx15 - LD DT, Vx
+    ctx->chip.delay_timer = ctx->chip.v[in->x];
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_ST_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx18 - LD ST, Vx
+    ctx->chip.sound_timer = ctx->chip.v[in->x];
+    return ERR_NONE;
+}
+
+static errcode_t exec_ADD_I_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx1E - ADD I, Vx
+    ctx->chip.i += ctx->chip.v[in->x];
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_F_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx29 - LD F, Vx
+
+    // 각 문자는 5바이트
+    ctx->chip.i = FONTSET_ADDR + (ctx->chip.v[in->x] * FONT_SIZE / 8);
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_B_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx33 - LD B, Vx
+    const uint8_t value = ctx->chip.v[in->x];
+    const uint16_t i = ctx->chip.i;
+    mem_write(ctx, i, value / 100);
+    mem_write(ctx, i + 1, (value % 100) / 10);
+    mem_write(ctx, i + 2, value % 10);
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_MEM_VX(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx55 - LD [I], Vx
+    const uint8_t vx = in->x;
+    for (uint8_t r = 0; r <= vx; r++) {
+        mem_write(ctx, ctx->chip.i + r, ctx->chip.v[r]);
+    }
+    return ERR_NONE;
+}
+
+static errcode_t exec_LD_VX_MEM(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    // Fx65 - LD Vx, [I]
+    const uint8_t vx = in->x;
+    for (uint8_t r = 0; r <= vx; r++) {
+        ctx->chip.v[r] = ctx->chip.memory[(ctx->chip.i + r) & MEMORY_ADDR_MASK];
+    }
+    return ERR_NONE;
+}
+
+#if CHIP8_DISPATCH == CHIP8_DISPATCH_TABLE
+
+// 명령어 ID -> 핸들러, 명령어 하나당 간접 점프 한 번으로 처리
+static const opcode_handler_t dispatch_table[CHIP8_OP_COUNT] = {
+    [CHIP8_OP_UNDECODED] = exec_INVALID, // fetch_insn()을 거치면 나올 수 없음
+    [CHIP8_OP_INVALID] = exec_INVALID,
+#define X(name, mask, match, args, mnemonic) [CHIP8_OP_##name] = exec_##name,
+    CHIP8_OPCODES(X)
+#undef X
+};
+
+// 디코드된 명령어 실행 - 테이블 디스패치
+static inline errcode_t dispatch_insn(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    return dispatch_table[in->op](ctx, in);
+}
+
+#else
+
+// 디코드된 명령어 실행 - switch 디스패치
+// opcodes.h에 없는 opcode는 table 디스패치(CHIP8_OP_INVALID)와 같이 exec_INVALID()로, 두 엔진은 속도만 다름
+static inline errcode_t dispatch_insn(struct chip8_ctx *ctx, const struct chip8_insn *in) {
+    const uint16_t opcode = in->opcode;
+
+    switch (opcode & 0xF000) {
+        case 0x0000: {
+            switch (opcode) {
+                case 0x00E0: return exec_CLS(ctx, in);
+                case 0x00EE: return exec_RET(ctx, in);
+                default: return exec_SYS(ctx, in); // 0NNN & default
+            }
+        }
+        case 0x1000: return exec_JP(ctx, in);
+        case 0x2000: return exec_CALL(ctx, in);
+        case 0x3000: return exec_SE_VX_KK(ctx, in);
+        case 0x4000: return exec_SNE_VX_KK(ctx, in);
+        case 0x5000: {
+            if (in->n != 0) {
+                return exec_INVALID(ctx, in);
+            }
+            return exec_SE_VX_VY(ctx, in);
+        }
+        case 0x6000: return exec_LD_VX_KK(ctx, in);
+        case 0x7000: return exec_ADD_VX_KK(ctx, in);
+        case 0x8000: {
+            // 8xyn(N = 0-7, E)
+            switch (in->n) {
+                case 0x00: return exec_LD_VX_VY(ctx, in);
+                case 0x01: return exec_OR(ctx, in);
+                case 0x02: return exec_AND(ctx, in);
+                case 0x03: return exec_XOR(ctx, in);
+                case 0x04: return exec_ADD_VX_VY(ctx, in);
+                case 0x05: return exec_SUB(ctx, in);
+                case 0x06: return exec_SHR(ctx, in);
+                case 0x07: return exec_SUBN(ctx, in);
+                case 0x0E: return exec_SHL(ctx, in);
+                default:
+                    return exec_INVALID(ctx, in);
+            }
+        }
+        case 0x9000: {
+            if (in->n != 0) {
+                return exec_INVALID(ctx, in);
+            }
+            return exec_SNE_VX_VY(ctx, in);
+        }
+        case 0xA000: return exec_LD_I(ctx, in);
+        case 0xB000: return exec_JP_V0(ctx, in);
+        case 0xC000: return exec_RND(ctx, in);
+        case 0xD000: return exec_DRW(ctx, in);
+        case 0xE000: {
+            if (in->kk == 0x9E) {
+                return exec_SKP(ctx, in);
+            }
+            if (in->kk == 0xA1) {
+                return exec_SKNP(ctx, in);
+            }
+            return exec_INVALID(ctx, in);
+        }
+        case 0xF000: {
+            switch (in->kk) {
+                case 0x07: return exec_LD_VX_DT(ctx, in);
+                case 0x0A: return exec_LD_VX_K(ctx, in);
+                case 0x15: return exec_LD_DT_VX(ctx, in);
+                case 0x18: return exec_LD_ST_VX(ctx, in);
+                case 0x1E: return exec_ADD_I_VX(ctx, in);
+                case 0x29: return exec_LD_F_VX(ctx, in);
+                case 0x33: return exec_LD_B_VX(ctx, in);
+                case 0x55: return exec_LD_MEM_VX(ctx, in);
+                case 0x65: return exec_LD_VX_MEM(ctx, in);
+                default:
+                    return exec_INVALID(ctx, in);
+            }
+        }
+    }
+    return exec_INVALID(ctx, in);
+}
+
+#endif // CHIP8_DISPATCH
+
+// 명령어 하나를 fetch, pc를 다음 명령어로 옮긴 뒤 실행
+static inline errcode_t execute_insn(struct chip8_ctx *ctx) {
+    const struct chip8_insn *in = fetch_insn(ctx, ctx->chip.pc);
+    ctx->chip.pc += 2;
+    return dispatch_insn(ctx, in);
+}
+
+errcode_t chip8_step(struct chip8_ctx *ctx, const uint32_t count) {
+    struct flight_recorder *flight = ctx->flight;
+    if (!flight) {
+        for (uint32_t n = 0; n < count; n++) {
+            const errcode_t err = execute_insn(ctx);
+            if (err != ERR_NONE) {
+                return err;
+            }
+        }
+        return ERR_NONE;
+    }
+
+    uint64_t seq = flight->head; // 플라이트 레코더 순번은 루프 안에서 레지스터로만 증가
+    for (uint32_t n = 0; n < count; n++) {
+        const struct chip8_insn *in = fetch_insn(ctx, ctx->chip.pc);
+        flight_record(flight, seq++, ctx->chip.pc, in->opcode, ctx->chip.i, 1);
+        ctx->chip.pc += 2;
+        const errcode_t err = dispatch_insn(ctx, in);
+        if (err != ERR_NONE) {
+            return err;
+        }
+    }
+    return ERR_NONE;
+}
+
+uint32_t chip8_frame_budget(struct chip8_ctx *ctx) {
+    ctx->ips_remainder += ctx->config.ips;
+    const uint32_t budget = ctx->ips_remainder / CHIP8_FRAMES_PER_SECOND;
+    ctx->ips_remainder %= CHIP8_FRAMES_PER_SECOND;
+    return budget;
+}
+
+bool chip8_tick_timers(struct chip8_ctx *ctx) {
+    // 60Hz 타이머는 에뮬레이션 시간 기준이라 프레임마다 한 번
+    // 누적값은 세이브 스테이트에 포함 (예전 상태에서 복원하면 0이 아닐 수 있음)
+    uint64_t accumulator = ctx->timer_accumulator + CHIP8_FRAME_INTERVAL_NS;
+    bool sound = false;
+
+    while (accumulator >= CHIP8_FRAME_INTERVAL_NS) {
+        if (ctx->chip.sound_timer > 0) {
+            --ctx->chip.sound_timer;
+            sound = true;
+        }
+        if (ctx->chip.delay_timer > 0) {
+            --ctx->chip.delay_timer;
+        }
+        accumulator -= CHIP8_FRAME_INTERVAL_NS;
+    }
+    ctx->timer_accumulator = accumulator;
+    ctx->keys_fresh = 0;
+    return sound;
+}
+
+errcode_t chip8_run_frame(struct chip8_ctx *ctx) {
+    const errcode_t err = chip8_step(ctx, chip8_frame_budget(ctx));
+    if (err != ERR_NONE) {
+        return err;
+    }
+    chip8_tick_timers(ctx);
+    return ERR_NONE;
+}
+
+void chip8_set_keys(struct chip8_ctx *ctx, const uint16_t down, const uint16_t pressed) {
+    ctx->keys_down = down;
+    ctx->keys_fresh = pressed;
+}
+
+const uint64_t *chip8_framebuffer(const struct chip8_ctx *ctx) {
+    return ctx->chip.display;
+}
+
+struct chip8 *chip8_machine(struct chip8_ctx *ctx) {
+    // 호출한 쪽이 메모리/화면을 직접 바꿀 수 있으므로 다음 해시는 전체를 다시 계산
+    ctx->hash_dirty_pages = ~0ULL;
+    ctx->display_hash_stale = true;
+    return &ctx->chip;
+}
+
+const struct chip8 *chip8_machine_const(const struct chip8_ctx *ctx) {
+    return &ctx->chip;
+}
+
+void chip8_get_state(const struct chip8_ctx *ctx, struct chip8_state *state) {
+    state->chip = ctx->chip;
+    state->rng_state = ctx->rng.state;
+    state->timer_accumulator_ns = ctx->timer_accumulator;
+    state->ips_remainder = ctx->ips_remainder;
+}
+
+void chip8_set_state(struct chip8_ctx *ctx, const struct chip8_state *state) {
+    ctx->chip = state->chip;
+    ctx->rng.state = state->rng_state;
+    ctx->timer_accumulator = state->timer_accumulator_ns;
+    ctx->ips_remainder = state->ips_remainder % CHIP8_FRAMES_PER_SECOND;
+    reset_decode_cache(ctx);
+    reset_hash(ctx);
+    if (ctx->write_watch) {
+        *ctx->write_watch = ~0ULL;
+    }
+}
+
+uint64_t chip8_hash_machine(const struct chip8 *chip) {
+    return hash_memory(chip) ^ hash_display(chip) ^ hash_registers(chip);
+}
+
+uint64_t chip8_state_hash(struct chip8_ctx *ctx) {
+    while (ctx->hash_dirty_pages) {
+        const unsigned page = (unsigned) __builtin_ctzll(ctx->hash_dirty_pages);
+        ctx->hash_dirty_pages &= ctx->hash_dirty_pages - 1;
+        const uint64_t hash = hash_page(&ctx->chip, page);
+        ctx->memory_hash ^= ctx->page_hash[page] ^ hash;
+        ctx->page_hash[page] = hash;
+    }
+    if (ctx->display_hash_stale) {
+        ctx->display_hash = hash_display(&ctx->chip);
+        ctx->display_hash_stale = false;
+    }
+    return ctx->memory_hash ^ ctx->display_hash ^ hash_registers(&ctx->chip);
+}
+
+/* 복제 */
+
+struct chip8_pool *chip8_pool_create(void) {
+    return calloc(1, sizeof(struct chip8_pool));
+}
+
+void chip8_pool_destroy(struct chip8_pool *pool) {
+    if (!pool) {
+        return;
+    }
+    struct pool_block *block = pool->blocks;
+    while (block) {
+        struct pool_block *next = block->next;
+        free(block);
+        block = next;
+    }
+    free(pool);
+}
+
+void chip8_pool_get_stats(const struct chip8_pool *pool, struct chip8_pool_stats *stats) {
+    *stats = pool->stats;
+}
+
+// 빈 슬롯 하나, 없으면 블록을 새로 할당 (calloc이라 디코드 캐시가 비어 있고 decoded_pages = 0)
+static struct chip8_ctx *pool_take(struct chip8_pool *pool) {
+    if (!pool->free_list) {
+        struct pool_block *block = calloc(1, sizeof(*block));
+        if (!block) {
+            return NULL;
+        }
+        block->next = pool->blocks;
+        pool->blocks = block;
+        for (int n = CHIP8_POOL_BLOCK - 1; n >= 0; n--) {
+            block->slots[n].pool = pool;
+            block->slots[n].next_free = pool->free_list;
+            pool->free_list = &block->slots[n];
+        }
+        pool->stats.capacity += CHIP8_POOL_BLOCK;
+        ++pool->stats.blocks;
+    }
+    struct chip8_ctx *ctx = pool->free_list;
+    pool->free_list = ctx->next_free;
+    ++pool->stats.in_use;
+    return ctx;
+}
+
+// pages의 페이지마다 디코드 캐시 CODE_PAGE_SIZE 항목을 src에서 복사, src가 NULL이면 비움
+static void copy_decode_pages(struct chip8_ctx *dst, const struct chip8_ctx *src, uint64_t pages) {
+    while (pages) {
+        const unsigned base = (unsigned) __builtin_ctzll(pages) << CODE_PAGE_SHIFT;
+        pages &= pages - 1;
+        if (src) {
+            memcpy(&dst->decode_cache[base], &src->decode_cache[base], CODE_PAGE_SIZE * sizeof(dst->decode_cache[0]));
+        } else {
+            memset(&dst->decode_cache[base], 0, CODE_PAGE_SIZE * sizeof(dst->decode_cache[0]));
+        }
+    }
+}
+
+void chip8_copy(struct chip8_ctx *dst, const struct chip8_ctx *src) {
+    if (dst == src) {
+        return;
+    }
+    // dst에만 디코드된 페이지는 비우고, src에서 디코드된 페이지만 복사 (나머지는 양쪽 다 비어 있음)
+    copy_decode_pages(dst, NULL, dst->decoded_pages & ~src->decoded_pages);
+    copy_decode_pages(dst, src, src->decoded_pages);
+    memcpy(dst, src, offsetof(struct chip8_ctx, write_watch));
+    if (dst->write_watch) {
+        *dst->write_watch = ~0ULL;
+    }
+}
+
+struct chip8_ctx *chip8_clone(const struct chip8_ctx *src, struct chip8_pool *pool) {
+    struct chip8_ctx *dst;
+    if (pool) {
+        dst = pool_take(pool);
+    } else {
+        dst = calloc(1, sizeof(*dst));
+    }
+    if (!dst) {
+        return NULL;
+    }
+    dst->write_watch = NULL;
+    dst->flight = NULL;
+    chip8_copy(dst, src);
+    return dst;
+}
+
+const struct chip8_insn *chip8_next_insn(struct chip8_ctx *ctx) {
+    return fetch_insn(ctx, ctx->chip.pc);
+}
+
+void chip8_set_flight_recorder(struct chip8_ctx *ctx, struct flight_recorder *flight) {
+    ctx->flight = flight;
+}
+
+void chip8_set_write_watch(struct chip8_ctx *ctx, uint64_t *pages) {
+    ctx->write_watch = pages;
+}
@@ -0,0 +1,145 @@
+#ifndef LIBCHIP8_H
+#define LIBCHIP8_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "errcode.h"
+#include "flight.h"
+#include "opcodes.h"
+
+/*
+ * libchip8: 재진입 가능한 CHIP-8 코어
+ * 머신 상태, 디코드 캐시, 난수, 키 입력, 타이머 누적값을 모두 인스턴스(struct chip8_ctx) 안에 두고
+ * 전역 상태와 입출력(터미널, 로그, 스레드, 파일)이 없다. 인스턴스끼리는 공유하는 것이 없으므로
+ * 한 프로세스에 여러 개를 만들어 스레드마다 따로 돌릴 수 있다. (인스턴스 하나를 여러 스레드가 동시에 쓰면 안 됨)
+ *
+ * 기본 사용 순서
+ *   chip8_create() -> chip8_load_rom_mem() -> 프레임마다 chip8_set_keys(), chip8_run_frame(), chip8_framebuffer()
+ * 프레임 안에서 입력 위치를 나눠야 하면 chip8_frame_budget() / chip8_step() / chip8_tick_timers()를 직접 쓴다.
+ */
+
+#define CHIP8_FRAMES_PER_SECOND 60
+#define CHIP8_FRAME_INTERVAL_NS 16666667ULL // 60Hz 타이머 주기 = 프레임 간격
+#define CHIP8_MAX_IPS 100000000U // ips 상한, 프레임 명령어 수 나머지 누적(uint32_t)이 넘치지 않는 범위
+
+struct chip8_ctx;
+
+// 인스턴스 설정, 실행 중에는 바꿀 수 없음
+struct chip8_config {
+    uint32_t ips;       // 초당 명령어 수, chip8_run_frame()은 프레임마다 ips / 60개 실행
+    bool clip_sprites;  // true면 화면 밖으로 나가는 스프라이트 픽셀을 자름, false면 반대편으로 감쌈
+    uint64_t seed;      // Cxkk 난수 시드
+};
+
+// 인스턴스의 실행 상태 전체 (세이브 스테이트/되감기용), 디코드 캐시 같은 파생 상태는 제외
+struct chip8_state {
+    struct chip8 chip;
+    uint64_t rng_state;
+    uint64_t timer_accumulator_ns;
+    uint32_t ips_remainder;         // 프레임 명령어 수(ips / 60)의 나머지 누적, 다음 chip8_frame_budget()에 반영
+};
+
+// 인스턴스 생성, 메모리가 부족하면 NULL
+// 머신은 폰트만 적재된 초기 상태 (pc = PROGRAM_START_ADDR)
+struct chip8_ctx *chip8_create(const struct chip8_config *config);
+
+// 풀에서 만든 인스턴스(chip8_clone())는 풀로 돌려줌
+void chip8_destroy(struct chip8_ctx *ctx);
+
+// 머신을 초기 상태로 되돌리고 ROM을 PROGRAM_START_ADDR에 적재, 난수는 설정의 시드로 다시 시작
+errcode_t chip8_load_rom_mem(struct chip8_ctx *ctx, const uint8_t *rom, size_t size);
+
+// 명령어 count개 실행, 타이머는 진행하지 않음
+// 에러가 나면 그 명령어에서 멈추고 에러 코드 반환 (pc는 에러 난 명령어 다음)
+errcode_t chip8_step(struct chip8_ctx *ctx, uint32_t count);
+
+// 이번 프레임에 실행할 명령어 수 (ips / 60), 60으로 나누어 떨어지지 않는 나머지는 다음 프레임으로 넘김
+uint32_t chip8_frame_budget(struct chip8_ctx *ctx);
+
+// 프레임 끝 처리: 60Hz 타이머 갱신, 새로 눌린 키 표시 초기화
+// 사운드 타이머가 줄어들었으면(소리를 내야 하면) true
+bool chip8_tick_timers(struct chip8_ctx *ctx);
+
+// 한 프레임 실행: chip8_frame_budget()개 명령어 실행 후 chip8_tick_timers()
+errcode_t chip8_run_frame(struct chip8_ctx *ctx);
+
+// 키 입력 설정, 비트 n = 키 n
+// down은 눌려 있는 키, pressed는 이번 프레임에 새로 눌린 키 (Fx0A가 기다리는 입력, chip8_tick_timers()에서 초기화)
+void chip8_set_keys(struct chip8_ctx *ctx, uint16_t down, uint16_t pressed);
+
+// 64 * 32 화면, 행마다 uint64_t 하나 (DISPLAY_HEIGHT개, 최상위 비트가 x = 0)
+const uint64_t *chip8_framebuffer(const struct chip8_ctx *ctx);
+
+// 머신 상태 직접 접근 (레지스터 설정, JIT/AOT 코드 실행)
+// 메모리를 직접 바꾸면 디코드 캐시에 반영되지 않으므로 메모리는 chip8_set_state()로 바꾼다.
+// 호출할 때마다 다음 chip8_state_hash()가 전체를 다시 계산하도록 표시하므로, 포인터로 바꾼 뒤 해시를 구하려면 다시 호출한다.
+struct chip8 *chip8_machine(struct chip8_ctx *ctx);
+
+// 머신 상태 읽기 전용 접근 (레지스터/pc/I 조회, 화면/메모리 덤프), 해시 추적에 영향 없음
+const struct chip8 *chip8_machine_const(const struct chip8_ctx *ctx);
+
+void chip8_get_state(const struct chip8_ctx *ctx, struct chip8_state *state);
+
+// 상태 복원, 메모리 전체를 바꾼 것으로 보고 디코드 캐시를 비움 (쓰기 감시에는 모든 페이지 표시)
+void chip8_set_state(struct chip8_ctx *ctx, const struct chip8_state *state);
+
+/*
+ * 상태 해시 (방문한 상태 중복 제거용)
+ * struct chip8 전체(메모리, 레지스터, 스택, 타이머, 화면)의 64비트 Zobrist 해시, 난수 상태와 키 입력은 포함하지 않는다.
+ * chip8_state_hash()는 4.4KB 전체를 읽지 않고 마지막 계산 뒤 쓰기가 있었던 메모리 페이지(64바이트)와
+ * 그림을 그렸으면 화면, 레지스터만 다시 계산한다. 같은 머신 상태면 chip8_hash_machine()과 같은 값이다.
+ */
+
+// 인스턴스 상태의 해시, 비용은 마지막 호출 뒤 바뀐 페이지 수에 비례 (적재/상태 설정 직후 첫 호출은 전체 계산)
+uint64_t chip8_state_hash(struct chip8_ctx *ctx);
+
+// 머신 상태 전체를 읽어서 계산 (세이브 스테이트, chip8_batch_get_state() 결과 등)
+uint64_t chip8_hash_machine(const struct chip8 *chip);
+
+/*
+ * 복제 (트리 탐색용)
+ * 복제본은 원본과 독립된 인스턴스로, 머신 상태/난수/키 입력/타이머 누적값/디코드 캐시를 그대로 가져간다.
+ * 디코드 캐시는 원본이 디코드한 페이지만 복사하므로 보통 ROM이면 복제 비용은 머신 상태(약 4.4KB) 복사 정도다.
+ * 플라이트 레코더와 쓰기 감시는 복제하지 않는다. (복제본은 기록하지 않음)
+ *
+ * 풀은 인스턴스 슬롯을 블록 단위로 할당해두고 chip8_destroy()로 돌려받은 슬롯을 다시 쓴다.
+ * 풀 하나를 여러 스레드가 동시에 쓰면 안 되고(스레드마다 풀 하나), 풀을 없애면 거기서 만든 인스턴스도 모두 무효가 된다.
+ */
+
+struct chip8_pool;
+
+struct chip8_pool_stats {
+    size_t capacity; // 할당해둔 슬롯 수
+    size_t in_use;   // 사용 중인 슬롯 수
+    size_t blocks;   // 할당한 블록 수
+};
+
+// 메모리가 부족하면 NULL
+struct chip8_pool *chip8_pool_create(void);
+
+void chip8_pool_destroy(struct chip8_pool *pool);
+
+void chip8_pool_get_stats(const struct chip8_pool *pool, struct chip8_pool_stats *stats);
+
+// src의 복제본, pool이 NULL이 아니면 풀의 슬롯에 만듦 (chip8_destroy()로 풀에 돌려줌), 메모리가 부족하면 NULL
+struct chip8_ctx *chip8_clone(const struct chip8_ctx *src, struct chip8_pool *pool);
+
+// 이미 있는 인스턴스 dst를 src와 같은 상태로 (할당 없이 복제), dst의 플라이트 레코더/쓰기 감시는 그대로 둠
+void chip8_copy(struct chip8_ctx *dst, const struct chip8_ctx *src);
+
+/* 도구용 (에뮬레이터의 트레이스/프로파일/JIT/AOT) */
+
+// 다음에 실행할 명령어 (디코드 캐시 항목), 다음 chip8_step() 전까지만 유효
+const struct chip8_insn *chip8_next_insn(struct chip8_ctx *ctx);
+
+// 실행한 명령어를 플라이트 레코더에 기록, NULL이면 기록하지 않음
+void chip8_set_flight_recorder(struct chip8_ctx *ctx, struct flight_recorder *flight);
+
+// 메모리 쓰기가 있었던 페이지를 *pages에 OR (비트 n = CODE_PAGE_SIZE 단위 페이지 n), NULL이면 감시하지 않음
+// 번역된 코드(JIT/AOT)를 따로 들고 있는 쪽이 self-modifying code를 감지하는 데 쓴다. 비우는 것은 호출한 쪽이 한다.
+void chip8_set_write_watch(struct chip8_ctx *ctx, uint64_t *pages);
+
+#endif // LIBCHIP8_H
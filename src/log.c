@@ -20,10 +20,19 @@
  * IN THE SOFTWARE.
  */
 
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+
 #include "log.h"
 
 #define MAX_CALLBACKS 32
 
+/* 비동기 모드: 이벤트를 MPSC 링 버퍼에 넣고 writer 스레드가 모아서 출력 */
+#define LOG_ASYNC_SLOTS     1024 /* 2의 거듭제곱 */
+#define LOG_ASYNC_MSG_SIZE  256
+#define LOG_ASYNC_IDLE_NS   2000000L /* 링 버퍼가 비었을 때 writer가 쉬는 시간 (2ms) */
+
 typedef struct {
   log_LogFn fn;
   void *udata;
@@ -38,6 +47,28 @@ static struct {
   Callback callbacks[MAX_CALLBACKS];
 } L;
 
+typedef struct {
+  uint32_t seq; /* 슬롯 상태: 쓰기 가능하면 pos, 읽기 가능하면 pos + 1 */
+  int level;
+  int line;
+  const char *file;
+  time_t time;
+  char msg[LOG_ASYNC_MSG_SIZE];
+} AsyncSlot;
+
+static struct {
+  bool running;
+  pthread_t thread;
+  uint32_t enqueue_pos; /* 생산자들이 CAS로 증가 */
+  uint32_t dequeue_pos; /* writer 스레드만 사용 */
+  unsigned long dropped;
+  unsigned long dropped_reported;
+  time_t cached_time; /* 시간 문자열은 초가 바뀔 때만 다시 만듦 */
+  char time_short[16];
+  char time_long[64];
+  AsyncSlot slots[LOG_ASYNC_SLOTS];
+} A;
+
 
 static const char *level_strings[] = {
   "TRACE", "DEBUG", "INFO", "WARN", "ERROR", "FATAL"
@@ -137,7 +168,186 @@ static void init_event(log_Event *ev, void *udata) {
 }
 
 
+static bool is_enabled(int level) {
+  if (!L.quiet && level >= L.level) { return true; }
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    if (level >= L.callbacks[i].level) { return true; }
+  }
+  return false;
+}
+
+
+/* 가득 차 있으면 버리고 카운터만 증가, 생산자는 절대 기다리지 않음 */
+static void async_push(int level, const char *file, int line, const char *fmt, va_list ap) {
+  uint32_t pos = __atomic_load_n(&A.enqueue_pos, __ATOMIC_RELAXED);
+  AsyncSlot *slot;
+  for (;;) {
+    slot = &A.slots[pos & (LOG_ASYNC_SLOTS - 1)];
+    const uint32_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+    const int32_t diff = (int32_t) (seq - pos);
+    if (diff == 0) {
+      if (__atomic_compare_exchange_n(&A.enqueue_pos, &pos, pos + 1, true,
+                                      __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+        break;
+      }
+    } else if (diff < 0) {
+      __atomic_fetch_add(&A.dropped, 1, __ATOMIC_RELAXED);
+      return;
+    } else {
+      pos = __atomic_load_n(&A.enqueue_pos, __ATOMIC_RELAXED);
+    }
+  }
+
+  slot->level = level;
+  slot->file = file;
+  slot->line = line;
+  slot->time = time(NULL);
+  vsnprintf(slot->msg, sizeof(slot->msg), fmt, ap);
+  __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+
+static void update_time_cache(time_t t) {
+  if (t == A.cached_time) { return; }
+  struct tm tm;
+  localtime_r(&t, &tm);
+  strftime(A.time_short, sizeof(A.time_short), "%H:%M:%S", &tm);
+  strftime(A.time_long, sizeof(A.time_long), "%Y-%m-%d %H:%M:%S", &tm);
+  A.cached_time = t;
+}
+
+
+static void forward_event(Callback *cb, log_Event *ev, const char *fmt, ...) {
+  va_start(ev->ap, fmt);
+  cb->fn(ev);
+  va_end(ev->ap);
+}
+
+
+static void async_write(const AsyncSlot *slot) {
+  update_time_cache(slot->time);
+
+  if (!L.quiet && slot->level >= L.level) {
+#ifdef LOG_USE_COLOR
+    fprintf(
+      stderr, "%s %s%-5s\x1b[0m \x1b[90m%s:%d:\x1b[0m %s\n",
+      A.time_short, level_colors[slot->level], level_strings[slot->level],
+      slot->file, slot->line, slot->msg);
+#else
+    fprintf(
+      stderr, "%s %-5s %s:%d: %s\n",
+      A.time_short, level_strings[slot->level], slot->file, slot->line, slot->msg);
+#endif
+  }
+
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    Callback *cb = &L.callbacks[i];
+    if (slot->level < cb->level) { continue; }
+    if (cb->fn == file_callback) {
+      /* stdio 버퍼에 쌓고 배치가 끝날 때 한 번에 flush */
+      fprintf(
+        cb->udata, "%s %-5s %s:%d: %s\n",
+        A.time_long, level_strings[slot->level], slot->file, slot->line, slot->msg);
+    } else {
+      struct tm tm;
+      localtime_r(&slot->time, &tm);
+      log_Event ev = {
+        .file  = slot->file,
+        .line  = slot->line,
+        .level = slot->level,
+        .time  = &tm,
+        .udata = cb->udata,
+        .fmt   = "%s",
+      };
+      forward_event(cb, &ev, "%s", slot->msg);
+    }
+  }
+}
+
+
+static void async_flush(void) {
+  fflush(stderr);
+  for (int i = 0; i < MAX_CALLBACKS && L.callbacks[i].fn; i++) {
+    if (L.callbacks[i].fn == file_callback) { fflush(L.callbacks[i].udata); }
+  }
+}
+
+
+/* 쌓인 이벤트를 모두 출력, 출력한 개수 반환 */
+static int async_drain(void) {
+  int count = 0;
+  for (;;) {
+    AsyncSlot *slot = &A.slots[A.dequeue_pos & (LOG_ASYNC_SLOTS - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != A.dequeue_pos + 1) { break; }
+    async_write(slot);
+    __atomic_store_n(&slot->seq, A.dequeue_pos + LOG_ASYNC_SLOTS, __ATOMIC_RELEASE);
+    ++A.dequeue_pos;
+    ++count;
+  }
+
+  const unsigned long dropped = __atomic_load_n(&A.dropped, __ATOMIC_RELAXED);
+  if (dropped != A.dropped_reported) {
+    AsyncSlot note = { .level = LOG_WARN, .file = __FILE__, .line = __LINE__, .time = time(NULL) };
+    snprintf(note.msg, sizeof(note.msg), "log buffer full, %lu events dropped (total %lu)",
+             dropped - A.dropped_reported, dropped);
+    async_write(&note);
+    A.dropped_reported = dropped;
+    ++count;
+  }
+
+  if (count > 0) { async_flush(); }
+  return count;
+}
+
+
+static void *async_writer(void *arg) {
+  (void) arg;
+  const struct timespec idle = { 0, LOG_ASYNC_IDLE_NS };
+  while (__atomic_load_n(&A.running, __ATOMIC_ACQUIRE)) {
+    if (async_drain() == 0) { nanosleep(&idle, NULL); }
+  }
+  async_drain();
+  return NULL;
+}
+
+
+int log_start_async(void) {
+  if (A.running) { return 0; }
+  for (uint32_t i = 0; i < LOG_ASYNC_SLOTS; i++) { A.slots[i].seq = i; }
+  A.enqueue_pos = 0;
+  A.dequeue_pos = 0;
+  A.cached_time = (time_t) -1;
+  __atomic_store_n(&A.running, true, __ATOMIC_RELEASE);
+  if (pthread_create(&A.thread, NULL, async_writer, NULL) != 0) {
+    A.running = false;
+    return -1;
+  }
+  return 0;
+}
+
+
+void log_stop_async(void) {
+  if (!A.running) { return; }
+  __atomic_store_n(&A.running, false, __ATOMIC_RELEASE);
+  pthread_join(A.thread, NULL);
+}
+
+
+unsigned long log_dropped_count(void) {
+  return __atomic_load_n(&A.dropped, __ATOMIC_RELAXED);
+}
+
+
 void log_log(int level, const char *file, int line, const char *fmt, ...) {
+  if (__atomic_load_n(&A.running, __ATOMIC_ACQUIRE)) {
+    if (!is_enabled(level)) { return; }
+    va_list ap;
+    va_start(ap, fmt);
+    async_push(level, file, line, fmt, ap);
+    va_end(ap);
+    return;
+  }
+
   log_Event ev = {
     .fmt   = fmt,
     .file  = file,
@@ -30,11 +30,48 @@ typedef void (*log_LockFn)(bool lock, void *udata);
 
 enum { LOG_TRACE, LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR, LOG_FATAL };
 
+/* #if에서 쓸 수 있는 레벨 값 (위 enum과 같은 순서) */
+#define LOG_LEVEL_TRACE 0
+#define LOG_LEVEL_DEBUG 1
+#define LOG_LEVEL_INFO  2
+#define LOG_LEVEL_WARN  3
+#define LOG_LEVEL_ERROR 4
+#define LOG_LEVEL_FATAL 5
+
+/* 컴파일 시 로그 레벨 (CMake에서 빌드 타입별로 지정)
+ * 이보다 낮은 레벨의 log_* 매크로는 코드가 생성되지 않는다. 인자는 타입 검사만 하고 평가하지 않음.
+ * 디버그 전용 진단 코드는 #if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG 로 같이 감싼다. */
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_TRACE
+#endif
+
+#define log_disabled(...) do { if (0) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__); } while (0)
+
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_TRACE
 #define log_trace(...) log_log(LOG_TRACE, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define log_trace(...) log_disabled(__VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
 #define log_debug(...) log_log(LOG_DEBUG, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define log_debug(...) log_disabled(__VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_INFO
 #define log_info(...)  log_log(LOG_INFO,  __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define log_info(...)  log_disabled(__VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_WARN
 #define log_warn(...)  log_log(LOG_WARN,  __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define log_warn(...)  log_disabled(__VA_ARGS__)
+#endif
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_ERROR
 #define log_error(...) log_log(LOG_ERROR, __FILE__, __LINE__, __VA_ARGS__)
+#else
+#define log_error(...) log_disabled(__VA_ARGS__)
+#endif
 #define log_fatal(...) log_log(LOG_FATAL, __FILE__, __LINE__, __VA_ARGS__)
 
 const char* log_level_string(int level);
@@ -46,4 +83,10 @@ int log_add_fp(FILE *fp, int level);
 
 void log_log(int level, const char *file, int line, const char *fmt, ...);
 
+/* 비동기 모드: 호출한 스레드에서는 포맷만 해서 링 버퍼에 넣고, writer 스레드가 모아서 출력.
+ * 링 버퍼가 가득 차면 이벤트를 버리고 log_dropped_count()를 증가시킨다. */
+int log_start_async(void);
+void log_stop_async(void);
+unsigned long log_dropped_count(void);
+
 #endif
@@ -10,37 +10,123 @@
 #include <termios.h>
 #include <signal.h>
 #include <pthread.h>
+#include <getopt.h>
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#define CHIP8_HAS_EVENT_LOOP // epoll/timerfd/signalfd 기반 단일 스레드 실행 (Linux 전용)
+#endif
 
 
 #include "log.h"
 #include "errcode.h"
 #include "chip8.h"
+#include "libchip8.h"
+#include "opcodes.h"
+#include "keypad.h"
+#include "pacing.h"
+#include "render.h"
+#include "trace.h"
+#include "flight.h"
+#include "replay.h"
+#include "savestate.h"
+#include "rewind.h"
+#include "profile.h"
+#ifdef CHIP8_JIT
+#include "jit.h"
+#endif
+#ifdef CHIP8_AOT
+#include "aot.h"
+#endif
 
 #define NANOSECONDS_PER_SECOND 1000000000UL
-#define TICK_INTERVAL_NS       2000000UL
-#define LOG_INTERVAL_CYCLES    500
-#define TIMER_TICK_INTERVAL_NS (16666667L) // 16.666667ms in nanoseconds
-#define FONTSET_ADDR 0x50 // TODO: 이름 Base addr이 더 나은듯?
-#define FONT_SIZE 40 // 0x28, 8 byte
-#define PROGRAM_START_ADDR 0x200
-#define MEMORY_MAX_SIZE 0x4096
+#define LOG_INTERVAL_FRAMES    60
+#define FRAME_INTERVAL_NS      CHIP8_FRAME_INTERVAL_NS // 명령어는 60Hz 프레임 단위로 묶어서 실행
+#define ROM_MAX_SIZE (MEMORY_SIZE - PROGRAM_START_ADDR)
 #define LOG_LEVEL LOG_DEBUG
-// 입력 후 INPUT_TICK 값만큼 값을 유지. //TODO: 이름 바꾸기
-#define INPUT_TICK 50 // TICK_INTERVAL_NS(2ms) * 50 = 100ms
-
-#define PROJECT_PATH "/Users/bonditmanager/CLionProjects/c-chip-8/"
-#define ROM_PATH PROJECT_PATH "roms/"
+// 입력 후 INPUT_HOLD_NS 동안 키가 눌린 것으로 처리 (터미널은 키를 뗀 이벤트가 없음)
+#define INPUT_HOLD_NS 100000000UL // 100ms
+#define DEFAULT_IPS 500 // 초당 명령어 수 기본값, 예전 2ms 틱당 1개와 같은 속도
+#define INPUT_READ_SIZE 64 // 이벤트 루프에서 stdin을 한 번에 읽는 최대 바이트
+#define DEFAULT_TRACE_RECORDS (4UL << 20) // 트레이스 파일 기본 크기: 4M 레코드 = 64MB
+#define DEFAULT_REWIND_BUDGET_MB 8 // 되감기 버퍼 기본 크기, 보통 ROM은 수십 분 분량
+#define REWIND_STEP_FRAMES 60 // 되감기 키 한 번에 돌아가는 프레임 수 (1초)
+#define REWIND_KEY_DEL 0x7F // 되감기 키: Backspace (터미널에 따라 DEL 또는 BS)
+#define REWIND_KEY_BS  0x08
+
+#ifndef CHIP8_ROM_DIR
+#define CHIP8_ROM_DIR "roms"
+#endif
+#define ROM_PATH CHIP8_ROM_DIR "/"
+#define LOG_PATH "mylog.txt" // 로그 파일 기본 경로 (현재 디렉터리 기준)
+#define FLIGHT_DUMP_PATH "flight_recorder.txt" // 비정상 종료 시 플라이트 레코더 덤프 기본 경로 (현재 디렉터리 기준)
 
 /* 전역 상태 변수 */
 static struct {
-    bool quit; // 종료 플래그
+    bool quit; // 종료 플래그, 여러 스레드/시그널 핸들러에서 접근하므로 request_quit()/quit_requested()로만 접근
     errcode_t error_code; // 종료 시 에러 코드
-    // 키패드 상태를 저장하는 배열, 각 키의 잔여 틱 수를 저장
-    volatile uint8_t keypad[16];
+    uint64_t instructions; // 지금까지 실행한 명령어 수 (입력 기록/재생 기준)
+    uint64_t frames; // 지금까지 실행한 프레임 수 (기록/재생 중 키패드 시각 기준)
+    uint32_t frame_remaining; // 0이 아니면 프레임 중간에서 멈춘 상태, 다음 프레임은 남은 명령어만 실행
+    uint32_t rewind_requests; // 입력 스레드가 쌓은 되감기 요청 수, __atomic으로 접근
 } g_state = {
     .quit = false,
     .error_code = ERR_NONE,
-    .keypad = {0}
+    .instructions = 0,
+    .frames = 0,
+    .frame_remaining = 0,
+    .rewind_requests = 0
+};
+
+/* 실행 옵션, 명령행 인자로 지정 */
+static struct {
+    const char *rom_path; // NULL이면 기본 ROM
+    bool jit; // JIT 사용 여부 (CHIP8_JIT 빌드에서만 의미 있음)
+    bool aot; // AOT 변환 코드 사용 여부 (CHIP8_AOT 빌드에서만 의미 있음)
+    uint32_t ips; // 초당 명령어 수
+    bool unthrottled; // true면 프레임 사이에 대기하지 않음 (타이머는 ips 기준 에뮬레이션 시간으로 진행)
+    enum pacing_mode pacing; // 프레임 사이 대기 방식
+    bool event_loop; // true면 입력 스레드 없이 epoll 이벤트 루프로 실행 (CHIP8_HAS_EVENT_LOOP에서만)
+    bool async_log; // true면 로그는 writer 스레드가 출력 (에뮬레이션 스레드는 포맷만)
+    const char *log_path; // 로그 파일, NULL이면 기본값 (headless는 파일에 남기지 않음)
+    const char *trace_path; // NULL이 아니면 바이너리 트레이스 기록
+    const char *profile_path; // NULL이 아니면 명령어/주소별 프로파일을 모아서 종료 시 보고서 작성
+    uint64_t trace_records; // 트레이스 파일에 미리 할당할 레코드 수
+    const char *flight_path; // 비정상 종료 시 플라이트 레코더 덤프 경로
+    const char *record_path; // NULL이 아니면 난수 시드와 키 입력을 기록
+    const char *replay_path; // NULL이 아니면 기록한 파일대로 재생 (ips, 클리핑 설정도 파일을 따름)
+    const char *load_state_path; // NULL이 아니면 시작 시 세이브 스테이트 복원
+    const char *save_state_path; // NULL이 아니면 정상 종료 시 세이브 스테이트 저장
+    size_t rewind_budget; // 되감기 버퍼 크기 (바이트), 0이면 되감기 끔
+    uint32_t rewind_interval; // 되감기 keyframe 간격 (프레임)
+    bool clip_sprites; // true면 화면 밖으로 나가는 스프라이트 픽셀을 자름, false면 반대편으로 감쌈
+    bool headless; // true면 터미널/입력/화면/소리 없이 실행하고 종료 시 실행 결과를 stdout에 JSON으로 출력 (chip8-bench용)
+    uint64_t max_instructions; // 0이 아니면 이만큼 실행하고 종료
+} g_config = {
+    .rom_path = NULL,
+    .jit = true,
+    .aot = true,
+    .ips = DEFAULT_IPS,
+    .unthrottled = false,
+    .pacing = PACING_PRECISE,
+    .event_loop = false,
+    .async_log = false,
+    .log_path = NULL,
+    .trace_path = NULL,
+    .profile_path = NULL,
+    .trace_records = DEFAULT_TRACE_RECORDS,
+    .flight_path = FLIGHT_DUMP_PATH,
+    .record_path = NULL,
+    .replay_path = NULL,
+    .load_state_path = NULL,
+    .save_state_path = NULL,
+    .rewind_budget = (size_t) DEFAULT_REWIND_BUDGET_MB << 20,
+    .rewind_interval = REWIND_DEFAULT_INTERVAL,
+    .clip_sprites = false,
+    .headless = false,
+    .max_instructions = 0
 };
 
 // 필요에 따라 변경 가능
@@ -51,43 +137,73 @@ static const char KEY_MAPPING[16] = {
     'z', 'x', 'c', 'v' // C, D, E, F
 };
 
-// 뮤텍스 선언 - last_key 접근 시 사용
-static pthread_mutex_t input_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-static struct chip8 chip8;
-
-// CHIP-8 폰트 집합 (0–F, 총 16자 × 5바이트 = 80바이트)
-static const uint8_t chip8_fontset[80] = {
-    0xF0, 0x90, 0x90, 0x90, 0xF0, // 0
-    0x20, 0x60, 0x20, 0x20, 0x70, // 1
-    0xF0, 0x10, 0xF0, 0x80, 0xF0, // 2
-    0xF0, 0x10, 0xF0, 0x10, 0xF0, // 3
-    0x90, 0x90, 0xF0, 0x10, 0x10, // 4
-    0xF0, 0x80, 0xF0, 0x10, 0xF0, // 5
-    0xF0, 0x80, 0xF0, 0x90, 0xF0, // 6
-    0xF0, 0x10, 0x20, 0x40, 0x40, // 7
-    0xF0, 0x90, 0xF0, 0x90, 0xF0, // 8
-    0xF0, 0x90, 0xF0, 0x10, 0xF0, // 9
-    0xF0, 0x90, 0xF0, 0x90, 0x90, // A
-    0xE0, 0x90, 0xE0, 0x90, 0xE0, // B
-    0xF0, 0x80, 0x80, 0x80, 0xF0, // C
-    0xE0, 0x90, 0x90, 0x90, 0xE0, // D
-    0xF0, 0x80, 0xF0, 0x80, 0xF0, // E
-    0xF0, 0x80, 0xF0, 0x80, 0x80 // F
-};
+// 키보드 스레드 -> 에뮬레이션 스레드 키 입력 전달
+static struct keypad keypad;
+
+static struct chip8_ctx *vm; // 에뮬레이터 코어 (libchip8)
+
+static struct renderer renderer;
+
+static struct trace_writer trace; // header가 NULL이면 트레이스 꺼짐
+
+static struct flight_recorder flight; // 항상 켜져 있음, 비정상 종료 시에만 파일로 덤프
+
+static struct profiler profiler; // enabled가 false면 프로파일 꺼짐
+
+static struct replay replay; // 입력 기록/재생 상태, mode가 REPLAY_OFF면 사용 안 함
+
+// 입력 기록 중에는 입력 스레드가 이 키패드에 쓰고, 에뮬레이션 스레드가 프레임 경계에서 keypad로 옮기며 기록
+static struct keypad input_keypad;
+
+// 입력 스레드/이벤트 루프가 키 입력을 전달할 키패드, 재생 중에는 NULL (실제 입력 무시)
+static struct keypad *input_target = &keypad;
+
+static struct rewind rewind_buffer; // capacity가 0이면 되감기 꺼짐
+
+static struct savestate rewind_state; // 되감기 버퍼에 넣고 꺼낼 때 쓰는 상태
 
 static struct termios orig_term;
 
 /* 함수 선언 */
 errcode_t cycle(void);
 
-static errcode_t process_cycle_work(void);
+#ifdef CHIP8_HAS_EVENT_LOOP
+static errcode_t run_event_loop(void);
+#endif
 
-static errcode_t init_chip8(void);
+static errcode_t emulate_frame(uint32_t *executed);
 
-static uint64_t get_current_time_ns(errcode_t *errcode);
+static void process_input(const char *buf, size_t len, uint64_t now);
+
+static void begin_input_frame(uint64_t now);
+
+static void sync_keys(void);
+
+static errcode_t execute_replay_frame(uint32_t *budget, bool resumed);
+
+static void capture_state(struct savestate *state);
+
+static void restore_state(const struct savestate *state);
+
+static void apply_rewind_requests(void);
+
+static errcode_t save_state(const char *path);
 
-void update_timers(uint64_t tick_interval);
+static errcode_t load_state(const char *path);
+
+static errcode_t execute_instructions(uint32_t budget);
+
+static inline uint16_t read_opcode(uint16_t pc);
+
+static errcode_t parse_args(int argc, char *argv[]);
+
+#ifdef CHIP8_AOT
+static void init_aot(size_t rom_size);
+#endif
+
+static errcode_t init_chip8(uint64_t seed);
+
+static uint64_t get_current_time_ns(errcode_t *errcode);
 
 void enable_raw_mode();
 
@@ -99,132 +215,269 @@ void handle_sigint(int sig);
 
 int get_key_index(char key);
 
-void print_border(void);
-
-void print_display(const struct chip8 *chip);
+void sound_beep(void);
 
-void clear_display(void);
+static inline void request_quit(void) {
+    __atomic_store_n(&g_state.quit, true, __ATOMIC_RELEASE);
+}
 
-void sound_beep(void);
+static inline bool quit_requested(void) {
+    return __atomic_load_n(&g_state.quit, __ATOMIC_ACQUIRE);
+}
 
 /* 에러 처리 및 종료 매크로 */
 #define SET_ERROR_AND_EXIT(err_code) do { \
     g_state.error_code = (err_code); \
-    g_state.quit = true; \
+    request_quit(); \
     goto exit_cycle; \
 } while(0)
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    errcode_t arg_err = parse_args(argc, argv);
+    if (arg_err != ERR_NONE) {
+        return arg_err;
+    }
+
     // 로깅 전용 파일 생성 - 디스플레이 출력을 위해서 분리
-    const char *log_filename = "mylog.txt";
+    // headless는 여러 번 실행되고(chip8-bench, 테스트) 화면 출력이 없으므로 --log를 준 경우에만 파일에 남김
+    const char *log_path = g_config.log_path ? g_config.log_path : g_config.headless ? NULL : LOG_PATH;
+    if (log_path) {
+        FILE *logfile = fopen(log_path, "a");
+        if (!logfile) {
+            perror(log_path);
+            return 1;
+        }
+        log_add_fp(logfile, LOG_LEVEL);
+    }
+    //log_set_level(LOG_LEVEL);
+    // headless는 stdout을 결과 출력에 쓰고 여러 번 실행되므로 콘솔에는 경고 이상만
+    log_set_level(g_config.headless ? LOG_WARN : LOG_INFO);
+    if (g_config.async_log) {
+        if (log_start_async() == 0) {
+            // 종료 시 남은 로그를 모두 출력하고 writer 스레드 정리
+            atexit(log_stop_async);
+        } else {
+            log_warn("Async logging disabled: writer thread creation failed");
+        }
+    }
+    log_info("Program started");
 
-    char log_path[512];
+    // 랜덤 시드 설정, 재생이면 기록된 시드 사용
+    struct timespec seed_time;
+    clock_gettime(CLOCK_REALTIME, &seed_time);
+    uint64_t seed = (uint64_t) seed_time.tv_sec * NANOSECONDS_PER_SECOND + (uint64_t) seed_time.tv_nsec;
 
-    const size_t total_len = strlen(PROJECT_PATH) + strlen(log_filename);
-    assert(total_len < sizeof(log_path)); // 오버플로우 에러
-    snprintf(log_path, sizeof(log_path), "%s%s", PROJECT_PATH, log_filename);
+    if (g_config.replay_path) {
+        const errcode_t replay_err = replay_load(&replay, g_config.replay_path);
+        if (replay_err != ERR_NONE) {
+            return replay_err;
+        }
+        // 실행 결과에 영향을 주는 설정은 기록 당시 값으로
+        g_config.ips = replay.ips;
+        g_config.clip_sprites = replay.clip_sprites;
+        seed = replay.seed;
+        input_target = NULL;
+    } else if (g_config.record_path) {
+        const errcode_t record_err = replay_record_open(&replay, g_config.record_path, g_config.ips,
+                                                        g_config.clip_sprites, seed);
+        if (record_err != ERR_NONE) {
+            return record_err;
+        }
+        input_target = &input_keypad;
+    }
 
-    FILE *logfile = fopen(log_path, "a");
-    if (!logfile) {
-        perror("log file open error");
-        return 1;
+    if (!g_config.headless) {
+        // 터미널 설정
+        enable_raw_mode();
+        // 프로그램 종료 시 터미널 설정 복원 콜백함수 등록
+        atexit(disable_raw_mode);
     }
-    log_add_fp(logfile, LOG_LEVEL);
-    //log_set_level(LOG_LEVEL);
-    log_set_level(LOG_INFO);
-    log_info("Program started");
 
-    // 랜덤 시드 설정
-    srand(time(NULL));
+    // 키 입력 전달 버퍼는 키보드 스레드보다 먼저 초기화
+    keypad_init(&keypad, INPUT_HOLD_NS);
+    keypad_init(&input_keypad, INPUT_HOLD_NS);
 
-    // 터미널 설정
-    enable_raw_mode();
-    // 프로그램 종료 시 터미널 설정 복원 콜백함수 등록
-    atexit(disable_raw_mode);
-    // SIGINT 시그널 발생 (주로 ctrl+c) 시 사용자 정의 처리
-    signal(SIGINT, handle_sigint);
+    // 이벤트 루프 모드는 입력과 시그널을 루프 안에서 fd로 처리, headless는 입력 없음
+    if (!g_config.event_loop && !g_config.headless) {
+        // SIGINT 시그널 발생 (주로 ctrl+c) 시 사용자 정의 처리
+        signal(SIGINT, handle_sigint);
 
-    // 키보드 입력 스레드 생성
-    pthread_t kb_thread;
-    if (pthread_create(&kb_thread, NULL, keyboard_thread, NULL) != 0) {
-        log_error("Thread creation failed: %s", strerror(errno));
-        return ERR_THREAD_CREATION_FAILED;
+        // 키보드 입력 스레드 생성
+        pthread_t kb_thread;
+        if (pthread_create(&kb_thread, NULL, keyboard_thread, NULL) != 0) {
+            log_error("Thread creation failed: %s", strerror(errno));
+            return ERR_THREAD_CREATION_FAILED;
+        }
     }
 
     //chip8 초기화
-    errcode_t init_err = init_chip8();
+    errcode_t init_err = init_chip8(seed);
     if (init_err != ERR_NONE) {
         log_error("Abnormal termination: %d", init_err);
         return init_err;
     }
 
+    // 최근 실행 기록은 항상 남기고, abort/segfault 시 덤프
+    flight_init(&flight, chip8_machine_const(vm), g_config.flight_path);
+    flight_install_signal_handlers(&flight);
+    chip8_set_flight_recorder(vm, &flight);
+
+    if (g_config.load_state_path) {
+        init_err = load_state(g_config.load_state_path);
+        if (init_err != ERR_NONE) {
+            return init_err;
+        }
+    }
+
+    // 기록/재생 중에는 되감기가 입력 기록과 맞지 않으므로 끔
+    if (g_config.rewind_budget && replay.mode == REPLAY_OFF) {
+        init_err = rewind_init(&rewind_buffer, g_config.rewind_budget, g_config.rewind_interval);
+        if (init_err != ERR_NONE) {
+            return init_err;
+        }
+    }
+
+    if (g_config.trace_path) {
+        init_err = trace_open(&trace, g_config.trace_path, g_config.trace_records);
+        if (init_err != ERR_NONE) {
+            return init_err;
+        }
+    }
+
+    if (g_config.profile_path) {
+        profile_start(&profiler);
+    }
+
     // 에러 상태 초기화
-    g_state.quit = false;
     g_state.error_code = ERR_NONE;
 
+#ifdef CHIP8_HAS_EVENT_LOOP
+    errcode_t err = g_config.event_loop ? run_event_loop() : cycle();
+#else
     errcode_t err = cycle();
+#endif
+
+#ifdef CHIP8_JIT
+    jit_shutdown();
+#endif
+    trace_close(&trace);
+    if (profiler.enabled) {
+        // 에러로 끝났어도 그때까지의 프로파일은 남김
+        profile_report(&profiler, chip8_machine_const(vm), g_config.profile_path);
+    }
+    if (err == ERR_NONE && g_config.save_state_path) {
+        err = save_state(g_config.save_state_path);
+    }
+    replay_close(&replay, g_state.instructions);
+    rewind_report(&rewind_buffer);
+    rewind_free(&rewind_buffer);
 
     if (err != ERR_NONE) {
-        log_error("Abnormal termination: %d", err);
+        flight_dump(&flight, "error exit", err);
+        log_error("Abnormal termination: %d (flight recorder: %s)", err, g_config.flight_path);
         return err;
     }
+    chip8_destroy(vm);
 
     log_info("Program exited");
     return 0;
 }
 
 errcode_t cycle(void) {
-    const uint64_t tick_interval = TICK_INTERVAL_NS;
-    uint64_t max_cycle_ns = 0;
-    uint32_t cycle_count = 0;
+    const uint64_t frame_interval = FRAME_INTERVAL_NS;
+    const bool throttled = !g_config.unthrottled;
+    const bool render = !g_config.headless;
+    uint64_t max_batch_ns = 0;
+    uint64_t total_instructions = 0;
+    uint32_t frame_count = 0;
     uint32_t skip_count = 0;
+    struct pacer pacer;
+    uint64_t start_time = 0;
+    // 결과의 프레임 수는 완료한 프레임만 (frame_count는 중간에서 멈춘 마지막 프레임도 셈)
+    const uint64_t start_frames = g_state.frames;
     errcode_t err = ERR_NONE;
 
-    // 첫 tick 시간 설정
-    uint64_t next_tick = get_current_time_ns(&err);
+    if (!throttled) {
+        err = pacer_init(&pacer, PACING_EFFICIENT); // 대기하지 않으므로 통계 기준 시각만 사용
+    } else {
+        err = pacer_init(&pacer, g_config.pacing);
+    }
     if (err != ERR_NONE) {
         SET_ERROR_AND_EXIT(err);
     }
 
-    while (!g_state.quit) {
-        // 각 사이클 시작 시간 측정
-        const uint64_t cycle_start = get_current_time_ns(&err);
+    // 첫 프레임 시간 설정
+    start_time = get_current_time_ns(&err);
+    if (err != ERR_NONE) {
+        SET_ERROR_AND_EXIT(err);
+    }
+    if (render) {
+        render_init(&renderer, STDOUT_FILENO);
+    }
+    begin_input_frame(start_time);
+    uint64_t next_frame = start_time;
+    uint64_t batch_start = start_time;
+    uint64_t last_render = start_time;
+
+    while (!quit_requested()) {
+        // 작업 처리, 시간은 명령어마다가 아니라 프레임 배치 단위로만 측정
+        uint32_t budget;
+        err = emulate_frame(&budget);
         if (err != ERR_NONE) {
             SET_ERROR_AND_EXIT(err);
         }
+        total_instructions += budget;
 
-        // 작업 처리
-        err = process_cycle_work();
+        // 배치 종료 시간 측정
+        const uint64_t batch_end = get_current_time_ns(&err);
         if (err != ERR_NONE) {
             SET_ERROR_AND_EXIT(err);
         }
 
-        // 사이클 종료 시간 측정
-        const uint64_t cycle_end = get_current_time_ns(&err);
-        if (err != ERR_NONE) {
-            SET_ERROR_AND_EXIT(err);
+        const uint64_t batch_time_ns = batch_end - batch_start;
+
+        if (batch_time_ns > max_batch_ns) {
+            max_batch_ns = batch_time_ns;
+            log_info("Max batch time: %llu ns (%u instructions)", max_batch_ns, budget);
         }
 
-        const uint64_t cycle_time_ns = cycle_end - cycle_start;
+        if (throttled && batch_time_ns > frame_interval) {
+            // 프레임 간격보다 배치 수행 시간이 더 긴 경우
+            // 내부 작업은 시스템 콜을 포함하지 않으므로 이런 딜레이가 생기면 ips 설정이 호스트 성능보다 높은 것
+            log_error("Frame overrun: %llu ns > %llu ns (ips: %u)",
+                      batch_time_ns, frame_interval, g_config.ips);
+            SET_ERROR_AND_EXIT(ERR_TICK_TIMEOUT);
+        }
 
-        if (cycle_time_ns > max_cycle_ns) {
-            max_cycle_ns = cycle_time_ns;
-            log_info("Max cycle time: %llu ns", max_cycle_ns);
+        // 화면은 실제 시간 기준 60Hz까지만 갱신 (unthrottled에서 출력이 병목이 되지 않도록)
+        if (render && (throttled || batch_end - last_render >= frame_interval)) {
+            err = render_frame(&renderer, chip8_framebuffer(vm));
+            if (err != ERR_NONE) {
+                SET_ERROR_AND_EXIT(err);
+            }
+            last_render = batch_end;
         }
 
-        if (cycle_time_ns > tick_interval) {
-            // 틱 간격보다 사이클 수행 시간이 더 긴 경우
-            // 내부 작업은 시스템 콜을 포함하지 않으므로 이런 딜레이가 생기면 안되므로 바로 실패
-            log_error("Frame overrun: %llu ns > %llu ns",
-                      cycle_time_ns, tick_interval);
-            SET_ERROR_AND_EXIT(ERR_TICK_TIMEOUT);
+        // 정상적으로 실행된 프레임 카운트
+        ++frame_count;
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+        // 프레임/키패드 값 로깅 (특정 주기로)
+        if (frame_count % LOG_INTERVAL_FRAMES == 0) {
+            log_debug("frame: %u \t max: %llu \t exec: %llu \t skips: %u \t render: %u bytes",
+                      frame_count, max_batch_ns, batch_time_ns, skip_count, renderer.stats.last_bytes);
+            log_debug("Keypad: 0x%04X \t dropped events: %u", keypad_down_mask(&keypad),
+                      __atomic_load_n(&keypad.dropped, __ATOMIC_RELAXED));
         }
+#endif
 
-        // 다음 틱 구하기 - 이거 여기 있는게 맞나
-        update_timers(tick_interval);
+        if (!throttled) {
+            batch_start = batch_end;
+            begin_input_frame(batch_start);
+            continue;
+        }
 
-        // 다음 tick 계산
-        next_tick += tick_interval;
+        // 다음 프레임 계산
+        next_frame += frame_interval;
 
         // 현재 시간 확인
         uint64_t now = get_current_time_ns(&err);
@@ -232,460 +485,702 @@ errcode_t cycle(void) {
             SET_ERROR_AND_EXIT(err);
         }
 
-        // 누락된 틱 처리
-        if (now >= next_tick) {
-            // 누락된 틱 카운트 추가
-            uint64_t error_ns = now - next_tick;
-            uint32_t missed = (uint32_t) (error_ns / tick_interval) + 1;
+        // 누락된 프레임 처리
+        if (now >= next_frame) {
+            // 누락된 프레임 카운트 추가
+            const uint64_t error_ns = now - next_frame;
+            const uint32_t missed = (uint32_t) (error_ns / frame_interval) + 1;
             skip_count += missed;
-            log_error("Missed %u ticks (error: %llu ns). Total skips: %u",
+            log_error("Missed %u frames (error: %llu ns). Total skips: %u",
                       missed, error_ns, skip_count);
 
-            // 오차 누적 방지: next_tick 보정
-            next_tick += missed * tick_interval;
-
-            // 스킵된 사이클은 처리하지 않고 다음 사이클로
-            // TODO: 이거 뺴는게 맞을듯? 보정만 하고 성공 처리는 하긴 해야지
-            continue;
+            // 오차 누적 방지: next_frame 보정
+            next_frame += missed * frame_interval;
         }
 
-        // 다음 틱 시간까지 busy-wait
-        do {
-            now = get_current_time_ns(&err);
-            if (err != ERR_NONE) {
-                SET_ERROR_AND_EXIT(err);
-            }
-        } while (now < next_tick);
-
-        // 정상적으로 실행된 사이클 카운트
-        ++cycle_count;
-        if (cycle_count % LOG_INTERVAL_CYCLES == 0) {
-            const uint64_t exec_ns = cycle_end - cycle_start;
-            log_debug("cycle: %u \t max: %llu \t exec: %llu \t skips: %u",
-                      cycle_count, max_cycle_ns, exec_ns, skip_count);
+        // 다음 프레임 시간까지 대기
+        err = pacer_wait_until(&pacer, next_frame, &now);
+        if (err != ERR_NONE) {
+            SET_ERROR_AND_EXIT(err);
         }
+        batch_start = now;
+        // 대기 중에 들어온 키 입력 처리, 키 만료는 이 시각 기준
+        begin_input_frame(batch_start);
+    }
 
-        // 키패드 상태 업데이트: 눌린 키의 타이머 감소
-        pthread_mutex_lock(&input_mutex);
-        for (int i = 0; i < 16; i++) {
-            if (g_state.keypad[i] > 0) {
-                --g_state.keypad[i];
-            }
+exit_cycle:
+    {
+        errcode_t time_err;
+        const uint64_t elapsed_ns = get_current_time_ns(&time_err) - start_time;
+        const uint64_t frames = g_state.frames - start_frames;
+        if (time_err == ERR_NONE && total_instructions > 0 && elapsed_ns > 0) {
+            log_info("Executed %llu instructions in %llu frames, %.0f instructions/s",
+                     (unsigned long long) total_instructions, (unsigned long long) frames,
+                     (double) total_instructions * NANOSECONDS_PER_SECOND / (double) elapsed_ns);
         }
+        if (throttled) {
+            pacer_report(&pacer);
+        }
+        if (render) {
+            render_finish(&renderer);
+            render_report(&renderer);
+        } else if (time_err == ERR_NONE) {
+            // chip8-bench가 읽는 실행 결과, 시작/종료 처리 시간은 제외한 루프 시간만
+            // state_hash는 종료 시 머신 상태 해시 (chip8-farm의 인스턴스별 state_hash와 비교용)
+            printf("{\"instructions\": %llu, \"frames\": %llu, \"elapsed_ns\": %llu, \"state_hash\": \"0x%016llX\"}\n",
+                   (unsigned long long) total_instructions, (unsigned long long) frames,
+                   (unsigned long long) elapsed_ns,
+                   (unsigned long long) chip8_hash_machine(chip8_machine_const(vm)));
+            fflush(stdout);
+        }
+    }
+    return g_state.error_code;
+}
 
-        // 키패드 값 로깅 (특정 주기로)
-        if (cycle_count % 100 == 0) {
-            char keypad_log[128] = {0};
-            int offset = 0;
+// 프레임 하나 분량(ips / 60)의 명령어를 실행하고 60Hz 타이머 갱신
+// --max-instructions나 재생 종료로 프레임 중간에서 멈추면 타이머는 갱신하지 않고 남은 명령어 수를 기억 (세이브 스테이트에 저장)
+static errcode_t emulate_frame(uint32_t *executed) {
+    if (rewind_buffer.capacity) {
+        apply_rewind_requests();
+    }
 
-            offset += snprintf(keypad_log + offset,
-                               sizeof(keypad_log) - offset, "Keypad: [");
-            for (int i = 0; i < 16; i++) {
-                offset += snprintf(keypad_log + offset,
-                                   sizeof(keypad_log) - offset,
-                                   "%d%s", g_state.keypad[i],
-                                   (i < 15) ? ", " : "");
-            }
-            offset += snprintf(keypad_log + offset,
-                               sizeof(keypad_log) - offset, "]");
+    // 프레임 중간에서 저장한 상태를 복원했으면 그 프레임의 남은 명령어부터
+    const bool resumed = g_state.frame_remaining != 0;
+    const uint32_t frame_budget = resumed ? g_state.frame_remaining : chip8_frame_budget(vm);
+    uint32_t budget = frame_budget;
+    g_state.frame_remaining = 0;
+
+    if (g_config.max_instructions && g_state.instructions + budget >= g_config.max_instructions) {
+        budget = g_config.max_instructions > g_state.instructions
+                     ? (uint32_t) (g_config.max_instructions - g_state.instructions)
+                     : 0;
+        request_quit();
+    }
 
-            log_debug("%s", keypad_log);
+    flight_snapshot(&flight);
+    const errcode_t err = replay.mode == REPLAY_OFF
+                              ? execute_instructions(budget)
+                              : execute_replay_frame(&budget, resumed);
+    if (err != ERR_NONE) {
+        if (err == ERR_NO_SUPPORTED_OPCODE) {
+            // 에러 난 명령어 다음을 가리키는 pc
+            const struct chip8 *chip = chip8_machine_const(vm);
+            const uint16_t pc = (chip->pc - 2) & MEMORY_ADDR_MASK;
+            log_error("Unsupported opcode 0x%04x at 0x%03X", read_opcode(pc), pc);
         }
-        pthread_mutex_unlock(&input_mutex);
+        return err;
+    }
+    *executed = budget;
+    g_state.instructions += budget;
+    if (budget < frame_budget) {
+        g_state.frame_remaining = frame_budget - budget;
+        return ERR_NONE;
     }
+    ++g_state.frames;
 
-exit_cycle:
-    return g_state.error_code;
+    if (chip8_tick_timers(vm) && !g_config.headless) {
+        sound_beep();
+    }
+
+    if (rewind_buffer.capacity) {
+        capture_state(&rewind_state);
+        rewind_push(&rewind_buffer, g_state.frames, &rewind_state);
+    }
+    return ERR_NONE;
 }
 
-// 실제 작업 처리 함수 (현재는 더미 구현)
-static errcode_t process_cycle_work(void) {
-    const uint16_t opcode = (chip8.memory[chip8.pc] << 8)
-                            | chip8.memory[chip8.pc + 1];
-    log_trace("opcode 0x%04x", opcode);
+// 쌓인 되감기 요청만큼 이전 프레임으로 돌아감, 되감은 이후 기록은 버리고 그 지점부터 다시 진행
+static void apply_rewind_requests(void) {
+    const uint32_t requests = __atomic_exchange_n(&g_state.rewind_requests, 0, __ATOMIC_ACQ_REL);
+    if (!requests || rewind_empty(&rewind_buffer)) {
+        return;
+    }
+    const uint64_t newest = rewind_newest_frame(&rewind_buffer);
+    const uint64_t oldest = rewind_oldest_frame(&rewind_buffer);
+    const uint64_t step = (uint64_t) requests * REWIND_STEP_FRAMES;
+    const uint64_t target = newest - oldest > step ? newest - step : oldest;
+
+    if (rewind_seek(&rewind_buffer, target, &rewind_state)) {
+        restore_state(&rewind_state);
+        rewind_truncate(&rewind_buffer, target);
+        log_info("Rewound %llu frames to frame %llu", (unsigned long long) (newest - target),
+                 (unsigned long long) target);
+    }
+}
 
-    chip8.pc += 2;
+// 프레임 시작 시 키 입력 반영, 기록/재생 중에는 execute_replay_frame()이 에뮬레이션 시각 기준으로 처리
+static void begin_input_frame(const uint64_t now) {
+    if (replay.mode == REPLAY_OFF) {
+        keypad_begin_frame(&keypad, now);
+        sync_keys();
+    }
+}
 
-    //return ERR_NONE;
+// 키패드 상태를 코어에 전달, 프레임 안에서는 다음 전달 전까지 바뀌지 않음
+static void sync_keys(void) {
+    chip8_set_keys(vm, keypad_down_mask(&keypad), keypad.fresh);
+}
 
-    switch (opcode & 0xF000) {
-        case 0x0000: {
-            switch (opcode) {
-                case 0x00E0: {
-                    memset(chip8.display, 0, sizeof(chip8.display));
-                    break;
-                }
-                case 0x00EE: {
-                    chip8.pc = chip8.stack[chip8.sp];
-                    --chip8.sp;
-                    break;
-                }
-                default: {
-                    // 0NNN & default
-                    // 기계어 루틴 실행 - 구현 X
-                    /* This instruction is only used on the old computers
-                     * on which Chip-8 was originally implemented.
-                     * It is ignored by modern interpreters. */
-                    assert(false);
-                }
-            }
-            break;
-        }
-        case 0x1000: {
-            // 1nnn - JP addr
-            const u_int16_t nnn = opcode & 0x0FFF;
-            chip8.pc = nnn;
-            break;
-        }
-        case 0x2000: {
-            // 2nnn - CALL addr
-            ++chip8.sp;
-            chip8.stack[chip8.sp] = chip8.pc;
+// 기록/재생 프레임 시작 시 키 입력 반영, 이어서 실행하는 프레임이면 새로 눌린 키를 유지
+static void begin_replay_keys(const uint64_t frame_ns, const bool resumed) {
+    if (resumed) {
+        keypad_drain(&keypad);
+    } else {
+        keypad_begin_frame(&keypad, frame_ns);
+    }
+    sync_keys();
+}
 
-            const u_int16_t nnn = opcode & 0x0FFF;
-            chip8.pc = nnn;
-            break;
-        }
-        case 0x3000: {
-            // 3xkk - SE Vx, byte
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t nn = (opcode & 0x00FF); // 사실 & 없어도 될거같긴 함.
-            if (chip8.v[vx] == nn) {
-                chip8.pc += 2;
-            }
-            break;
+/*
+ * 기록/재생 중의 프레임 실행
+ * 키 입력은 명령어 수 기준으로만 반영하고, 키패드의 눌림/만료 시각도 벽시계 대신 에뮬레이션 시각(프레임 수)을 쓴다.
+ * 그래서 같은 기록은 대기 방식, --unthrottled, 이벤트 루프 여부와 상관없이 같은 명령어 수열을 만든다.
+ * - 기록: 지난 프레임 동안 들어온 입력을 이번 프레임 시작 위치에 넣고 그 위치를 기록
+ * - 재생: 기록된 위치까지 실행하고 입력을 넣는 것을 반복, 기록 종료 위치에서 종료 요청
+ * resumed면 프레임 중간에서 저장한 상태를 이어서 실행하는 것이라 프레임 시작 처리(새로 눌린 키 초기화)는 하지 않는다.
+ */
+static errcode_t execute_replay_frame(uint32_t *budget, const bool resumed) {
+    const uint64_t frame_ns = g_state.frames * FRAME_INTERVAL_NS;
+    const uint64_t start = g_state.instructions;
+
+    if (replay.mode == REPLAY_RECORD) {
+        struct key_event event;
+        while (keypad_pop(&input_keypad, &event)) {
+            replay_record_key(&replay, start, event.key);
+            keypad_press(&keypad, event.key, frame_ns);
         }
-        case 0x4000: {
-            // 4xkk - SNE Vx, byte
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t nn = (opcode & 0x00FF);
-            if (chip8.v[vx] != nn) {
-                chip8.pc += 2;
-            }
-            break;
-        }
-        case 0x5000: {
-            // 5xy0 - SE Vx, Vy
-            assert((opcode & 0x000F) == 0);
+        begin_replay_keys(frame_ns, resumed);
+        return execute_instructions(*budget);
+    }
 
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t vy = (opcode & 0x00F0) >> 4;
-            if (chip8.v[vx] == chip8.v[vy]) {
-                chip8.pc += 2;
+    if (replay.end != REPLAY_NO_END && replay.end - start <= *budget) {
+        *budget = replay.end > start ? (uint32_t) (replay.end - start) : 0;
+        log_info("Replay finished after %llu instructions", (unsigned long long) replay.end);
+        request_quit();
+    }
+
+    while (replay_next_instruction(&replay) <= start) {
+        keypad_press(&keypad, replay.events[replay.next++].key, frame_ns);
+    }
+    begin_replay_keys(frame_ns, resumed);
+
+    uint32_t done = 0;
+    while (done < *budget) {
+        const uint64_t now = start + done;
+        // 프레임 중간 위치의 입력 (직접 작성한 기록 파일에서만 생김)
+        if (replay_next_instruction(&replay) <= now) {
+            while (replay_next_instruction(&replay) <= now) {
+                keypad_press(&keypad, replay.events[replay.next++].key, frame_ns);
             }
-            break;
+            keypad_drain(&keypad);
+            sync_keys();
         }
-        case 0x6000: {
-            // 6xkk - LD Vx, byte
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t kk = (opcode & 0x00FF);
-            chip8.v[vx] = kk;
-            break;
+
+        uint32_t count = *budget - done;
+        const uint64_t next = replay_next_instruction(&replay);
+        if (next - now < count) {
+            count = (uint32_t) (next - now);
         }
-        case 0x7000: {
-            // 7xkk - ADD Vx, byte
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t kk = (opcode & 0x00FF);
-            chip8.v[vx] = chip8.v[vx] + kk;
-            break;
+        const errcode_t err = execute_instructions(count);
+        if (err != ERR_NONE) {
+            return err;
         }
-        case 0x8000: {
-            // 8xyn(N = 0-6, E)
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t vy = (opcode & 0x00F0) >> 4;
-            const uint8_t n = (opcode & 0x000F);
+        done += count;
+    }
+    return ERR_NONE;
+}
 
-            assert(n == 0 || n == 1 || n == 2 || n == 3 ||
-                n == 4 || n == 5 || n == 6 || n == 7 || n == 0xE);
+#ifdef CHIP8_HAS_EVENT_LOOP
+/*
+ * 단일 스레드 이벤트 루프
+ * - timerfd: 60Hz 프레임 (명령어 배치, 타이머, 화면 갱신)
+ * - stdin: non-blocking, 읽을 수 있을 때 여러 바이트를 한 번에 읽음
+ * - signalfd: SIGINT/SIGTERM을 fd로 받아서 루프 안에서 바로 종료
+ * 입력 스레드와 시그널 핸들러가 없으므로 종료는 다음 epoll_wait 반환 즉시 처리된다.
+ */
+static errcode_t run_event_loop(void) {
+    uint64_t total_instructions = 0;
+    uint32_t frame_count = 0;
+    uint32_t skip_count = 0;
+    int epoll_fd = -1;
+    int timer_fd = -1;
+    int signal_fd = -1;
+    bool stdin_open = true;
+    errcode_t err = ERR_NONE;
 
-            switch (n) {
-                case 0x00: {
-                    // 8xy0 - LD Vx, Vy
-                    chip8.v[vx] = chip8.v[vy];
-                    break;
-                }
-                case 0x01: {
-                    // 8xy1 - OR Vx, Vy
-                    chip8.v[vx] = chip8.v[vx] | chip8.v[vy];
-                    break;
-                }
-                case 0x02: {
-                    // 8xy2 - AND Vx, Vy
-                    chip8.v[vx] = chip8.v[vx] & chip8.v[vy];
-                    break;
-                }
-                case 0x03: {
-                    // 8xy3 - XOR Vx, Vy
-                    chip8.v[vx] = chip8.v[vx] ^ chip8.v[vy];
-                    break;
-                }
-                case 0x04: {
-                    // 8xy4 - ADD Vx, Vy
-                    uint16_t sum = chip8.v[vx] + chip8.v[vy];
+    sigset_t signals;
+    sigset_t old_signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigprocmask(SIG_BLOCK, &signals, &old_signals);
 
-                    // set VF = carry
-                    chip8.v[0xF] = (sum > 0xFF) ? 1 : 0;
+    const int stdin_flags = fcntl(STDIN_FILENO, F_GETFL);
+    fcntl(STDIN_FILENO, F_SETFL, stdin_flags | O_NONBLOCK);
 
-                    chip8.v[vx] = sum & 0xFF;
-                    break;
-                }
-                case 0x05: {
-                    // 8xy5 - SUB Vx, Vy
+    const uint64_t start_time = get_current_time_ns(&err);
+    if (err != ERR_NONE) {
+        SET_ERROR_AND_EXIT(err);
+    }
+    render_init(&renderer, STDOUT_FILENO);
+    begin_input_frame(start_time);
+
+    signal_fd = signalfd(-1, &signals, SFD_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (signal_fd < 0 || timer_fd < 0 || epoll_fd < 0) {
+        log_error("Event loop setup failed: %s", strerror(errno));
+        SET_ERROR_AND_EXIT(ERR_EVENT_LOOP_FAILED);
+    }
 
-                    // set VF = NOT borrow
-                    chip8.v[0xF] = (chip8.v[vx] > chip8.v[vy]);
+    const struct itimerspec frame_timer = {
+        .it_interval = {.tv_sec = 0, .tv_nsec = FRAME_INTERVAL_NS},
+        .it_value = {.tv_sec = 0, .tv_nsec = FRAME_INTERVAL_NS}
+    };
+    if (timerfd_settime(timer_fd, 0, &frame_timer, NULL) != 0) {
+        log_error("timerfd_settime failed: %s", strerror(errno));
+        SET_ERROR_AND_EXIT(ERR_EVENT_LOOP_FAILED);
+    }
 
-                    chip8.v[vx] = chip8.v[vx] - chip8.v[vy];
-                    break;
-                }
-                case 0x06: {
-                    // 8xy6 - SHR Vx {, Vy}
-                    // Shift Right, {, Vy}는 옵션. 일부 구현해서 사용함.
+    const int watched[] = {signal_fd, STDIN_FILENO, timer_fd};
+    for (size_t i = 0; i < sizeof(watched) / sizeof(watched[0]); i++) {
+        struct epoll_event ev = {.events = EPOLLIN, .data.fd = watched[i]};
+        if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, watched[i], &ev) != 0) {
+            // stdin이 일반 파일이면 epoll에 넣을 수 없음, 입력 없이 실행
+            if (watched[i] == STDIN_FILENO && errno == EPERM) {
+                stdin_open = false;
+                continue;
+            }
+            log_error("epoll_ctl failed: %s", strerror(errno));
+            SET_ERROR_AND_EXIT(ERR_EVENT_LOOP_FAILED);
+        }
+    }
 
-                    // set VF = least-significant bit
-                    chip8.v[0xF] = chip8.v[vx] & 0x1;
+    while (!quit_requested()) {
+        struct epoll_event events[4];
+        const int n = epoll_wait(epoll_fd, events, 4, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("epoll_wait failed: %s", strerror(errno));
+            SET_ERROR_AND_EXIT(ERR_EVENT_LOOP_FAILED);
+        }
 
-                    // Vx를 2로 나눔
-                    chip8.v[vx] = chip8.v[vx] >> 1;
-                    break;
-                }
-                case 0x07: {
-                    // 8xy7 - SUBN Vx, Vy
-                    // Subtract with Borrow
+        bool signal_ready = false;
+        bool input_ready = false;
+        bool frame_ready = false;
+        for (int i = 0; i < n; i++) {
+            signal_ready |= events[i].data.fd == signal_fd;
+            input_ready |= events[i].data.fd == STDIN_FILENO;
+            frame_ready |= events[i].data.fd == timer_fd;
+        }
 
-                    // set VF = NOT borrow
-                    chip8.v[0xF] = (chip8.v[vy] > chip8.v[vx]);
+        // 같은 시점에 깨어났으면 시그널 -> 입력 -> 프레임 순으로 처리
+        if (signal_ready) {
+            struct signalfd_siginfo info;
+            if (read(signal_fd, &info, sizeof(info)) == sizeof(info)) {
+                log_info("Signal %u received, exiting", info.ssi_signo);
+            }
+            request_quit();
+            break;
+        }
 
-                    chip8.v[vx] = chip8.v[vy] - chip8.v[vx];
-                    break;
+        if (input_ready && stdin_open) {
+            char buf[INPUT_READ_SIZE];
+            const ssize_t len = read(STDIN_FILENO, buf, sizeof(buf));
+            if (len > 0) {
+                const uint64_t now = get_current_time_ns(&err);
+                if (err != ERR_NONE) {
+                    SET_ERROR_AND_EXIT(err);
                 }
-                case 0x0E: {
-                    // 8xyE - SHL Vx {, Vy}
-                    // Shift Left
+                process_input(buf, (size_t) len, now);
+            } else if (len == 0 || (errno != EAGAIN && errno != EINTR)) {
+                // EOF: 더 이상 입력이 없으므로 감시 대상에서 제외 (계속 깨어나지 않도록)
+                epoll_ctl(epoll_fd, EPOLL_CTL_DEL, STDIN_FILENO, NULL);
+                stdin_open = false;
+            }
+        }
 
-                    // set VF = most significant bit
-                    chip8.v[0xF] = (chip8.v[vx] & 0x80) >> 7;
+        if (frame_ready) {
+            uint64_t expirations = 0;
+            if (read(timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations)) {
+                continue;
+            }
+            if (expirations > 1) {
+                // 프레임 처리가 늦어 타이머가 여러 번 만료된 경우, 밀린 프레임은 건너뜀
+                skip_count += (uint32_t) (expirations - 1);
+                log_error("Missed %llu frames. Total skips: %u",
+                          (unsigned long long) (expirations - 1), skip_count);
+            }
 
-                    // Vx를 2로 곱함
-                    chip8.v[vx] = chip8.v[vx] << 1;
-                    break;
-                }
-                default:
-                    assert(false);
+            const uint64_t now = get_current_time_ns(&err);
+            if (err != ERR_NONE) {
+                SET_ERROR_AND_EXIT(err);
             }
-            break;
-        }
-        case 0x9000: {
-            // 9xy0 - SNE Vx, Vy
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t vy = (opcode & 0x00F0) >> 4;
-            if (chip8.v[vx] != chip8.v[vy]) {
-                chip8.pc += 2;
+            begin_input_frame(now);
+
+            uint32_t executed;
+            err = emulate_frame(&executed);
+            if (err != ERR_NONE) {
+                SET_ERROR_AND_EXIT(err);
             }
-            break;
-        }
-        case 0xA000: {
-            // Annn - LD I, addr
-            const u_int16_t nnn = opcode & 0x0FFF;
-            chip8.i = nnn;
-            break;
-        }
-        case 0xB000: {
-            // Bnnn - JP V0, addr
-            const u_int16_t nnn = opcode & 0x0FFF;
-            chip8.pc = nnn + chip8.v[0];
-            break;
-        }
-        case 0xC000: {
-            // Cxkk - RND Vx, byte
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t kk = (opcode & 0x00FF);
-            chip8.v[vx] = (u_int8_t) (rand() % 256) & kk;
-            break;
-        }
-        case 0xD000: {
-            // Dxyn - DRW Vx, Vy, nibble: draw n-byte sprite at (Vx, Vy)
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t vy = (opcode & 0x00F0) >> 4;
-            const uint8_t n = (opcode & 0x000F);
+            total_instructions += executed;
 
-            const uint8_t x = chip8.v[vx];
-            const uint8_t y = chip8.v[vy];
-            assert(x < 64 && y < 32);
+            err = render_frame(&renderer, chip8_framebuffer(vm));
+            if (err != ERR_NONE) {
+                SET_ERROR_AND_EXIT(err);
+            }
 
-            bool is_collision = false;
-            for (uint8_t byte = 0; byte < n; ++byte) {
-                const uint8_t sprite_byte = chip8.memory[chip8.i + byte];
+            ++frame_count;
+#if LOG_COMPILE_LEVEL <= LOG_LEVEL_DEBUG
+            if (frame_count % LOG_INTERVAL_FRAMES == 0) {
+                log_debug("frame: %u \t skips: %u \t render: %u bytes \t keypad: 0x%04X",
+                          frame_count, skip_count, renderer.stats.last_bytes, keypad_down_mask(&keypad));
+            }
+#endif
+        }
+    }
 
-                // Y축 wrapping: 화면 아래를 넘어가면 위로
-                const uint8_t py = (y + byte) % 32;
+exit_cycle:
+    if (epoll_fd >= 0) {
+        close(epoll_fd);
+    }
+    if (timer_fd >= 0) {
+        close(timer_fd);
+    }
+    if (signal_fd >= 0) {
+        close(signal_fd);
+    }
+    fcntl(STDIN_FILENO, F_SETFL, stdin_flags);
+    sigprocmask(SIG_SETMASK, &old_signals, NULL);
+
+    {
+        errcode_t time_err;
+        const uint64_t elapsed_ns = get_current_time_ns(&time_err) - start_time;
+        if (time_err == ERR_NONE && total_instructions > 0 && elapsed_ns > 0) {
+            log_info("Executed %llu instructions in %u frames, %.0f instructions/s",
+                     (unsigned long long) total_instructions, frame_count,
+                     (double) total_instructions * NANOSECONDS_PER_SECOND / (double) elapsed_ns);
+        }
+        render_finish(&renderer);
+        render_report(&renderer);
+    }
+    return g_state.error_code;
+}
+#endif // CHIP8_HAS_EVENT_LOOP
 
-                for (uint8_t bit = 0; bit < 8; ++bit) {
-                    const uint8_t sprite_pixel =
-                            (sprite_byte >> (7 - bit)) & 0x1;
+// 메모리에서 opcode 읽기, pc는 4KB 안 (pc + 1은 감쌈)
+static inline uint16_t read_opcode(const uint16_t pc) {
+    const struct chip8 *chip = chip8_machine_const(vm);
+    return (uint16_t) ((chip->memory[pc] << 8) | chip->memory[(pc + 1) & MEMORY_ADDR_MASK]);
+}
 
-                    // 충돌 감지에서 이 값이 0인 경우를 고려하지 않아도 되고 연산이 줄어 효율적
-                    // XOR 연산은 특성 상 값이 0이라면 조기종료 가능
-                    if (!sprite_pixel) continue;
+#ifdef CHIP8_AOT
+/*
+ * AOT 변환 코드 실행
+ * 로드된 ROM이 변환에 쓴 ROM과 같을 때만 사용한다.
+ * 메모리 쓰기가 있었던 페이지는 실행 전에 opcode가 변환 당시와 같은지 확인하고, 다르면 인터프리터로 실행.
+ */
+static bool aot_enabled = false;
+static uint64_t aot_written_pages = 0;
+
+static void init_aot(const size_t rom_size) {
+    const struct aot_program *prog = &chip8_aot_program;
+
+    aot_written_pages = 0;
+    aot_enabled = false;
+    if (!g_config.aot) {
+        return;
+    }
+    if (rom_size != prog->rom_size
+        || memcmp(chip8_machine_const(vm)->memory + PROGRAM_START_ADDR, prog->rom, prog->rom_size) != 0) {
+        log_warn("AOT disabled: loaded ROM differs from compiled ROM (%s)", prog->rom_name);
+        return;
+    }
+    aot_enabled = true;
+    log_info("AOT code enabled for %s", prog->rom_name);
+}
 
-                    // X축 wrapping: 화면 우측을 넘어가면 좌측으로
-                    const uint8_t px = (x + bit) % 64;
+static inline aot_insn_fn aot_lookup(const uint16_t pc) {
+    const aot_insn_fn fn = chip8_aot_program.code[pc];
+    if (fn && (aot_written_pages & (1ULL << (pc >> CODE_PAGE_SHIFT)))) {
+        if (read_opcode(pc) != chip8_aot_program.opcodes[pc]) {
+            return NULL;
+        }
+    }
+    return fn;
+}
+#endif // CHIP8_AOT
+
+// 명령어가 결과를 쓰는 V 레지스터가 x인지 (트레이스 레코드의 reg 필드)
+static const bool trace_writes_vx[CHIP8_OP_COUNT] = {
+    [CHIP8_OP_LD_VX_KK] = true, [CHIP8_OP_ADD_VX_KK] = true, [CHIP8_OP_LD_VX_VY] = true,
+    [CHIP8_OP_OR] = true, [CHIP8_OP_AND] = true, [CHIP8_OP_XOR] = true,
+    [CHIP8_OP_ADD_VX_VY] = true, [CHIP8_OP_SUB] = true, [CHIP8_OP_SHR] = true,
+    [CHIP8_OP_SUBN] = true, [CHIP8_OP_SHL] = true, [CHIP8_OP_RND] = true,
+    [CHIP8_OP_LD_VX_DT] = true, [CHIP8_OP_LD_VX_K] = true, [CHIP8_OP_LD_VX_MEM] = true
+};
 
-                    // 버퍼 인덱스 계산: 몇 행 몇 바이트
-                    const uint16_t byte_index = (py * 64 + px) / 8;
-                    const uint8_t bit_mask = 1 << (7 - (px % 8));
+// 트레이스 모드: 명령어마다 레코드를 남겨야 하므로 AOT/JIT 없이 인터프리터로 하나씩 실행
+static errcode_t execute_traced(const uint32_t budget) {
+    const struct chip8 *chip = chip8_machine_const(vm);
+    for (uint32_t executed = 0; executed < budget; executed++) {
+        const uint16_t pc = chip->pc;
+        const struct chip8_insn *in = chip8_next_insn(vm);
+        // 실행 중에 명령어가 자기 자신을 덮어쓸 수 있으므로 필요한 값은 먼저 복사
+        const uint16_t opcode = in->opcode;
+        const uint8_t op = in->op;
+        const uint8_t x = in->x;
+
+        const errcode_t err = chip8_step(vm, 1);
+
+        struct trace_record *record = trace_next(&trace);
+        if (record) {
+            record->cycle_lo = (uint32_t) trace.cycle;
+            record->cycle_hi = (uint8_t) (trace.cycle >> 32);
+            record->pc = pc;
+            record->opcode = opcode;
+            record->i = chip->i;
+            record->reg = trace_writes_vx[op] ? x : TRACE_NO_REG;
+            record->value = chip->v[x];
+            record->vf = chip->v[0xF];
+            record->sp = chip->sp;
+            record->reserved = 0;
+            trace_commit(&trace);
+        } else if (!trace.full_reported) {
+            log_warn("Trace file full after %llu records, tracing stopped", (unsigned long long) trace.count);
+            trace.full_reported = true;
+        }
+        ++trace.cycle;
 
-                    // 충돌 감지: 기존 픽셀이 켜져 있는지
-                    if (chip8.display[byte_index] & bit_mask) {
-                        is_collision = true;
-                    }
-                    // XOR 그리는 이유는 그냥 요구사항임
-                    chip8.display[byte_index] ^= bit_mask;
-                }
-            }
-            // VF에 충돌 플래그 기록
-            chip8.v[0xF] = is_collision ? 1 : 0;
-            break;
+        if (err != ERR_NONE) {
+            return err;
         }
-        case 0xE000: {
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            const uint8_t keypad_idx = chip8.v[vx];
+    }
+    return ERR_NONE;
+}
 
-            if ((opcode & 0x00FF) == 0x009E) {
-                // Ex9E - SKP Vx
+// 프로파일 모드: 명령어마다 세야 하므로 AOT/JIT 없이 인터프리터로 하나씩 실행
+// 호스트 시간은 코어 호출(fetch, 플라이트 레코더 기록 포함)까지 잼
+static errcode_t execute_profiled(const uint32_t budget) {
+    const struct chip8 *chip = chip8_machine_const(vm);
+    for (uint32_t executed = 0; executed < budget; executed++) {
+        const uint16_t pc = chip->pc;
+        const struct chip8_insn *in = chip8_next_insn(vm);
+        const uint8_t op = in->op; // 실행 중에 자기 자신을 덮어쓸 수 있으므로 먼저 복사
+        profile_count(&profiler, pc, in, chip->i);
 
-                pthread_mutex_lock(&input_mutex);
-                bool key_pressed = (g_state.keypad[keypad_idx] > 0);
-                pthread_mutex_unlock(&input_mutex);
+        const uint64_t start = profile_clock();
+        const errcode_t err = chip8_step(vm, 1);
+        profiler.op_ticks[op] += profile_clock() - start;
 
-                if (key_pressed) {
-                    chip8.pc += 2;
-                }
-                break;
-            }
-            if ((opcode & 0x00FF) == 0x00A1) {
-                // ExA1 - SKNP Vx
+        if (err != ERR_NONE) {
+            return err;
+        }
+    }
+    return ERR_NONE;
+}
 
-                pthread_mutex_lock(&input_mutex);
-                bool key_not_pressed = (g_state.keypad[keypad_idx] == 0);
-                pthread_mutex_unlock(&input_mutex);
+#if defined(CHIP8_AOT) || defined(CHIP8_JIT)
+static uint64_t written_pages; // 코어가 메모리에 쓴 페이지 (chip8_set_write_watch())
 
-                if (key_not_pressed) {
-                    chip8.pc += 2;
-                }
-                break;
+// 코어가 메모리에 쓴 페이지를 번역된 코드(AOT/JIT)에 알림
+static inline void sync_written_pages(void) {
+    if (!written_pages) {
+        return;
+    }
+#ifdef CHIP8_AOT
+    aot_written_pages |= written_pages;
+#endif
+#ifdef CHIP8_JIT
+    jit_notify_write(written_pages);
+#endif
+    written_pages = 0;
+}
+
+// AOT 변환 코드 > JIT 블록 > 인터프리터 순으로 사용, JIT 블록은 budget 안에 다 들어갈 때만 사용
+// 번역된 코드는 메모리에 쓰지 않으므로 인터프리터로 실행한 명령어 뒤에만 쓰기 페이지를 확인
+static errcode_t execute_native(const uint32_t budget) {
+    struct chip8 *chip = chip8_machine(vm);
+    uint32_t executed = 0;
+    sync_written_pages();
+    while (executed < budget) {
+#ifdef CHIP8_AOT
+        if (aot_enabled && chip->pc <= MEMORY_ADDR_MASK) {
+            const aot_insn_fn fn = aot_lookup(chip->pc);
+            if (fn) {
+                flight_record(&flight, flight.head, chip->pc, read_opcode(chip->pc), chip->i, 1);
+                fn(chip);
+                ++executed;
+                continue;
             }
-            break;
         }
-        case 0xF000: {
-            const uint8_t vx = (opcode & 0x0F00) >> 8;
-            switch (opcode & 0x00FF) {
-                case 0x0007: {
-                    // Fx07 - LD Vx, DT
-                    chip8.v[vx] = chip8.delay_timer;
-                    break;
-                }
-                case 0x000A: {
-                    // Fx0A - LD Vx, K
-                    const uint8_t vx = (opcode & 0x0F00) >> 8;
-                    u_int8_t pressed_key_idx = (u_int8_t) -1;
-
-                    pthread_mutex_lock(&input_mutex);
-                    // 신규 입력이 존재하는지 확인
-                    for (int i = 0; i < 16; ++i) {
-                        if (g_state.keypad[i] == INPUT_TICK) {
-                            pressed_key_idx = i;
-                            break; // 첫 번째 발견된 키를 사용
-                        }
-                    }
-                    pthread_mutex_unlock(&input_mutex);
-
-                    if (pressed_key_idx != -1) {
-                        chip8.v[vx] = pressed_key_idx;
-                    } else {
-                        // 신규 입력이 없으면 이 명령어를 다시 수행하도록 pc값 수정
-                        chip8.pc -= 2;
-                    }
-                    break;
-                }
-                case 0x0015: {
-                    // Fx15 - LD DT, Vx
-                    chip8.delay_timer = chip8.v[vx];
-                    break;
-                }
-                case 0x0018: {
-                    // Fx18 - LD ST, Vx
-                    chip8.sound_timer = chip8.v[vx];
-                    break;
-                }
-                case 0x001E: {
-                    // Fx1E - ADD I, Vx
-                    chip8.i += chip8.v[vx];
-                    break;
-                }
-                case 0x0029: {
-                    // Fx29 - LD F, Vx
-
-                    // 각 문자는 5바이트
-                    chip8.i = FONTSET_ADDR + (chip8.v[vx] * FONT_SIZE / 8);
-                    break;
-                }
-                case 0x0033: {
-                    // Fx33 - LD B, Vx
-                    chip8.memory[chip8.i] = chip8.v[vx] / 100;
-                    chip8.memory[chip8.i + 1] = (chip8.v[vx] % 100) / 10;
-                    chip8.memory[chip8.i + 2] = chip8.v[vx] % 10;
-                    break;
-                }
-                case 0x0055: {
-                    // Fx55 - LD [I], Vx
-                    for (uint8_t r = 0; r <= vx; r++) {
-                        chip8.memory[chip8.i + r] = chip8.v[r];
-                    }
-                    break;
-                }
-                case 0x0065: {
-                    // Fx65 - LD Vx, [I]
-                    for (uint8_t r = 0; r <= vx; r++) {
-                        chip8.v[r] = chip8.memory[chip8.i + r];
-                    }
-                    break;
-                }
-                default:
-                    return ERR_NO_SUPPORTED_OPCODE;
+#endif
+#ifdef CHIP8_JIT
+        // 4KB 밖의 pc는 인터프리터가 주소를 감싸서 처리하므로 JIT 대상에서 제외
+        if (g_config.jit && chip->pc <= MEMORY_ADDR_MASK) {
+            const struct jit_block *block = jit_get_block(chip, chip->pc);
+            if (block->fn && block->count <= budget - executed) {
+                flight_record(&flight, flight.head, chip->pc, read_opcode(chip->pc), chip->i, block->count);
+                block->fn(chip);
+                executed += block->count;
+                continue;
             }
-            break;
         }
+#endif
+        const errcode_t err = chip8_step(vm, 1);
+        if (err != ERR_NONE) {
+            return err;
+        }
+        sync_written_pages();
+        ++executed;
     }
     return ERR_NONE;
 }
+#endif
 
-static errcode_t init_chip8(void) {
-    memset(&chip8, 0, sizeof(chip8));
+// budget 개의 명령어 실행
+static errcode_t execute_instructions(const uint32_t budget) {
+    if (trace.header) {
+        return execute_traced(budget);
+    }
+    if (profiler.enabled) {
+        return execute_profiled(budget);
+    }
+#ifdef CHIP8_AOT
+    if (aot_enabled) {
+        return execute_native(budget);
+    }
+#endif
+#ifdef CHIP8_JIT
+    if (g_config.jit) {
+        return execute_native(budget);
+    }
+#endif
+    return chip8_step(vm, budget);
+}
+
+/*
+ * 세이브 스테이트
+ * 저장은 mmap한 파일에 상태를 바로 채우고, 복원은 mmap한 파일에서 struct chip8을 한 번에 복사한다.
+ * 키패드 시각은 현재 키패드 기준 시각(기록/재생 중에는 에뮬레이션 시각) 대비 상대값으로 저장한다.
+ * 되감기 버퍼도 같은 구조체를 쓰지만 키패드는 저장/복원하지 않는다. (지금 누르고 있는 키 유지)
+ */
+static void capture_state(struct savestate *state) {
+    struct chip8_state core;
+    chip8_get_state(vm, &core);
+    state->ips = g_config.ips;
+    state->clip_sprites = g_config.clip_sprites;
+    state->instructions = g_state.instructions;
+    state->frames = g_state.frames;
+    state->rng_state = core.rng_state;
+    state->timer_accumulator_ns = core.timer_accumulator_ns;
+    state->ips_remainder = core.ips_remainder;
+    state->frame_remaining = g_state.frame_remaining;
+    state->chip = core.chip;
+}
+
+// 코어는 메모리 전체가 바뀐 것으로 보고 디코드 캐시를 비움, 번역된 코드는 다음 실행 때 sync_written_pages()로 무효화
+static void restore_state(const struct savestate *state) {
+    struct chip8_state core;
+    core.chip = state->chip;
+    core.rng_state = state->rng_state;
+    core.timer_accumulator_ns = state->timer_accumulator_ns;
+    core.ips_remainder = state->ips_remainder;
+    chip8_set_state(vm, &core);
+    g_state.instructions = state->instructions;
+    g_state.frames = state->frames;
+    g_state.frame_remaining = state->frame_remaining;
+}
+
+static errcode_t save_state(const char *path) {
+    struct savestate_file file;
+    const errcode_t err = savestate_create(&file, path);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    capture_state(file.state);
+    keypad_save(&keypad, &file.state->keypad);
+    savestate_close(&file);
 
-    chip8.pc = PROGRAM_START_ADDR;
+    log_info("Saved state to %s (%llu instructions)", path, (unsigned long long) g_state.instructions);
+    return ERR_NONE;
+}
 
-    memcpy(chip8.memory + FONTSET_ADDR, chip8_fontset, sizeof(chip8_fontset));
+static errcode_t load_state(const char *path) {
+    errcode_t err;
+    const uint64_t start = get_current_time_ns(&err);
 
-    const char *rom_filename = "Pong (1 player).ch8";
-    //const char *rom_filename = "Tetris [Fran Dachille, 1991].ch8";
+    struct savestate_file file;
+    err = savestate_open(&file, path);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    const struct savestate *state = file.state;
+    restore_state(state);
+    // 재생 중이면 복원한 위치 이전의 입력은 건너뜀
+    while (replay_next_instruction(&replay) < g_state.instructions) {
+        ++replay.next;
+    }
+    const uint64_t keypad_now = replay.mode != REPLAY_OFF ? g_state.frames * FRAME_INTERVAL_NS : start;
+    keypad_restore(&keypad, &state->keypad, keypad_now);
+    if (state->ips != g_config.ips || state->clip_sprites != g_config.clip_sprites) {
+        log_warn("Save state was taken with ips %u%s", state->ips, state->clip_sprites ? " --clip" : "");
+    }
+    savestate_close(&file);
+
+    const uint64_t end = get_current_time_ns(&err);
+    log_info("Restored state from %s (%llu instructions) in %llu ns", path,
+             (unsigned long long) g_state.instructions, (unsigned long long) (end - start));
+    return ERR_NONE;
+}
+
+static errcode_t init_chip8(const uint64_t seed) {
+    const struct chip8_config config = {
+        .ips = g_config.ips,
+        .clip_sprites = g_config.clip_sprites,
+        .seed = seed
+    };
+    vm = chip8_create(&config);
+    if (!vm) {
+        log_error("Failed to allocate the emulator core");
+        return ERR_UNKNOWN;
+    }
+
+#ifdef CHIP8_JIT
+    if (g_config.jit && !jit_init()) {
+        log_warn("JIT disabled: code buffer allocation failed");
+        g_config.jit = false;
+    }
+#endif
+
+    // ROM 경로를 인자로 받지 않으면 기본 ROM 사용
+    const char *rom_path = g_config.rom_path;
 
     const int DEST_SIZE = 512;
-    char rom_path[DEST_SIZE];
+    char default_rom_path[DEST_SIZE];
+
+    if (!rom_path) {
+        const char *rom_filename = "Pong (1 player).ch8";
+        //const char *rom_filename = "Tetris [Fran Dachille, 1991].ch8";
 
-    const size_t len_path = strlen(ROM_PATH);
-    const size_t len_file = strlen(rom_filename);
-    const size_t total_len = len_path + len_file;  // 널 문자는 아래에서 직접 추가
+        const size_t len_path = strlen(ROM_PATH);
+        const size_t len_file = strlen(rom_filename);
+        const size_t total_len = len_path + len_file;  // 널 문자는 아래에서 직접 추가
 
-    // 버퍼 오버플로우 방지: 널 문자 포함해서도 DEST_SIZE 이하인지 확인
-    assert(total_len + 1 <= DEST_SIZE);
+        // 버퍼 오버플로우 방지: 널 문자 포함해서도 DEST_SIZE 이하인지 확인
+        assert(total_len + 1 <= DEST_SIZE);
 
-    // 1) ROM_PATH 복사 (널 문자는 아직 붙이지 않음)
-    strncpy(rom_path, ROM_PATH, DEST_SIZE - 1);
-    // 2) rom_filename 복사 (남은 공간에)
-    strncpy(rom_path + len_path, rom_filename, DEST_SIZE - len_path - 1);
-    // 3) 마지막 바이트에 널 명시
-    rom_path[DEST_SIZE - 1] = '\0';
+        // 1) ROM_PATH 복사 (널 문자는 아직 붙이지 않음)
+        strncpy(default_rom_path, ROM_PATH, DEST_SIZE - 1);
+        // 2) rom_filename 복사 (남은 공간에)
+        strncpy(default_rom_path + len_path, rom_filename, DEST_SIZE - len_path - 1);
+        // 3) 마지막 바이트에 널 명시
+        default_rom_path[DEST_SIZE - 1] = '\0';
+
+        rom_path = default_rom_path;
+    }
 
     FILE *rom = fopen(rom_path, "rb");
     if (!rom) {
@@ -693,22 +1188,259 @@ static errcode_t init_chip8(void) {
         return ERR_FILE_NOT_FOUND;
     }
 
-    fseek(rom, 0, SEEK_END);
-    long rom_size = ftell(rom);
-    fseek(rom, 0, SEEK_SET);
-
-    size_t n = fread(chip8.memory + PROGRAM_START_ADDR, 1, rom_size, rom);
+    // 메모리에 들어가지 않는 ROM인지 알 수 있도록 1바이트 더 읽음
+    static uint8_t rom_data[ROM_MAX_SIZE + 1];
+    const size_t rom_size = fread(rom_data, 1, sizeof(rom_data), rom);
+    const bool read_failed = ferror(rom) != 0;
     fclose(rom);
-    if (n != (size_t) rom_size || n > MEMORY_MAX_SIZE) {
-        log_error("Abnormal ROM size: %ld", rom_size);
-        fclose(rom);
-        return ERR_ROM_TOO_LARGE;
+    if (read_failed) {
+        log_error("Failed to read ROM: %s", rom_path);
+        return ERR_FILE_NOT_FOUND;
     }
 
+    const errcode_t err = chip8_load_rom_mem(vm, rom_data, rom_size);
+    if (err != ERR_NONE) {
+        log_error("Abnormal ROM size: %zu bytes (max %d)", rom_size, ROM_MAX_SIZE);
+        return err;
+    }
+#if defined(CHIP8_AOT) || defined(CHIP8_JIT)
+    // 적재 이후의 메모리 쓰기만 번역된 코드에 알림
+    chip8_set_write_watch(vm, &written_pages);
+#endif
+
+#ifdef CHIP8_AOT
+    init_aot(rom_size);
+#endif
+
     return ERR_NONE;
 }
 
 
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] [rom]\n"
+            "  --no-jit    JIT를 끄고 인터프리터로만 실행\n"
+            "  --no-aot    AOT 변환 코드를 쓰지 않고 인터프리터로만 실행\n"
+            "  --ips=N     초당 명령어 수 (기본 %u, 최대 %u)\n"
+            "  --unthrottled\n"
+            "              프레임 사이에 대기하지 않고 최대 속도로 실행\n"
+            "  --pacing=MODE\n"
+            "              프레임 사이 대기 방식 (기본 precise)\n"
+            "                precise   sleep 후 보정된 짧은 구간만 spin, 지터 최소\n"
+            "                efficient sleep만 사용, CPU 사용 최소\n"
+            "  --clip      화면 밖으로 나가는 스프라이트를 자름 (기본: 반대편으로 감쌈)\n"
+#ifdef CHIP8_HAS_EVENT_LOOP
+            "  --event-loop\n"
+            "              입력 스레드 없이 epoll 이벤트 루프로 실행 (--unthrottled와 같이 쓸 수 없음)\n"
+#endif
+            "  --trace=FILE\n"
+            "              실행한 명령어를 바이너리 트레이스 파일로 기록 (chip8-tracedump로 확인)\n"
+            "  --trace-records=N\n"
+            "              트레이스 파일에 미리 할당할 레코드 수 (기본 %lu, 최대 %llu, 레코드당 16바이트)\n"
+            "  --profile=FILE\n"
+            "              명령어 종류/주소별 실행 횟수와 호스트 시간, 메모리 읽기/쓰기 분포를 모아서 종료 시 FILE에 보고서 작성\n"
+            "  --flight-dump=FILE\n"
+            "              에러 종료나 abort/segfault 시 최근 실행 기록을 쓸 파일 (기본 %s)\n"
+            "  --record=FILE\n"
+            "              난수 시드와 키 입력을 명령어 위치와 함께 기록\n"
+            "  --replay=FILE\n"
+            "              --record로 남긴 파일을 재생 (ips/--clip은 기록을 따르고 실제 키 입력은 무시)\n"
+            "  --load-state=FILE\n"
+            "              시작할 때 세이브 스테이트를 복원\n"
+            "  --save-state=FILE\n"
+            "              정상 종료할 때 세이브 스테이트를 저장\n"
+            "  --rewind-budget=MB\n"
+            "              되감기 버퍼 크기 (기본 %d, 0이면 끔). Backspace 한 번에 1초 되감기\n"
+            "  --rewind-interval=N\n"
+            "              되감기 keyframe 간격 (프레임, 기본 %d). 나머지 프레임은 keyframe과의 XOR 차이만 저장\n"
+            "  --headless  터미널/입력/화면/소리 없이 최대 속도로 실행, 종료 시 실행 결과를 stdout에 JSON으로 출력\n"
+            "  --max-instructions=N\n"
+            "              명령어 N개를 실행하고 종료\n"
+            "  --log=FILE  로그 파일 (기본 %s, --headless면 지정한 경우에만 기록)\n"
+            "  --async-log 로그를 writer 스레드에서 비동기로 출력, 에뮬레이션 스레드는 포맷만 함\n"
+            "              (기본: 호출한 스레드에서 바로 출력. abort/segfault 직전의 로그는 남지 않을 수 있음)\n"
+            "  -h, --help  도움말\n",
+            prog, DEFAULT_IPS, CHIP8_MAX_IPS, DEFAULT_TRACE_RECORDS, TRACE_MAX_RECORDS, FLIGHT_DUMP_PATH,
+            DEFAULT_REWIND_BUDGET_MB, REWIND_DEFAULT_INTERVAL, LOG_PATH);
+}
+
+static errcode_t parse_args(int argc, char *argv[]) {
+    enum { OPT_NO_JIT = 0x100, OPT_NO_AOT, OPT_IPS, OPT_UNTHROTTLED, OPT_PACING, OPT_CLIP, OPT_EVENT_LOOP, OPT_ASYNC_LOG, OPT_TRACE, OPT_TRACE_RECORDS, OPT_FLIGHT_DUMP, OPT_RECORD, OPT_REPLAY, OPT_SAVE_STATE, OPT_LOAD_STATE, OPT_REWIND_BUDGET, OPT_REWIND_INTERVAL, OPT_HEADLESS, OPT_MAX_INSTRUCTIONS, OPT_PROFILE, OPT_LOG };
+    static const struct option long_options[] = {
+        {"no-jit", no_argument, NULL, OPT_NO_JIT},
+        {"no-aot", no_argument, NULL, OPT_NO_AOT},
+        {"ips", required_argument, NULL, OPT_IPS},
+        {"unthrottled", no_argument, NULL, OPT_UNTHROTTLED},
+        {"pacing", required_argument, NULL, OPT_PACING},
+        {"clip", no_argument, NULL, OPT_CLIP},
+        {"event-loop", no_argument, NULL, OPT_EVENT_LOOP},
+        {"log", required_argument, NULL, OPT_LOG},
+        {"async-log", no_argument, NULL, OPT_ASYNC_LOG},
+        {"trace", required_argument, NULL, OPT_TRACE},
+        {"trace-records", required_argument, NULL, OPT_TRACE_RECORDS},
+        {"profile", required_argument, NULL, OPT_PROFILE},
+        {"flight-dump", required_argument, NULL, OPT_FLIGHT_DUMP},
+        {"record", required_argument, NULL, OPT_RECORD},
+        {"replay", required_argument, NULL, OPT_REPLAY},
+        {"save-state", required_argument, NULL, OPT_SAVE_STATE},
+        {"load-state", required_argument, NULL, OPT_LOAD_STATE},
+        {"rewind-budget", required_argument, NULL, OPT_REWIND_BUDGET},
+        {"rewind-interval", required_argument, NULL, OPT_REWIND_INTERVAL},
+        {"headless", no_argument, NULL, OPT_HEADLESS},
+        {"max-instructions", required_argument, NULL, OPT_MAX_INSTRUCTIONS},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case OPT_NO_JIT:
+                g_config.jit = false;
+                break;
+            case OPT_NO_AOT:
+                g_config.aot = false;
+                break;
+            case OPT_IPS: {
+                char *end;
+                errno = 0;
+                const unsigned long ips = strtoul(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || ips == 0 || ips > CHIP8_MAX_IPS) {
+                    fprintf(stderr, "Invalid --ips: %s\n", optarg);
+                    return ERR_INVALID_PARAMETER;
+                }
+                g_config.ips = (uint32_t) ips;
+                break;
+            }
+            case OPT_UNTHROTTLED:
+                g_config.unthrottled = true;
+                break;
+            case OPT_PACING:
+                if (pacing_parse_mode(optarg, &g_config.pacing) != ERR_NONE) {
+                    fprintf(stderr, "Invalid --pacing: %s\n", optarg);
+                    return ERR_INVALID_PARAMETER;
+                }
+                break;
+            case OPT_CLIP:
+                g_config.clip_sprites = true;
+                break;
+            case OPT_ASYNC_LOG:
+                g_config.async_log = true;
+                break;
+            case OPT_TRACE:
+                g_config.trace_path = optarg;
+                break;
+            case OPT_TRACE_RECORDS: {
+                char *end;
+                errno = 0;
+                const unsigned long long records = strtoull(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || records == 0 || records > TRACE_MAX_RECORDS) {
+                    fprintf(stderr, "Invalid --trace-records: %s (1..%llu)\n", optarg, TRACE_MAX_RECORDS);
+                    return ERR_INVALID_PARAMETER;
+                }
+                g_config.trace_records = records;
+                break;
+            }
+            case OPT_PROFILE:
+                g_config.profile_path = optarg;
+                break;
+            case OPT_FLIGHT_DUMP:
+                g_config.flight_path = optarg;
+                break;
+            case OPT_LOG:
+                g_config.log_path = optarg;
+                break;
+            case OPT_RECORD:
+                g_config.record_path = optarg;
+                break;
+            case OPT_REPLAY:
+                g_config.replay_path = optarg;
+                break;
+            case OPT_SAVE_STATE:
+                g_config.save_state_path = optarg;
+                break;
+            case OPT_LOAD_STATE:
+                g_config.load_state_path = optarg;
+                break;
+            case OPT_REWIND_BUDGET: {
+                char *end;
+                errno = 0;
+                const unsigned long mb = strtoul(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || mb > 4095) {
+                    fprintf(stderr, "Invalid --rewind-budget: %s\n", optarg);
+                    return ERR_INVALID_PARAMETER;
+                }
+                g_config.rewind_budget = (size_t) mb << 20;
+                break;
+            }
+            case OPT_REWIND_INTERVAL: {
+                char *end;
+                errno = 0;
+                const unsigned long frames = strtoul(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || frames == 0 || frames > 3600) {
+                    fprintf(stderr, "Invalid --rewind-interval: %s\n", optarg);
+                    return ERR_INVALID_PARAMETER;
+                }
+                g_config.rewind_interval = (uint32_t) frames;
+                break;
+            }
+            case OPT_HEADLESS:
+                g_config.headless = true;
+                break;
+            case OPT_MAX_INSTRUCTIONS: {
+                char *end;
+                errno = 0;
+                const unsigned long long count = strtoull(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || count == 0) {
+                    fprintf(stderr, "Invalid --max-instructions: %s\n", optarg);
+                    return ERR_INVALID_PARAMETER;
+                }
+                g_config.max_instructions = count;
+                break;
+            }
+            case OPT_EVENT_LOOP:
+#ifdef CHIP8_HAS_EVENT_LOOP
+                g_config.event_loop = true;
+                break;
+#else
+                fprintf(stderr, "--event-loop is only supported on Linux\n");
+                return ERR_INVALID_PARAMETER;
+#endif
+            case 'h':
+                print_usage(argv[0]);
+                exit(0);
+            default:
+                print_usage(argv[0]);
+                return ERR_INVALID_PARAMETER;
+        }
+    }
+    if (g_config.event_loop && g_config.unthrottled) {
+        fprintf(stderr, "--event-loop cannot be combined with --unthrottled\n");
+        return ERR_INVALID_PARAMETER;
+    }
+    if (g_config.record_path && g_config.replay_path) {
+        fprintf(stderr, "--record cannot be combined with --replay\n");
+        return ERR_INVALID_PARAMETER;
+    }
+    if (g_config.trace_path && g_config.profile_path) {
+        fprintf(stderr, "--trace cannot be combined with --profile\n");
+        return ERR_INVALID_PARAMETER;
+    }
+    if (g_config.headless) {
+        if (g_config.event_loop || g_config.record_path) {
+            fprintf(stderr, "--headless cannot be combined with --event-loop or --record\n");
+            return ERR_INVALID_PARAMETER;
+        }
+        // 입력이 없으므로 되감기도 쓰지 않음
+        g_config.unthrottled = true;
+        g_config.rewind_budget = 0;
+    }
+    if (optind < argc) {
+        g_config.rom_path = argv[optind];
+    }
+    return ERR_NONE;
+}
+
 static uint64_t get_current_time_ns(errcode_t *errcode) {
     assert(errcode != NULL);
 
@@ -725,51 +1457,40 @@ static uint64_t get_current_time_ns(errcode_t *errcode) {
     return (uint64_t) ts.tv_sec * NANOSECONDS_PER_SECOND + ts.tv_nsec;
 }
 
-//TODO: 굳이 함수로 뺄 필요까진 없었나 재사용하지도 않을껀데
-void update_timers(const uint64_t tick_interval) {
-    static u_int64_t accumulator = 0; // static이라 접근 제한된 전역 변수처럼 동작
-
-    accumulator += tick_interval;
-
-    //TODO: 1번 이상의 처리가 생기는 경우는 경고해야 하나? 느리게 수행되었다는거니까?
-    // 지금 호출에서는 고정된 tick_interval 값을 증가하니까 발생하지 않아서 굳이?
-    while (accumulator >= TIMER_TICK_INTERVAL_NS) {
-        if (chip8.sound_timer > 0) {
-            --chip8.sound_timer;
-            sound_beep();
-        }
-        if (chip8.delay_timer > 0) {
-            --chip8.delay_timer;
-        }
-        //TODO: 여기 리팩토링좀 하기
-        clear_display();
-        print_display(&chip8);
-        accumulator -= TIMER_TICK_INTERVAL_NS;
-    }
-}
-
 // 키보드 입력 처리 스레드 함수
 void *keyboard_thread(void *arg) {
     (void) arg;
-    while (!g_state.quit) {
+    while (!quit_requested()) {
         char c;
-        // blocking read: 입력이 들어올 때까지 대기
+        // VTIME만큼 입력을 기다림
         if (read(STDIN_FILENO, &c, 1) > 0) {
-            // C가 keypad 값 안에 속하는지 체크, 아니면 스킵
-            const int key_idx = get_key_index(c);
-            if (key_idx >= 0) {
-                pthread_mutex_lock(&input_mutex);
-                // INPUT_TICK 만큼 값을 설정
-                g_state.keypad[key_idx] = INPUT_TICK;
-                log_trace("key pressed: %c (ASCII: %d), keypad[%d] = %d",
-                          c, (int)c, key_idx, g_state.keypad[key_idx]);
-                pthread_mutex_unlock(&input_mutex);
+            errcode_t err;
+            const uint64_t now = get_current_time_ns(&err);
+            if (err == ERR_NONE) {
+                process_input(&c, 1, now);
             }
         }
     }
     return NULL;
 }
 
+// 읽은 입력 바이트를 키 눌림으로 전달, 키패드에 없는 문자는 무시
+static void process_input(const char *buf, const size_t len, const uint64_t now) {
+    for (size_t i = 0; i < len; i++) {
+        if ((buf[i] == REWIND_KEY_DEL || buf[i] == REWIND_KEY_BS) && input_target == &keypad) {
+            __atomic_add_fetch(&g_state.rewind_requests, 1, __ATOMIC_RELEASE);
+            continue;
+        }
+        const int key_idx = get_key_index(buf[i]);
+        if (key_idx >= 0) {
+            if (input_target) {
+                keypad_press(input_target, (uint8_t) key_idx, now);
+            }
+            log_trace("key pressed: %c (ASCII: %d), key %X", buf[i], (int) buf[i], key_idx);
+        }
+    }
+}
+
 // 입력된 키에 해당하는 CHIP-8 키패드 인덱스를 반환
 int get_key_index(char key) {
     // 대문자인 경우에만 소문자로 변환 (비트 OR 연산 사용)
@@ -793,7 +1514,7 @@ int get_key_index(char key) {
 void handle_sigint(int sig) {
     log_debug("here is handle_sigint()");
     (void) sig;
-    g_state.quit = true;
+    request_quit();
 }
 
 // 터미널 raw 모드 진입
@@ -809,7 +1530,9 @@ void enable_raw_mode() {
     raw.c_lflag &= ~(ECHO | ICANON | ISIG);
     // c_cc: control chars
     raw.c_cc[VMIN] = 0; //VMIN: 비캐논컬 모드에서 read()가 반환하기 위한 최소 바이트 수
-    raw.c_cc[VTIME] = 0; //VTIME: 비캐논컬 모드에서 read()가 타임아웃하기 전 대기 시간
+    // VTIME: 비캐논컬 모드에서 read()가 타임아웃하기 전 대기 시간 (0.1초 단위)
+    // 0이면 read()가 바로 반환해서 키보드 스레드가 코어 하나를 점유하므로 0.1초 대기
+    raw.c_cc[VTIME] = 1;
     // raw 설정을 STDIN_FILENO에 적용 (TCSANOW: 즉시 적용 flag)
     tcsetattr(STDIN_FILENO, TCSANOW, &raw);
 }
@@ -819,43 +1542,6 @@ void disable_raw_mode() {
     tcsetattr(STDIN_FILENO, TCSANOW, &orig_term);
 }
 
-void print_border(void) {
-    putchar('+');
-    for (int i = 0; i < DISPLAY_WIDTH * 2; i++)
-        putchar('-');
-    puts("+");
-}
-
-void print_display(const struct chip8 *chip) {
-    if (!chip) {
-        fputs("Error: Invalid chip8 pointer\n", stderr);
-        return;
-    }
-
-    print_border();
-
-    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
-        putchar('|');
-        int row_offset = y * DISPLAY_WIDTH_BYTES;
-
-        for (int x = 0; x < DISPLAY_WIDTH; x++) {
-            int byte_index = row_offset + (x >> 3);
-            int bit_index = 7 - (x & 7);
-            uint8_t pixel = (chip->display[byte_index] >> bit_index) & 1;
-            printf("%s", pixel ? PIXEL_ON_STR : PIXEL_OFF_STR);
-        }
-
-        puts("|");
-    }
-
-    print_border();
-}
-
-void clear_display(void) {
-    write(STDOUT_FILENO, "\x1b[2J", 4); // 전체 지우기
-    write(STDOUT_FILENO, "\x1b[H", 3); // 커서 홈
-}
-
 void sound_beep(void) {
     printf("\a"); // 비프 음 내기
     fflush(stdout); // 버퍼 비우기 - 바로 출력
@@ -0,0 +1,464 @@
+/*
+ * chip8-microbench: 명령어별 마이크로 벤치마크
+ *
+ * 명령어 종류마다 같은 계열의 opcode로 코드 영역을 채운 프로그램을 만들어 반복 실행하고 명령어당 ns를 잰다.
+ * 실행은 에뮬레이터와 같은 libchip8 코어(플라이트 레코더 기록 포함)로 하므로 명령어 하나를 고치면 그 항목에서만 차이가 보인다.
+ * clone 계열은 명령어 대신 인스턴스 복제(chip8_clone() + chip8_destroy(), chip8_copy()) 한 번의 ns를 잰다.
+ * hash 계열은 상태 해시(chip8_state_hash(), chip8_hash_machine())와 트랜스포지션 테이블 연산 한 번의 ns를 잰다.
+ * 메모리 쓰기/그리기 명령어 1개 실행 뒤의 chip8_state_hash()도 재서 바뀐 부분만 다시 계산하는 비용을 확인한다.
+ *
+ * 사용법: chip8-microbench [options]
+ *   --iterations=N  측정 한 번에 실행할 명령어 수
+ *   --repeat=N      측정 횟수 (중앙값/MAD 출력)
+ *   --filter=TEXT   이름에 TEXT가 들어간 항목만
+ */
+#include <errno.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "flight.h"
+#include "libchip8.h"
+#include "ttable.h"
+
+#define DEFAULT_ITERATIONS 2000000ULL
+#define DEFAULT_REPEAT 5
+#define MAX_REPEAT 100
+#define MICROBENCH_SEED 0x5EED5EED5EED5EEDULL
+
+// 코드는 [PROGRAM_START_ADDR, CODE_END), 끝에 처음으로 돌아가는 JP 두 개 (skip이 첫 번째를 건너뛸 수 있음)
+#define CODE_END   0xE00
+#define DATA_ADDR  0xE80 // Fx33/Fx55/Fx65/Dxyn이 쓰는 I, 코드와 다른 페이지
+#define DATA_SIZE  32
+#define IMAGE_END  (DATA_ADDR + DATA_SIZE) // ROM으로 적재하는 범위 [PROGRAM_START_ADDR, IMAGE_END)
+#define MAX_PATTERN 16
+#define CLONE_ITERATION_DIVISOR 100 // 복제는 명령어보다 훨씬 비싸므로 --iterations / 100번
+#define HASH_ITERATION_DIVISOR 10
+#define TTABLE_BENCH_CAPACITY (1 << 20)
+
+struct microbench_case {
+    const char *family;
+    const char *name;
+    uint16_t pattern[MAX_PATTERN]; // 코드 영역을 이 opcode들로 반복해서 채움
+    uint8_t pattern_len;
+    uint8_t v[16]; // 시작 레지스터 값, random_v면 난수로 채움
+    bool random_v;
+    bool clip_sprites;
+};
+
+/*
+ * 측정 항목
+ * ALU/메모리는 레지스터를 돌려가며 쓰고, skip은 분기 결과가 항상 같도록(taken/not taken) 레지스터를 정해둔다.
+ * Dxyn은 높이와 화면 경계(wrap/clip) 위치를 바꿔가며 측정한다.
+ */
+static const struct microbench_case cases[] = {
+    /* ALU 8xyN */
+    {"alu", "8xy0 LD", {0x8010, 0x8120, 0x8230, 0x8340, 0x8450, 0x8560, 0x8670, 0x8780}, 8, {0}, true, false},
+    {"alu", "8xy1 OR", {0x8011, 0x8121, 0x8231, 0x8341, 0x8451, 0x8561, 0x8671, 0x8781}, 8, {0}, true, false},
+    {"alu", "8xy2 AND", {0x8012, 0x8122, 0x8232, 0x8342, 0x8452, 0x8562, 0x8672, 0x8782}, 8, {0}, true, false},
+    {"alu", "8xy3 XOR", {0x8013, 0x8123, 0x8233, 0x8343, 0x8453, 0x8563, 0x8673, 0x8783}, 8, {0}, true, false},
+    {"alu", "8xy4 ADD", {0x8014, 0x8124, 0x8234, 0x8344, 0x8454, 0x8564, 0x8674, 0x8784}, 8, {0}, true, false},
+    {"alu", "8xy5 SUB", {0x8015, 0x8125, 0x8235, 0x8345, 0x8455, 0x8565, 0x8675, 0x8785}, 8, {0}, true, false},
+    {"alu", "8xy6 SHR", {0x8016, 0x8126, 0x8236, 0x8346, 0x8456, 0x8566, 0x8676, 0x8786}, 8, {0}, true, false},
+    {"alu", "8xy7 SUBN", {0x8017, 0x8127, 0x8237, 0x8347, 0x8457, 0x8567, 0x8677, 0x8787}, 8, {0}, true, false},
+    {"alu", "8xyE SHL", {0x801E, 0x812E, 0x823E, 0x834E, 0x845E, 0x856E, 0x867E, 0x878E}, 8, {0}, true, false},
+
+    /* skip: V0 = V1 = 0x12, V2 = 0x34 */
+    {"skip", "3xkk taken", {0x3012}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "3xkk not taken", {0x3212}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "4xkk taken", {0x4212}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "4xkk not taken", {0x4012}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "5xy0 taken", {0x5010}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "5xy0 not taken", {0x5020}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "9xy0 taken", {0x9020}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "9xy0 not taken", {0x9010}, 1, {0x12, 0x12, 0x34}, false, false},
+    {"skip", "mixed", {0x3012, 0x3212, 0x4212, 0x4012, 0x5010, 0x5020, 0x9020, 0x9010}, 8,
+     {0x12, 0x12, 0x34}, false, false},
+
+    /* 메모리: I = DATA_ADDR */
+    {"memory", "Fx33 BCD", {0xF033, 0xF133, 0xF233, 0xF333}, 4, {0}, true, false},
+    {"memory", "Fx55 x=0", {0xF055}, 1, {0}, true, false},
+    {"memory", "Fx55 x=7", {0xF755}, 1, {0}, true, false},
+    {"memory", "Fx55 x=F", {0xFF55}, 1, {0}, true, false},
+    {"memory", "Fx65 x=0", {0xF065}, 1, {0}, true, false},
+    {"memory", "Fx65 x=7", {0xF765}, 1, {0}, true, false},
+    {"memory", "Fx65 x=F", {0xFF65}, 1, {0}, true, false},
+
+    /* Dxyn: (V0, V1) 위치에 I = DATA_ADDR 스프라이트 */
+    {"draw", "Dxy1 (12,4)", {0xD011}, 1, {12, 4}, false, false},
+    {"draw", "Dxy8 (12,4)", {0xD018}, 1, {12, 4}, false, false},
+    {"draw", "Dxyf (12,4)", {0xD01F}, 1, {12, 4}, false, false},
+    {"draw", "Dxy8 x wrap (60,4)", {0xD018}, 1, {60, 4}, false, false},
+    {"draw", "Dxyf xy wrap (60,28)", {0xD01F}, 1, {60, 28}, false, false},
+    {"draw", "Dxyf xy clip (60,28)", {0xD01F}, 1, {60, 28}, false, true},
+
+    /* Cxkk */
+    {"random", "Cxkk", {0xC0FF, 0xC10F, 0xC2F0, 0xC3AA}, 4, {0}, false, false},
+};
+
+#define CASE_COUNT (sizeof(cases) / sizeof(cases[0]))
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b) {
+    const double x = *(const double *) a;
+    const double y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *values, const int count) {
+    qsort(values, (size_t) count, sizeof(*values), compare_double);
+    return count % 2 ? values[count / 2] : (values[count / 2 - 1] + values[count / 2]) / 2.0;
+}
+
+// 이름이 name인 명령어 항목 (hash_cases의 프로그램은 항상 있음)
+static const struct microbench_case *find_case(const char *name) {
+    size_t n = 0;
+    while (n + 1 < CASE_COUNT && strcmp(cases[n].name, name) != 0) {
+        n++;
+    }
+    return &cases[n];
+}
+
+static struct flight_recorder flight; // 에뮬레이터처럼 실행 기록을 남김 (덤프는 하지 않음)
+
+// 항목의 프로그램과 시작 상태를 적재한 인스턴스, 메모리가 부족하면 NULL
+static struct chip8_ctx *load_case(const struct microbench_case *c) {
+    const struct chip8_config config = {
+        .ips = 1,
+        .clip_sprites = c->clip_sprites,
+        .seed = MICROBENCH_SEED
+    };
+    struct chip8_ctx *ctx = chip8_create(&config);
+    if (!ctx) {
+        return NULL;
+    }
+
+    static uint8_t image[IMAGE_END - PROGRAM_START_ADDR];
+    memset(image, 0, sizeof(image));
+    uint16_t offset = 0;
+    for (unsigned n = 0; offset < CODE_END - PROGRAM_START_ADDR; n++, offset += 2) {
+        const uint16_t opcode = c->pattern[n % c->pattern_len];
+        image[offset] = (uint8_t) (opcode >> 8);
+        image[offset + 1] = (uint8_t) opcode;
+    }
+    for (int n = 0; n < 2; n++, offset += 2) {
+        image[offset] = 0x10 | (PROGRAM_START_ADDR >> 8);
+        image[offset + 1] = PROGRAM_START_ADDR & 0xFF;
+    }
+
+    // 레지스터와 데이터 영역(스프라이트, Fx65 원본)은 고정 시드 난수로
+    uint8_t v[16];
+    uint64_t state = MICROBENCH_SEED;
+    for (int n = 0; n < 16; n++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        v[n] = c->random_v ? (uint8_t) (state >> 56) : c->v[n];
+    }
+    for (int n = 0; n < DATA_SIZE; n++) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        image[DATA_ADDR - PROGRAM_START_ADDR + n] = (uint8_t) (state >> 56);
+    }
+
+    // 레지스터는 적재하면 초기화되므로 적재 후에 채움
+    chip8_load_rom_mem(ctx, image, sizeof(image));
+    struct chip8 *chip = chip8_machine(ctx);
+    memcpy(chip->v, v, sizeof(v));
+    chip->i = DATA_ADDR;
+
+    flight_init(&flight, chip, "");
+    chip8_set_flight_recorder(ctx, &flight);
+    return ctx;
+}
+
+// 명령어 count개 실행, chip8_step()은 한 번에 uint32_t개까지
+static errcode_t run(struct chip8_ctx *ctx, uint64_t count) {
+    while (count > 0) {
+        const uint32_t chunk = count > UINT32_MAX ? UINT32_MAX : (uint32_t) count;
+        const errcode_t err = chip8_step(ctx, chunk);
+        if (err != ERR_NONE) {
+            return err;
+        }
+        count -= chunk;
+    }
+    return ERR_NONE;
+}
+
+enum clone_mode {
+    CLONE_POOL,   // 풀 슬롯에 복제 후 풀로 반환
+    CLONE_MALLOC, // 풀 없이 복제 후 해제
+    CLONE_COPY    // 이미 있는 인스턴스에 복사
+};
+
+struct clone_case {
+    const char *name;
+    enum clone_mode mode;
+    uint64_t warmup; // 복제 전에 실행할 명령어 수, 디코드된 페이지 수가 달라짐
+};
+
+// 첫 항목(8xy0) 프로그램으로: 명령어 몇 개만 실행한 상태(디코드 캐시 1페이지)와 코드 영역 전체를 돈 상태(약 50페이지)
+static const struct clone_case clone_cases[] = {
+    {"clone pool, 1 page", CLONE_POOL, 16},
+    {"clone pool, all pages", CLONE_POOL, CODE_END},
+    {"clone malloc, 1 page", CLONE_MALLOC, 16},
+    {"copy, 1 page", CLONE_COPY, 16},
+    {"copy, all pages", CLONE_COPY, CODE_END}
+};
+
+#define CLONE_CASE_COUNT (sizeof(clone_cases) / sizeof(clone_cases[0]))
+
+// 복제 count번, 메모리가 부족하면 false
+static bool run_clones(const struct clone_case *c, struct chip8_ctx *src, struct chip8_pool *pool,
+                       struct chip8_ctx *scratch, const uint64_t count) {
+    for (uint64_t n = 0; n < count; n++) {
+        if (c->mode == CLONE_COPY) {
+            chip8_copy(scratch, src);
+            continue;
+        }
+        struct chip8_ctx *clone = chip8_clone(src, c->mode == CLONE_POOL ? pool : NULL);
+        if (!clone) {
+            return false;
+        }
+        chip8_destroy(clone);
+    }
+    return true;
+}
+
+enum hash_mode {
+    HASH_STATE,         // chip8_state_hash(): 바뀐 페이지/화면이 없을 때, 레지스터만 계산
+    HASH_STATE_STEP,    // 명령어 1개 실행 + chip8_state_hash(): 쓴 페이지/그린 화면을 다시 계산
+    HASH_MACHINE,       // chip8_hash_machine(): 4.4KB 전체
+    HASH_TTABLE_INSERT, // 새 키 넣기 (테이블이 차면 밀어내기 포함)
+    HASH_TTABLE_LOOKUP  // 있는 키 찾기
+};
+
+// program은 실행할 명령어 항목 이름, 실행을 포함한 항목은 그 명령어 항목의 ns를 빼면 해시 비용
+static const struct {
+    const char *name;
+    enum hash_mode mode;
+    const char *program;
+} hash_cases[] = {
+    {"chip8_state_hash", HASH_STATE, "8xy0 LD"},
+    {"Fx55 x=F + state_hash", HASH_STATE_STEP, "Fx55 x=F"},
+    {"Dxyf + state_hash", HASH_STATE_STEP, "Dxyf (12,4)"},
+    {"chip8_hash_machine", HASH_MACHINE, "8xy0 LD"},
+    {"ttable insert", HASH_TTABLE_INSERT, "8xy0 LD"},
+    {"ttable lookup hit", HASH_TTABLE_LOOKUP, "8xy0 LD"}
+};
+
+#define HASH_CASE_COUNT (sizeof(hash_cases) / sizeof(hash_cases[0]))
+
+static volatile uint64_t hash_sink; // 결과를 컴파일러가 없애지 못하게 함
+
+// 연산 count번
+static void run_hashes(const enum hash_mode mode, struct chip8_ctx *ctx, struct chip8_ttable *table,
+                       const uint64_t count, uint64_t *key) {
+    for (uint64_t n = 0; n < count; n++) {
+        uint64_t value = 0;
+        switch (mode) {
+            case HASH_STATE:
+                value = chip8_state_hash(ctx);
+                break;
+            case HASH_STATE_STEP:
+                chip8_step(ctx, 1);
+                value = chip8_state_hash(ctx);
+                break;
+            case HASH_MACHINE:
+                value = chip8_hash_machine(chip8_machine_const(ctx));
+                break;
+            case HASH_TTABLE_INSERT:
+                *key = *key * 6364136223846793005ULL + 1442695040888963407ULL;
+                value = chip8_ttable_insert(table, *key, n, NULL);
+                break;
+            case HASH_TTABLE_LOOKUP:
+                // 미리 넣어둔 키 (TTABLE_BENCH_CAPACITY / 2개)를 같은 순서로 다시 찾음
+                *key = *key * 6364136223846793005ULL + 1442695040888963407ULL;
+                chip8_ttable_lookup(table, *key, &value);
+                if ((n + 1) % (TTABLE_BENCH_CAPACITY / 2) == 0) {
+                    *key = MICROBENCH_SEED;
+                }
+                break;
+        }
+        hash_sink += value;
+    }
+}
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  --iterations=N  측정 한 번에 실행할 명령어 수 (기본 %llu)\n"
+            "  --repeat=N      측정 횟수 (기본 %d, 최대 %d)\n"
+            "  --filter=TEXT   계열/이름에 TEXT가 들어간 항목만 (예: draw, Fx55)\n",
+            prog, DEFAULT_ITERATIONS, DEFAULT_REPEAT, MAX_REPEAT);
+}
+
+int main(int argc, char *argv[]) {
+    enum { OPT_ITERATIONS = 0x100, OPT_REPEAT, OPT_FILTER };
+    static const struct option long_options[] = {
+        {"iterations", required_argument, NULL, OPT_ITERATIONS},
+        {"repeat", required_argument, NULL, OPT_REPEAT},
+        {"filter", required_argument, NULL, OPT_FILTER},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    uint64_t iterations = DEFAULT_ITERATIONS;
+    int repeat = DEFAULT_REPEAT;
+    const char *filter = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        char *end;
+        errno = 0;
+        switch (opt) {
+            case OPT_ITERATIONS:
+                iterations = strtoull(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || iterations == 0) {
+                    fprintf(stderr, "Invalid --iterations: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_REPEAT: {
+                const unsigned long value = strtoul(optarg, &end, 10);
+                if (errno != 0 || *end != '\0' || value == 0 || value > MAX_REPEAT) {
+                    fprintf(stderr, "Invalid --repeat: %s\n", optarg);
+                    return 1;
+                }
+                repeat = (int) value;
+                break;
+            }
+            case OPT_FILTER:
+                filter = optarg;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    printf("%-8s %-24s %10s %8s\n", "family", "case", "ns/op", "mad");
+    int failures = 0;
+    for (size_t n = 0; n < CASE_COUNT; n++) {
+        const struct microbench_case *c = &cases[n];
+        if (filter && !strstr(c->family, filter) && !strstr(c->name, filter)) {
+            continue;
+        }
+
+        struct chip8_ctx *ctx = load_case(c);
+        if (!ctx) {
+            fprintf(stderr, "%s: out of memory\n", c->name);
+            return 1;
+        }
+        // 디코드 캐시/분기 예측 준비
+        errcode_t err = run(ctx, iterations / 8 + 1);
+
+        double samples[MAX_REPEAT];
+        for (int r = 0; r < repeat && err == ERR_NONE; r++) {
+            const uint64_t start = now_ns();
+            err = run(ctx, iterations);
+            samples[r] = (double) (now_ns() - start) / (double) iterations;
+        }
+        chip8_destroy(ctx);
+        if (err != ERR_NONE) {
+            fprintf(stderr, "%s: error %d\n", c->name, err);
+            ++failures;
+            continue;
+        }
+
+        const double mid = median(samples, repeat);
+        for (int r = 0; r < repeat; r++) {
+            samples[r] = samples[r] > mid ? samples[r] - mid : mid - samples[r];
+        }
+        printf("%-8s %-24s %10.2f %8.2f\n", c->family, c->name, mid, median(samples, repeat));
+    }
+
+    const uint64_t clones = iterations / CLONE_ITERATION_DIVISOR + 1;
+    for (size_t n = 0; n < CLONE_CASE_COUNT; n++) {
+        const struct clone_case *c = &clone_cases[n];
+        if (filter && !strstr("clone", filter) && !strstr(c->name, filter)) {
+            continue;
+        }
+
+        struct chip8_ctx *src = load_case(&cases[0]);
+        struct chip8_ctx *scratch = load_case(&cases[0]);
+        struct chip8_pool *pool = chip8_pool_create();
+        bool ok = src && scratch && pool && run(src, c->warmup) == ERR_NONE;
+        if (ok) {
+            chip8_set_flight_recorder(scratch, NULL);
+            ok = run_clones(c, src, pool, scratch, clones / 8 + 1);
+        }
+
+        double samples[MAX_REPEAT];
+        for (int r = 0; r < repeat && ok; r++) {
+            const uint64_t start = now_ns();
+            ok = run_clones(c, src, pool, scratch, clones);
+            samples[r] = (double) (now_ns() - start) / (double) clones;
+        }
+        chip8_pool_destroy(pool);
+        chip8_destroy(scratch);
+        chip8_destroy(src);
+        if (!ok) {
+            fprintf(stderr, "%s: failed\n", c->name);
+            ++failures;
+            continue;
+        }
+
+        const double mid = median(samples, repeat);
+        for (int r = 0; r < repeat; r++) {
+            samples[r] = samples[r] > mid ? samples[r] - mid : mid - samples[r];
+        }
+        printf("%-8s %-24s %10.2f %8.2f\n", "clone", c->name, mid, median(samples, repeat));
+    }
+
+    const uint64_t hashes = iterations / HASH_ITERATION_DIVISOR + 1;
+    for (size_t n = 0; n < HASH_CASE_COUNT; n++) {
+        const enum hash_mode mode = hash_cases[n].mode;
+        if (filter && !strstr("hash", filter) && !strstr(hash_cases[n].name, filter)) {
+            continue;
+        }
+
+        // 해시는 코드 영역을 한 바퀴 돈 프로그램 상태로 (첫 해시의 전체 계산은 미리), 테이블은 조회할 키를 절반 채워둠
+        struct chip8_ctx *ctx = load_case(find_case(hash_cases[n].program));
+        struct chip8_ttable *table = chip8_ttable_create(TTABLE_BENCH_CAPACITY);
+        bool ok = ctx && table && run(ctx, CODE_END) == ERR_NONE;
+        if (ok) {
+            chip8_state_hash(ctx);
+        }
+        uint64_t key = MICROBENCH_SEED;
+        if (ok && mode == HASH_TTABLE_LOOKUP) {
+            run_hashes(HASH_TTABLE_INSERT, ctx, table, TTABLE_BENCH_CAPACITY / 2, &key);
+            key = MICROBENCH_SEED;
+        }
+
+        double samples[MAX_REPEAT];
+        for (int r = 0; r < repeat && ok; r++) {
+            const uint64_t start = now_ns();
+            run_hashes(mode, ctx, table, hashes, &key);
+            samples[r] = (double) (now_ns() - start) / (double) hashes;
+        }
+        chip8_ttable_destroy(table);
+        chip8_destroy(ctx);
+        if (!ok) {
+            fprintf(stderr, "%s: failed\n", hash_cases[n].name);
+            ++failures;
+            continue;
+        }
+
+        const double mid = median(samples, repeat);
+        for (int r = 0; r < repeat; r++) {
+            samples[r] = samples[r] > mid ? samples[r] - mid : mid - samples[r];
+        }
+        printf("%-8s %-24s %10.2f %8.2f\n", "hash", hash_cases[n].name, mid, median(samples, repeat));
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,129 @@
+#ifndef OPCODES_H
+#define OPCODES_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * CHIP-8 명령어 정의 (X-macro)
+ * X(이름, 마스크, 매칭 값, 피연산자 형태, 니모닉)
+ * - (opcode & 마스크) == 매칭 값 이면 해당 명령어
+ * - 위에서부터 순서대로 비교하므로 더 구체적인 명령어를 먼저 둔다. (00E0, 00EE가 0nnn보다 앞)
+ * 디스패치 엔진, 디코더 등은 모두 이 목록 하나에서 생성된다.
+ */
+#define CHIP8_OPCODES(X) \
+    X(CLS,       0xFFFF, 0x00E0, ARGS_NONE, "CLS")               \
+    X(RET,       0xFFFF, 0x00EE, ARGS_NONE, "RET")               \
+    X(SYS,       0xF000, 0x0000, ARGS_NNN,  "SYS 0x%03X")        \
+    X(JP,        0xF000, 0x1000, ARGS_NNN,  "JP 0x%03X")         \
+    X(CALL,      0xF000, 0x2000, ARGS_NNN,  "CALL 0x%03X")       \
+    X(SE_VX_KK,  0xF000, 0x3000, ARGS_XKK,  "SE V%X, 0x%02X")    \
+    X(SNE_VX_KK, 0xF000, 0x4000, ARGS_XKK,  "SNE V%X, 0x%02X")   \
+    X(SE_VX_VY,  0xF00F, 0x5000, ARGS_XY,   "SE V%X, V%X")       \
+    X(LD_VX_KK,  0xF000, 0x6000, ARGS_XKK,  "LD V%X, 0x%02X")    \
+    X(ADD_VX_KK, 0xF000, 0x7000, ARGS_XKK,  "ADD V%X, 0x%02X")   \
+    X(LD_VX_VY,  0xF00F, 0x8000, ARGS_XY,   "LD V%X, V%X")       \
+    X(OR,        0xF00F, 0x8001, ARGS_XY,   "OR V%X, V%X")       \
+    X(AND,       0xF00F, 0x8002, ARGS_XY,   "AND V%X, V%X")      \
+    X(XOR,       0xF00F, 0x8003, ARGS_XY,   "XOR V%X, V%X")      \
+    X(ADD_VX_VY, 0xF00F, 0x8004, ARGS_XY,   "ADD V%X, V%X")      \
+    X(SUB,       0xF00F, 0x8005, ARGS_XY,   "SUB V%X, V%X")      \
+    X(SHR,       0xF00F, 0x8006, ARGS_XY,   "SHR V%X, V%X")      \
+    X(SUBN,      0xF00F, 0x8007, ARGS_XY,   "SUBN V%X, V%X")     \
+    X(SHL,       0xF00F, 0x800E, ARGS_XY,   "SHL V%X, V%X")      \
+    X(SNE_VX_VY, 0xF00F, 0x9000, ARGS_XY,   "SNE V%X, V%X")      \
+    X(LD_I,      0xF000, 0xA000, ARGS_NNN,  "LD I, 0x%03X")      \
+    X(JP_V0,     0xF000, 0xB000, ARGS_NNN,  "JP V0, 0x%03X")     \
+    X(RND,       0xF000, 0xC000, ARGS_XKK,  "RND V%X, 0x%02X")   \
+    X(DRW,       0xF000, 0xD000, ARGS_XYN,  "DRW V%X, V%X, %u")  \
+    X(SKP,       0xF0FF, 0xE09E, ARGS_X,    "SKP V%X")           \
+    X(SKNP,      0xF0FF, 0xE0A1, ARGS_X,    "SKNP V%X")          \
+    X(LD_VX_DT,  0xF0FF, 0xF007, ARGS_X,    "LD V%X, DT")        \
+    X(LD_VX_K,   0xF0FF, 0xF00A, ARGS_X,    "LD V%X, K")         \
+    X(LD_DT_VX,  0xF0FF, 0xF015, ARGS_X,    "LD DT, V%X")        \
+    X(LD_ST_VX,  0xF0FF, 0xF018, ARGS_X,    "LD ST, V%X")        \
+    X(ADD_I_VX,  0xF0FF, 0xF01E, ARGS_X,    "ADD I, V%X")        \
+    X(LD_F_VX,   0xF0FF, 0xF029, ARGS_X,    "LD F, V%X")         \
+    X(LD_B_VX,   0xF0FF, 0xF033, ARGS_X,    "LD B, V%X")         \
+    X(LD_MEM_VX, 0xF0FF, 0xF055, ARGS_X,    "LD [I], V%X")       \
+    X(LD_VX_MEM, 0xF0FF, 0xF065, ARGS_X,    "LD V%X, [I]")
+
+/* opcode에서 피연산자 추출 */
+#define OP_X(opcode)   (((opcode) & 0x0F00) >> 8)
+#define OP_Y(opcode)   (((opcode) & 0x00F0) >> 4)
+#define OP_N(opcode)   ((opcode) & 0x000F)
+#define OP_KK(opcode)  ((opcode) & 0x00FF)
+#define OP_NNN(opcode) ((opcode) & 0x0FFF)
+
+// 명령어 ID
+enum chip8_op {
+    CHIP8_OP_UNDECODED = 0, // 디코드 캐시에서 아직 디코드되지 않은 항목
+    CHIP8_OP_INVALID,       // 정의되지 않은 opcode
+#define X(name, mask, match, args, mnemonic) CHIP8_OP_##name,
+    CHIP8_OPCODES(X)
+#undef X
+    CHIP8_OP_COUNT
+};
+
+// opcode -> 명령어 ID, 핫패스가 아니라 테이블 생성용이라 선형 탐색으로 충분
+static inline enum chip8_op chip8_decode_op(const uint16_t opcode) {
+#define X(name, mask, match, args, mnemonic) \
+    if ((opcode & (mask)) == (match)) return CHIP8_OP_##name;
+    CHIP8_OPCODES(X)
+#undef X
+    return CHIP8_OP_INVALID;
+}
+
+// 디코드된 명령어, 명령어 ID와 피연산자를 미리 추출해둠
+struct chip8_insn {
+    uint16_t opcode;
+    uint16_t nnn;
+    uint8_t op;     // enum chip8_op
+    uint8_t x;
+    uint8_t y;
+    uint8_t n;
+    uint8_t kk;
+};
+
+static inline void chip8_decode_insn(struct chip8_insn *in, const uint16_t opcode) {
+    in->opcode = opcode;
+    in->nnn = OP_NNN(opcode);
+    in->op = (uint8_t) chip8_decode_op(opcode);
+    in->x = OP_X(opcode);
+    in->y = OP_Y(opcode);
+    in->n = OP_N(opcode);
+    in->kk = OP_KK(opcode);
+}
+
+static inline const char *chip8_op_name(const enum chip8_op op) {
+    switch (op) {
+#define X(name, mask, match, args, mnemonic) case CHIP8_OP_##name: return #name;
+        CHIP8_OPCODES(X)
+#undef X
+        case CHIP8_OP_UNDECODED: return "UNDECODED";
+        default: return "INVALID";
+    }
+}
+
+/* 디스어셈블: 피연산자 형태별로 니모닉 포맷에 넘길 인자 */
+#define CHIP8_DISASM_ARGS_NONE(buf, size, fmt, in) snprintf(buf, size, fmt)
+#define CHIP8_DISASM_ARGS_NNN(buf, size, fmt, in)  snprintf(buf, size, fmt, (unsigned) (in)->nnn)
+#define CHIP8_DISASM_ARGS_XKK(buf, size, fmt, in)  snprintf(buf, size, fmt, (unsigned) (in)->x, (unsigned) (in)->kk)
+#define CHIP8_DISASM_ARGS_XY(buf, size, fmt, in)   snprintf(buf, size, fmt, (unsigned) (in)->x, (unsigned) (in)->y)
+#define CHIP8_DISASM_ARGS_XYN(buf, size, fmt, in) \
+    snprintf(buf, size, fmt, (unsigned) (in)->x, (unsigned) (in)->y, (unsigned) (in)->n)
+#define CHIP8_DISASM_ARGS_X(buf, size, fmt, in)    snprintf(buf, size, fmt, (unsigned) (in)->x)
+
+static inline int chip8_disasm(const struct chip8_insn *in, char *buf, const size_t size) {
+    switch (in->op) {
+#define X(name, mask, match, args, mnemonic) \
+        case CHIP8_OP_##name: return CHIP8_DISASM_##args(buf, size, mnemonic, in);
+        CHIP8_OPCODES(X)
+#undef X
+        default:
+            return snprintf(buf, size, "DW 0x%04X", (unsigned) in->opcode);
+    }
+}
+
+#endif // OPCODES_H
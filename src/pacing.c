@@ -0,0 +1,201 @@
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+
+#include "log.h"
+#include "pacing.h"
+
+#define NANOSECONDS_PER_SECOND 1000000000ULL
+
+#define PACING_CALIBRATION_SAMPLES 8
+#define PACING_CALIBRATION_SLEEP_NS 500000ULL // 0.5ms
+#define PACING_SPIN_MARGIN_NS      20000ULL   // 측정된 지연에 더하는 여유
+#define PACING_SPIN_MIN_NS         20000ULL
+#define PACING_SPIN_MAX_NS         2000000ULL // 2ms, 이보다 늦게 깨면 spin으로 메우지 않음
+
+static errcode_t clock_ns(const clockid_t clock, uint64_t *ns) {
+    struct timespec ts;
+    if (clock_gettime(clock, &ts) != 0) {
+        log_error("clock_gettime error: %s", strerror(errno));
+        return ERR_TIME_FUNC;
+    }
+    *ns = (uint64_t) ts.tv_sec * NANOSECONDS_PER_SECOND + (uint64_t) ts.tv_nsec;
+    return ERR_NONE;
+}
+
+// CLOCK_MONOTONIC 기준 절대 시각까지 sleep
+static errcode_t sleep_until(const uint64_t deadline_ns) {
+#ifdef __APPLE__
+    // macOS에는 clock_nanosleep이 없으므로 남은 시간을 계산해 nanosleep
+    uint64_t now;
+    errcode_t err = clock_ns(CLOCK_MONOTONIC, &now);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    if (now >= deadline_ns) {
+        return ERR_NONE;
+    }
+    const uint64_t remaining = deadline_ns - now;
+    struct timespec ts = {
+        .tv_sec = (time_t) (remaining / NANOSECONDS_PER_SECOND),
+        .tv_nsec = (long) (remaining % NANOSECONDS_PER_SECOND)
+    };
+    while (nanosleep(&ts, &ts) != 0) {
+        if (errno != EINTR) {
+            log_error("nanosleep error: %s", strerror(errno));
+            return ERR_SLEEP_FAILED;
+        }
+    }
+    return ERR_NONE;
+#else
+    const struct timespec ts = {
+        .tv_sec = (time_t) (deadline_ns / NANOSECONDS_PER_SECOND),
+        .tv_nsec = (long) (deadline_ns % NANOSECONDS_PER_SECOND)
+    };
+    int rc;
+    // 절대 시각이라 시그널로 깨도 같은 값으로 다시 호출하면 됨
+    while ((rc = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL)) == EINTR) {
+    }
+    if (rc != 0) {
+        log_error("clock_nanosleep error: %s", strerror(rc));
+        return ERR_SLEEP_FAILED;
+    }
+    return ERR_NONE;
+#endif
+}
+
+// 깨어난 지연(overshoot)으로 spin 구간 보정: 늘릴 때는 바로, 줄일 때는 천천히
+static void update_spin_window(struct pacer *pacer, const uint64_t overshoot_ns) {
+    uint64_t wanted = overshoot_ns + PACING_SPIN_MARGIN_NS;
+    if (wanted > PACING_SPIN_MAX_NS) {
+        wanted = PACING_SPIN_MAX_NS;
+    }
+    if (wanted > pacer->spin_window_ns) {
+        pacer->spin_window_ns = wanted;
+    } else {
+        pacer->spin_window_ns -= (pacer->spin_window_ns - wanted) / 16;
+    }
+    if (pacer->spin_window_ns < PACING_SPIN_MIN_NS) {
+        pacer->spin_window_ns = PACING_SPIN_MIN_NS;
+    }
+}
+
+errcode_t pacing_parse_mode(const char *name, enum pacing_mode *mode) {
+    if (strcmp(name, "precise") == 0) {
+        *mode = PACING_PRECISE;
+    } else if (strcmp(name, "efficient") == 0) {
+        *mode = PACING_EFFICIENT;
+    } else {
+        return ERR_INVALID_PARAMETER;
+    }
+    return ERR_NONE;
+}
+
+const char *pacing_mode_name(const enum pacing_mode mode) {
+    return mode == PACING_PRECISE ? "precise" : "efficient";
+}
+
+errcode_t pacer_init(struct pacer *pacer, const enum pacing_mode mode) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->mode = mode;
+    pacer->spin_window_ns = PACING_SPIN_MIN_NS;
+
+    errcode_t err;
+    if (mode == PACING_PRECISE) {
+        // 짧은 sleep을 몇 번 해보고 가장 늦게 깨어난 만큼을 초기 spin 구간으로 사용
+        for (int i = 0; i < PACING_CALIBRATION_SAMPLES; i++) {
+            uint64_t now;
+            err = clock_ns(CLOCK_MONOTONIC, &now);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            const uint64_t target = now + PACING_CALIBRATION_SLEEP_NS;
+            err = sleep_until(target);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            err = clock_ns(CLOCK_MONOTONIC, &now);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            update_spin_window(pacer, now > target ? now - target : 0);
+        }
+        log_info("Pacing: calibrated spin window %llu ns", (unsigned long long) pacer->spin_window_ns);
+    }
+
+    err = clock_ns(CLOCK_MONOTONIC, &pacer->start_wall_ns);
+    if (err != ERR_NONE) {
+        return err;
+    }
+    return clock_ns(CLOCK_PROCESS_CPUTIME_ID, &pacer->start_cpu_ns);
+}
+
+errcode_t pacer_wait_until(struct pacer *pacer, const uint64_t deadline_ns, uint64_t *now_ns) {
+    uint64_t now;
+    errcode_t err = clock_ns(CLOCK_MONOTONIC, &now);
+    if (err != ERR_NONE) {
+        return err;
+    }
+
+    if (pacer->mode == PACING_EFFICIENT) {
+        if (now < deadline_ns) {
+            err = sleep_until(deadline_ns);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            err = clock_ns(CLOCK_MONOTONIC, &now);
+            if (err != ERR_NONE) {
+                return err;
+            }
+        }
+    } else {
+        const uint64_t sleep_target = deadline_ns - pacer->spin_window_ns;
+        if (now < sleep_target) {
+            err = sleep_until(sleep_target);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            err = clock_ns(CLOCK_MONOTONIC, &now);
+            if (err != ERR_NONE) {
+                return err;
+            }
+            update_spin_window(pacer, now > sleep_target ? now - sleep_target : 0);
+        }
+        // 남은 구간은 spin
+        while (now < deadline_ns) {
+            err = clock_ns(CLOCK_MONOTONIC, &now);
+            if (err != ERR_NONE) {
+                return err;
+            }
+        }
+    }
+
+    const uint64_t jitter = now > deadline_ns ? now - deadline_ns : 0;
+    pacer->jitter_sum_ns += jitter;
+    if (jitter > pacer->jitter_max_ns) {
+        pacer->jitter_max_ns = jitter;
+    }
+    ++pacer->waits;
+
+    *now_ns = now;
+    return ERR_NONE;
+}
+
+void pacer_report(const struct pacer *pacer) {
+    uint64_t wall;
+    uint64_t cpu;
+    if (clock_ns(CLOCK_MONOTONIC, &wall) != ERR_NONE ||
+        clock_ns(CLOCK_PROCESS_CPUTIME_ID, &cpu) != ERR_NONE) {
+        return;
+    }
+    const uint64_t wall_ns = wall - pacer->start_wall_ns;
+    const uint64_t cpu_ns = cpu - pacer->start_cpu_ns;
+
+    log_info("Pacing (%s): %llu waits, jitter avg %llu ns, max %llu ns, spin window %llu ns, CPU %.1f%%",
+             pacing_mode_name(pacer->mode),
+             (unsigned long long) pacer->waits,
+             (unsigned long long) (pacer->waits ? pacer->jitter_sum_ns / pacer->waits : 0),
+             (unsigned long long) pacer->jitter_max_ns,
+             (unsigned long long) pacer->spin_window_ns,
+             wall_ns ? 100.0 * (double) cpu_ns / (double) wall_ns : 0.0);
+}
@@ -0,0 +1,45 @@
+#ifndef PACING_H
+#define PACING_H
+
+#include <stdint.h>
+
+#include "errcode.h"
+
+/*
+ * 프레임 간 대기
+ * 대부분의 시간은 clock_nanosleep(TIMER_ABSTIME)으로 자고, 깨어나는 지연을 보정하기 위해
+ * 마지막 짧은 구간만 spin 한다. spin 구간은 시작 시 측정한 뒤 실행 중에도 계속 보정한다.
+ */
+
+enum pacing_mode {
+    PACING_PRECISE,   // sleep + 보정된 spin 구간, 지터가 작음
+    PACING_EFFICIENT  // sleep만 사용, CPU 사용량이 가장 낮음
+};
+
+struct pacer {
+    enum pacing_mode mode;
+    uint64_t spin_window_ns; // 마감 시각 전 이 시간부터는 spin
+
+    /* 통계 */
+    uint64_t waits;
+    uint64_t jitter_sum_ns;  // 마감 시각 대비 늦게 깨어난 시간의 합
+    uint64_t jitter_max_ns;
+    uint64_t start_wall_ns;
+    uint64_t start_cpu_ns;   // 프로세스 CPU 시간
+};
+
+// 모드 이름 -> enum, 알 수 없는 이름이면 ERR_INVALID_PARAMETER
+errcode_t pacing_parse_mode(const char *name, enum pacing_mode *mode);
+
+const char *pacing_mode_name(enum pacing_mode mode);
+
+// spin 구간 측정 후 통계 초기화
+errcode_t pacer_init(struct pacer *pacer, enum pacing_mode mode);
+
+// deadline_ns(CLOCK_MONOTONIC)까지 대기, 깨어난 시각을 *now_ns에 저장
+errcode_t pacer_wait_until(struct pacer *pacer, uint64_t deadline_ns, uint64_t *now_ns);
+
+// 지터와 CPU 사용률을 로그로 출력
+void pacer_report(const struct pacer *pacer);
+
+#endif // PACING_H
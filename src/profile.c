@@ -0,0 +1,169 @@
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "profile.h"
+
+#define CLOCK_OVERHEAD_SAMPLES 1000
+#define HEATMAP_ROW_BYTES 64
+static const char HEATMAP_SCALE[] = " .:-=+*#%@"; // 0회, 그 다음부터 log2 스케일
+#define HEATMAP_LEVELS ((int) sizeof(HEATMAP_SCALE) - 3) // 1회 이상 단계는 1..HEATMAP_LEVELS + 1
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+}
+
+void profile_start(struct profiler *profiler) {
+    memset(profiler, 0, sizeof(*profiler));
+    profiler->enabled = true;
+
+    // 측정 비용: 연속으로 두 번 읽은 값 차이의 최솟값
+    uint64_t overhead = UINT64_MAX;
+    for (int n = 0; n < CLOCK_OVERHEAD_SAMPLES; n++) {
+        const uint64_t a = profile_clock();
+        const uint64_t b = profile_clock();
+        if (b - a < overhead) {
+            overhead = b - a;
+        }
+    }
+    profiler->clock_overhead = overhead;
+    profiler->start_ticks = profile_clock();
+    profiler->start_ns = monotonic_ns();
+}
+
+// 정렬 기준 (qsort에 문맥을 넘길 수 없어서 파일 범위에 둠, 보고서는 한 번만 만듦)
+static const uint64_t *sort_keys;
+
+static int compare_desc(const void *a, const void *b) {
+    const uint64_t x = sort_keys[*(const uint16_t *) a];
+    const uint64_t y = sort_keys[*(const uint16_t *) b];
+    return (x < y) - (x > y);
+}
+
+// 값을 표현하는 데 필요한 비트 수 (floor(log2(value)) + 1)
+static int bit_length(const uint64_t value) {
+    return value ? 64 - __builtin_clzll(value) : 0;
+}
+
+static void print_heatmap(FILE *out, const char *title, const uint64_t *counts) {
+    uint64_t max = 0;
+    uint64_t total = 0;
+    for (int n = 0; n < MEMORY_SIZE; n++) {
+        total += counts[n];
+        if (counts[n] > max) {
+            max = counts[n];
+        }
+    }
+    fprintf(out, "\n== %s: %llu accesses, max %llu per byte ==\n", title, (unsigned long long) total,
+            (unsigned long long) max);
+    if (max == 0) {
+        return;
+    }
+    fprintf(out, "scale: '%c' = 0, '%c'..'%c' = 1..%llu (log2)\n", HEATMAP_SCALE[0], HEATMAP_SCALE[1],
+            HEATMAP_SCALE[HEATMAP_LEVELS + 1], (unsigned long long) max);
+
+    const int max_bits = bit_length(max);
+    for (int row = 0; row < MEMORY_SIZE; row += HEATMAP_ROW_BYTES) {
+        char line[HEATMAP_ROW_BYTES + 1];
+        for (int col = 0; col < HEATMAP_ROW_BYTES; col++) {
+            const uint64_t count = counts[row + col];
+            const int level = count ? 1 + bit_length(count) * HEATMAP_LEVELS / max_bits : 0;
+            line[col] = HEATMAP_SCALE[level];
+        }
+        line[HEATMAP_ROW_BYTES] = '\0';
+        fprintf(out, "0x%03X |%s|\n", row, line);
+    }
+}
+
+errcode_t profile_report(const struct profiler *profiler, const struct chip8 *chip, const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        log_error("Failed to open profile report %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+
+    const uint64_t elapsed_ticks = profile_clock() - profiler->start_ticks;
+    const uint64_t elapsed_ns = monotonic_ns() - profiler->start_ns;
+    const double ns_per_tick = elapsed_ticks ? (double) elapsed_ns / (double) elapsed_ticks : 1.0;
+
+    uint64_t instructions = 0;
+    double total_ns = 0;
+    double op_ns[CHIP8_OP_COUNT];
+    for (int op = 0; op < CHIP8_OP_COUNT; op++) {
+        instructions += profiler->op_count[op];
+        // 측정 비용은 명령어마다 한 번씩 들어가 있으므로 빼고, 음수가 되면 0
+        const double overhead = (double) profiler->clock_overhead * (double) profiler->op_count[op];
+        const double ticks = (double) profiler->op_ticks[op] - overhead;
+        op_ns[op] = ticks > 0 ? ticks * ns_per_tick : 0;
+        total_ns += op_ns[op];
+    }
+
+    fprintf(out, "c_chip_8 profile\n");
+    fprintf(out, "instructions: %llu, wall time: %.3f ms, time in instructions: %.3f ms\n",
+            (unsigned long long) instructions, (double) elapsed_ns / 1e6, total_ns / 1e6);
+    fprintf(out, "clock overhead per sample: %.1f ns (subtracted)\n",
+            (double) profiler->clock_overhead * ns_per_tick);
+
+    /* 명령어 종류: 호스트 시간 순 */
+    uint64_t op_keys[CHIP8_OP_COUNT];
+    uint16_t ops[CHIP8_OP_COUNT];
+    for (int op = 0; op < CHIP8_OP_COUNT; op++) {
+        op_keys[op] = (uint64_t) op_ns[op];
+        ops[op] = (uint16_t) op;
+    }
+    sort_keys = op_keys;
+    qsort(ops, CHIP8_OP_COUNT, sizeof(ops[0]), compare_desc);
+
+    fprintf(out, "\n== Opcodes by host time ==\n");
+    fprintf(out, "%-10s %14s %7s %12s %7s %8s\n", "op", "count", "count%", "total ms", "time%", "ns/op");
+    for (int n = 0; n < CHIP8_OP_COUNT; n++) {
+        const int op = ops[n];
+        const uint64_t count = profiler->op_count[op];
+        if (!count) {
+            continue;
+        }
+        fprintf(out, "%-10s %14llu %6.2f%% %12.3f %6.2f%% %8.2f\n", chip8_op_name((enum chip8_op) op),
+                (unsigned long long) count, 100.0 * (double) count / (double) instructions, op_ns[op] / 1e6,
+                total_ns > 0 ? 100.0 * op_ns[op] / total_ns : 0.0, op_ns[op] / (double) count);
+    }
+
+    /* 주소: 실행 횟수 순 */
+    static uint16_t pcs[MEMORY_SIZE];
+    for (int pc = 0; pc < MEMORY_SIZE; pc++) {
+        pcs[pc] = (uint16_t) pc;
+    }
+    sort_keys = profiler->pc_count;
+    qsort(pcs, MEMORY_SIZE, sizeof(pcs[0]), compare_desc);
+
+    fprintf(out, "\n== Hot addresses (top %d) ==\n", PROFILE_TOP_PCS);
+    fprintf(out, "%-5s %-6s %-18s %14s %7s\n", "pc", "opcode", "disasm", "count", "count%");
+    for (int n = 0; n < PROFILE_TOP_PCS; n++) {
+        const uint16_t pc = pcs[n];
+        const uint64_t count = profiler->pc_count[pc];
+        if (!count) {
+            break;
+        }
+        struct chip8_insn in;
+        chip8_decode_insn(&in, (uint16_t) ((chip->memory[pc] << 8) | chip->memory[(pc + 1) & MEMORY_ADDR_MASK]));
+        char text[32];
+        chip8_disasm(&in, text, sizeof(text));
+        fprintf(out, "0x%03X %04X   %-18s %14llu %6.2f%%\n", pc, in.opcode, text, (unsigned long long) count,
+                100.0 * (double) count / (double) instructions);
+    }
+
+    print_heatmap(out, "Instruction fetches (per instruction address)", profiler->pc_count);
+    print_heatmap(out, "Memory reads (Dxyn sprites, Fx65)", profiler->mem_reads);
+    print_heatmap(out, "Memory writes (Fx33, Fx55)", profiler->mem_writes);
+
+    const bool ok = fclose(out) == 0;
+    if (!ok) {
+        log_error("Failed to write profile report %s", path);
+        return ERR_UNKNOWN;
+    }
+    log_info("Profile report written to %s", path);
+    return ERR_NONE;
+}
@@ -0,0 +1,87 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "chip8.h"
+#include "errcode.h"
+#include "opcodes.h"
+
+/*
+ * 게스트 프로파일러
+ * 명령어 종류별 실행 횟수와 호스트 시간, pc별 실행 횟수, 메모리 주소별 읽기/쓰기 횟수를 센다.
+ * 에뮬레이션 스레드만 쓰므로 카운터는 원자적 연산 없는 일반 배열이고, 보고서는 종료 시 한 번 만든다.
+ *
+ * 시간은 명령어 실행(디스패치) 전후로 잰다. x86은 rdtsc, 그 외는 clock_gettime 값을 쓰고
+ * 종료 시 전체 실행 시간으로 ns로 환산한다. 측정 자체의 비용(연속 두 번 읽은 값의 최솟값)은 빼고 보고한다.
+ * rdtsc는 직렬화하지 않으므로 명령어 하나하나가 아니라 종류별 합계로만 의미가 있다.
+ */
+
+#define PROFILE_TOP_PCS 32 // 보고서에 출력할 실행 횟수 상위 주소 수
+
+struct profiler {
+    bool enabled;
+    uint64_t op_count[CHIP8_OP_COUNT];
+    uint64_t op_ticks[CHIP8_OP_COUNT];  // 명령어 종류별 실행 시간 합 (profile_clock() 단위)
+    uint64_t pc_count[MEMORY_SIZE];     // 주소별 실행 횟수
+    uint64_t mem_reads[MEMORY_SIZE];    // 명령어의 데이터 읽기 (Dxyn 스프라이트, Fx65)
+    uint64_t mem_writes[MEMORY_SIZE];   // 명령어의 데이터 쓰기 (Fx33, Fx55)
+
+    uint64_t clock_overhead;            // profile_clock() 연속 호출 간격 최솟값
+    uint64_t start_ticks;
+    uint64_t start_ns;
+};
+
+static inline uint64_t profile_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + (uint64_t) ts.tv_nsec;
+#endif
+}
+
+void profile_start(struct profiler *profiler);
+
+// 실행 직전에 호출, i는 실행 전 I (메모리 접근 명령어는 I를 바꾸지 않음)
+static inline void profile_count(struct profiler *profiler, const uint16_t pc, const struct chip8_insn *in,
+                                 const uint16_t i) {
+    ++profiler->op_count[in->op];
+    ++profiler->pc_count[pc & MEMORY_ADDR_MASK];
+
+    switch (in->op) {
+        case CHIP8_OP_DRW:
+            for (uint8_t n = 0; n < in->n; n++) {
+                ++profiler->mem_reads[(i + n) & MEMORY_ADDR_MASK];
+            }
+            break;
+        case CHIP8_OP_LD_VX_MEM:
+            for (uint8_t n = 0; n <= in->x; n++) {
+                ++profiler->mem_reads[(i + n) & MEMORY_ADDR_MASK];
+            }
+            break;
+        case CHIP8_OP_LD_MEM_VX:
+            for (uint8_t n = 0; n <= in->x; n++) {
+                ++profiler->mem_writes[(i + n) & MEMORY_ADDR_MASK];
+            }
+            break;
+        case CHIP8_OP_LD_B_VX:
+            for (uint8_t n = 0; n < 3; n++) {
+                ++profiler->mem_writes[(i + n) & MEMORY_ADDR_MASK];
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+// 보고서를 path에 씀 (실행 중인 메모리의 opcode로 역어셈블)
+errcode_t profile_report(const struct profiler *profiler, const struct chip8 *chip, const char *path);
+
+#endif // PROFILE_H
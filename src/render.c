@@ -0,0 +1,164 @@
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "render.h"
+
+/* 화면 배치: 1행은 위쪽 테두리, 픽셀 y는 y+2행, 픽셀 x는 2x+2열 (1열은 왼쪽 테두리) */
+#define SCREEN_ROW(y)      ((y) + 2)
+#define SCREEN_COL(x)      ((x) * 2 + 2)
+#define SCREEN_BOTTOM_ROW  (DISPLAY_HEIGHT + 3)
+
+struct out {
+    char *buf;
+    size_t len;
+};
+
+static void out_append(struct out *out, const char *s, const size_t n) {
+    memcpy(out->buf + out->len, s, n);
+    out->len += n;
+}
+
+#define OUT_LITERAL(out, s) out_append((out), (s), sizeof(s) - 1)
+
+static void out_move(struct out *out, const int row, const int col) {
+    out->len += (size_t) snprintf(out->buf + out->len, RENDER_BUFFER_SIZE - out->len, "\x1b[%d;%dH", row, col);
+}
+
+static void out_border(struct out *out) {
+    OUT_LITERAL(out, "+");
+    for (int i = 0; i < DISPLAY_WIDTH * 2; i++) {
+        OUT_LITERAL(out, "-");
+    }
+    OUT_LITERAL(out, "+");
+}
+
+// 픽셀 8개(바이트 하나) 출력
+static void out_byte(struct out *out, const uint8_t pixels) {
+    for (int bit = 7; bit >= 0; bit--) {
+        if ((pixels >> bit) & 1) {
+            OUT_LITERAL(out, PIXEL_ON_STR);
+        } else {
+            OUT_LITERAL(out, PIXEL_OFF_STR);
+        }
+    }
+}
+
+static void out_full(struct out *out, const uint64_t *display) {
+    OUT_LITERAL(out, "\x1b[2J\x1b[H");
+    out_border(out);
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        OUT_LITERAL(out, "\r\n|");
+        for (int b = 0; b < DISPLAY_WIDTH_BYTES; b++) {
+            out_byte(out, DISPLAY_ROW_BYTE(display[y], b));
+        }
+        OUT_LITERAL(out, "|");
+    }
+    OUT_LITERAL(out, "\r\n");
+    out_border(out);
+}
+
+// 바뀐 바이트가 연속된 구간마다 커서 이동 한 번 + 픽셀 문자열
+static void out_diff(struct out *out, const uint64_t *shown, const uint64_t *display) {
+    for (int y = 0; y < DISPLAY_HEIGHT; y++) {
+        const uint64_t changed = shown[y] ^ display[y];
+        if (changed == 0) {
+            continue;
+        }
+        int b = 0;
+        while (b < DISPLAY_WIDTH_BYTES) {
+            if (DISPLAY_ROW_BYTE(changed, b) == 0) {
+                ++b;
+                continue;
+            }
+            out_move(out, SCREEN_ROW(y), SCREEN_COL(b * 8));
+            while (b < DISPLAY_WIDTH_BYTES && DISPLAY_ROW_BYTE(changed, b) != 0) {
+                out_byte(out, DISPLAY_ROW_BYTE(display[y], b));
+                ++b;
+            }
+        }
+    }
+}
+
+// 버퍼 전체를 write(), 부분 쓰기면 나머지를 이어서 씀
+static errcode_t flush_out(struct renderer *renderer, const struct out *out) {
+    size_t written = 0;
+    uint32_t syscalls = 0;
+    while (written < out->len) {
+        const ssize_t n = write(renderer->fd, out->buf + written, out->len - written);
+        ++syscalls;
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("render write error: %s", strerror(errno));
+            renderer->stats.syscalls += syscalls;
+            return ERR_UNKNOWN;
+        }
+        written += (size_t) n;
+    }
+    renderer->stats.syscalls += syscalls;
+    renderer->stats.last_syscalls = syscalls;
+    return ERR_NONE;
+}
+
+void render_init(struct renderer *renderer, const int fd) {
+    memset(renderer, 0, sizeof(*renderer));
+    renderer->fd = fd;
+}
+
+void render_invalidate(struct renderer *renderer) {
+    renderer->drawn = false;
+}
+
+errcode_t render_frame(struct renderer *renderer, const uint64_t *display) {
+    struct out out = {.buf = renderer->buffer, .len = 0};
+    const size_t display_size = sizeof(renderer->shown);
+
+    ++renderer->stats.frames;
+    renderer->stats.last_bytes = 0;
+    renderer->stats.last_syscalls = 0;
+
+    if (!renderer->drawn) {
+        out_full(&out, display);
+        renderer->drawn = true;
+    } else if (memcmp(renderer->shown, display, display_size) == 0) {
+        return ERR_NONE;
+    } else {
+        out_diff(&out, renderer->shown, display);
+    }
+    memcpy(renderer->shown, display, display_size);
+
+    const errcode_t err = flush_out(renderer, &out);
+    if (err != ERR_NONE) {
+        // 출력 도중 실패하면 화면 상태를 알 수 없으므로 다음에 전체를 다시 그림
+        renderer->drawn = false;
+        return err;
+    }
+    ++renderer->stats.frames_written;
+    renderer->stats.bytes += out.len;
+    renderer->stats.last_bytes = (uint32_t) out.len;
+    return ERR_NONE;
+}
+
+void render_finish(struct renderer *renderer) {
+    if (!renderer->drawn) {
+        return;
+    }
+    char buf[32];
+    struct out out = {.buf = buf, .len = 0};
+    out.len = (size_t) snprintf(buf, sizeof(buf), "\x1b[%d;1H", SCREEN_BOTTOM_ROW);
+    flush_out(renderer, &out);
+}
+
+void render_report(const struct renderer *renderer) {
+    const struct render_stats *stats = &renderer->stats;
+    log_info("Render: %llu frames, %llu written, %llu bytes (%.1f bytes/frame), %llu write() calls",
+             (unsigned long long) stats->frames,
+             (unsigned long long) stats->frames_written,
+             (unsigned long long) stats->bytes,
+             stats->frames ? (double) stats->bytes / (double) stats->frames : 0.0,
+             (unsigned long long) stats->syscalls);
+}
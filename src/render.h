@@ -0,0 +1,48 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "chip8.h"
+#include "errcode.h"
+
+/*
+ * 터미널 렌더러
+ * 마지막으로 출력한 화면을 기억해두고 행/바이트 단위로 비교해서 바뀐 부분만
+ * 커서 이동 + 픽셀 문자열로 출력한다. 한 프레임은 write() 한 번으로 내보내고,
+ * 바뀐 게 없으면 아무것도 출력하지 않는다.
+ */
+
+#define RENDER_BUFFER_SIZE 16384 // 바이트마다 커서 이동이 붙는 최악의 경우도 들어가는 크기
+
+struct render_stats {
+    uint64_t frames;          // render_frame() 호출 수
+    uint64_t frames_written;  // 실제로 출력한 프레임 수
+    uint64_t bytes;           // 출력한 총 바이트
+    uint64_t syscalls;        // write() 호출 수
+    uint32_t last_bytes;      // 마지막 프레임의 바이트 수
+    uint32_t last_syscalls;   // 마지막 프레임의 write() 호출 수
+};
+
+struct renderer {
+    int fd;
+    bool drawn; // false면 다음 프레임은 화면 전체를 다시 그림
+    uint64_t shown[DISPLAY_HEIGHT]; // 마지막으로 출력한 화면
+    char buffer[RENDER_BUFFER_SIZE];
+    struct render_stats stats;
+};
+
+void render_init(struct renderer *renderer, int fd);
+
+// 다음 프레임에서 화면 전체를 다시 그리게 함 (다른 출력으로 화면이 깨졌을 때)
+void render_invalidate(struct renderer *renderer);
+
+errcode_t render_frame(struct renderer *renderer, const uint64_t *display);
+
+// 커서를 화면 아래로 옮김, 종료 시 호출
+void render_finish(struct renderer *renderer);
+
+void render_report(const struct renderer *renderer);
+
+#endif // RENDER_H
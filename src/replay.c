@@ -0,0 +1,145 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libchip8.h"
+#include "log.h"
+#include "replay.h"
+
+errcode_t replay_record_open(struct replay *replay, const char *path, const uint32_t ips, const bool clip_sprites,
+                             const uint64_t seed) {
+    memset(replay, 0, sizeof(*replay));
+    replay->end = REPLAY_NO_END;
+
+    replay->fp = fopen(path, "w");
+    if (!replay->fp) {
+        log_error("Failed to open recording %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    replay->mode = REPLAY_RECORD;
+    replay->ips = ips;
+    replay->clip_sprites = clip_sprites;
+    replay->seed = seed;
+
+    fprintf(replay->fp, "%s %d\n", REPLAY_MAGIC, REPLAY_VERSION);
+    fprintf(replay->fp, "ips %" PRIu32 "\n", ips);
+    fprintf(replay->fp, "clip %d\n", clip_sprites ? 1 : 0);
+    fprintf(replay->fp, "seed 0x%016" PRIX64 "\n", seed);
+
+    log_info("Recording input to %s (seed 0x%016" PRIX64 ")", path, seed);
+    return ERR_NONE;
+}
+
+void replay_record_key(struct replay *replay, const uint64_t instruction, const uint8_t key) {
+    // 키 입력은 드물어서 stdio 버퍼에 쓰는 것으로 충분
+    fprintf(replay->fp, "key %" PRIu64 " %X\n", instruction, (unsigned) key);
+}
+
+static errcode_t add_event(struct replay *replay, const uint64_t instruction, const uint8_t key) {
+    if (replay->count == replay->capacity) {
+        const size_t capacity = replay->capacity ? replay->capacity * 2 : 256;
+        struct replay_event *events = realloc(replay->events, capacity * sizeof(*events));
+        if (!events) {
+            return ERR_UNKNOWN;
+        }
+        replay->events = events;
+        replay->capacity = capacity;
+    }
+    replay->events[replay->count].instruction = instruction;
+    replay->events[replay->count].key = key;
+    ++replay->count;
+    return ERR_NONE;
+}
+
+errcode_t replay_load(struct replay *replay, const char *path) {
+    memset(replay, 0, sizeof(*replay));
+    replay->end = REPLAY_NO_END;
+
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        log_error("Failed to open recording %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+
+    errcode_t err = ERR_NONE;
+    bool header = false;
+    bool has_ips = false;
+    bool has_seed = false;
+    uint64_t last = 0;
+    unsigned line_no = 0;
+    char line[128];
+    while (err == ERR_NONE && fgets(line, sizeof(line), fp)) {
+        ++line_no;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+
+        char word[32];
+        int version;
+        uint64_t instruction;
+        unsigned value;
+        if (!header) {
+            if (sscanf(line, "%31s %d", word, &version) != 2 || strcmp(word, REPLAY_MAGIC) != 0
+                || version != REPLAY_VERSION) {
+                log_error("%s: not a version %d recording", path, REPLAY_VERSION);
+                err = ERR_INVALID_PARAMETER;
+            }
+            header = true;
+        } else if (sscanf(line, "key %" SCNu64 " %x", &instruction, &value) == 2) {
+            if (value > 0xF || instruction < last) {
+                log_error("%s:%u: invalid key event", path, line_no);
+                err = ERR_INVALID_PARAMETER;
+            } else {
+                last = instruction;
+                err = add_event(replay, instruction, (uint8_t) value);
+            }
+        } else if (sscanf(line, "ips %u", &value) == 1) {
+            // --ips와 같은 범위만 받음
+            if (value == 0 || value > CHIP8_MAX_IPS) {
+                log_error("%s:%u: ips out of range (1..%u)", path, line_no, CHIP8_MAX_IPS);
+                err = ERR_INVALID_PARAMETER;
+            } else {
+                replay->ips = value;
+                has_ips = true;
+            }
+        } else if (sscanf(line, "clip %u", &value) == 1) {
+            replay->clip_sprites = value != 0;
+        } else if (sscanf(line, "seed %" SCNx64, &replay->seed) == 1) {
+            has_seed = true;
+        } else if (sscanf(line, "end %" SCNu64, &instruction) == 1) {
+            replay->end = instruction;
+        } else {
+            log_error("%s:%u: unknown line", path, line_no);
+            err = ERR_INVALID_PARAMETER;
+        }
+    }
+    fclose(fp);
+
+    if (err == ERR_NONE && (!has_ips || !has_seed)) {
+        log_error("%s: missing ips or seed", path);
+        err = ERR_INVALID_PARAMETER;
+    }
+    if (err != ERR_NONE) {
+        free(replay->events);
+        replay->events = NULL;
+        return err;
+    }
+
+    replay->mode = REPLAY_PLAY;
+    log_info("Replaying %s: %zu key events, ips %" PRIu32 ", seed 0x%016" PRIX64,
+             path, replay->count, replay->ips, replay->seed);
+    return ERR_NONE;
+}
+
+void replay_close(struct replay *replay, const uint64_t instruction) {
+    if (replay->fp) {
+        fprintf(replay->fp, "end %" PRIu64 "\n", instruction);
+        fclose(replay->fp);
+        replay->fp = NULL;
+        log_info("Recording finished after %llu instructions", (unsigned long long) instruction);
+    }
+    free(replay->events);
+    replay->events = NULL;
+    replay->mode = REPLAY_OFF;
+}
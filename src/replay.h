@@ -0,0 +1,74 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "errcode.h"
+
+/*
+ * 입력 기록/재생
+ * 실행 결과를 결정하는 값(ips, 스프라이트 클리핑 여부, 난수 시드)과 키 입력을 텍스트 파일로 저장한다.
+ * 키 입력은 벽시계 시각이 아니라 그때까지 실행한 명령어 수로 기록하므로,
+ * 재생할 때는 대기 방식이나 --unthrottled 여부와 상관없이 같은 명령어에서 같은 입력이 들어간다.
+ *
+ * 파일 형식 (한 줄에 하나, #으로 시작하면 주석)
+ *   c_chip_8-replay 1
+ *   ips 500
+ *   clip 0
+ *   seed 0x0123456789ABCDEF
+ *   key <명령어 수> <키 번호 16진수>
+ *   ...
+ *   end <명령어 수>          기록을 끝낸 시점, 재생은 여기서 종료
+ */
+
+#define REPLAY_MAGIC   "c_chip_8-replay"
+#define REPLAY_VERSION 1
+#define REPLAY_NO_END  UINT64_MAX
+
+enum replay_mode {
+    REPLAY_OFF,
+    REPLAY_RECORD,
+    REPLAY_PLAY
+};
+
+struct replay_event {
+    uint64_t instruction; // 이 명령어를 실행하기 전에 입력
+    uint8_t key;
+};
+
+struct replay {
+    enum replay_mode mode;
+    FILE *fp;             // 기록 중인 파일
+
+    /* 실행 조건 */
+    uint32_t ips;
+    bool clip_sprites;
+    uint64_t seed;
+
+    /* 재생할 입력 */
+    struct replay_event *events;
+    size_t count;
+    size_t capacity;
+    size_t next;          // 다음에 넣을 입력
+    uint64_t end;         // 재생 종료 명령어 수, 없으면 REPLAY_NO_END
+};
+
+// 기록 시작, 실행 조건을 헤더로 씀
+errcode_t replay_record_open(struct replay *replay, const char *path, uint32_t ips, bool clip_sprites, uint64_t seed);
+
+void replay_record_key(struct replay *replay, uint64_t instruction, uint8_t key);
+
+// 재생할 파일을 읽음, 형식이 잘못되면 ERR_INVALID_PARAMETER
+errcode_t replay_load(struct replay *replay, const char *path);
+
+// 기록 중이면 종료 시점을 쓰고 닫음
+void replay_close(struct replay *replay, uint64_t instruction);
+
+// 다음 재생 입력의 명령어 수, 없으면 REPLAY_NO_END
+static inline uint64_t replay_next_instruction(const struct replay *replay) {
+    return replay->next < replay->count ? replay->events[replay->next].instruction : REPLAY_NO_END;
+}
+
+#endif // REPLAY_H
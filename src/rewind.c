@@ -0,0 +1,295 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "log.h"
+#include "rewind.h"
+
+/*
+ * 압축 형식: [0 구간 길이][literal 길이][literal (XOR 값)] 반복, 길이는 LEB128 가변 길이 정수
+ * 끝부분의 0 구간은 기록하지 않는다.
+ */
+#define RLE_MIN_ZERO_RUN 4 // 이보다 짧은 0 구간은 literal에 포함 (토큰 오버헤드가 더 큼)
+
+// 최악의 경우 압축 크기: literal마다 토큰 4바이트, literal 사이에는 0이 RLE_MIN_ZERO_RUN개 이상
+#define RLE_MAX_SIZE(size) ((size) + 4 * ((size) / (RLE_MIN_ZERO_RUN + 1) + 1))
+
+// 최소 예산: keyframe 여러 개가 들어가야 그룹 단위 교체가 가능
+#define REWIND_MIN_BUDGET (8 * RLE_MAX_SIZE(sizeof(struct savestate)))
+
+static uint8_t *put_varint(uint8_t *p, uint32_t value) {
+    while (value >= 0x80) {
+        *p++ = (uint8_t) (value | 0x80);
+        value >>= 7;
+    }
+    *p++ = (uint8_t) value;
+    return p;
+}
+
+static const uint8_t *get_varint(const uint8_t *p, uint32_t *value) {
+    uint32_t result = 0;
+    int shift = 0;
+    do {
+        result |= (uint32_t) (*p & 0x7F) << shift;
+        shift += 7;
+    } while (*p++ & 0x80);
+    *value = result;
+    return p;
+}
+
+static inline uint8_t xor_at(const uint8_t *cur, const uint8_t *base, const size_t i) {
+    return base ? (uint8_t) (cur[i] ^ base[i]) : cur[i];
+}
+
+// (cur XOR base)를 압축, base가 NULL이면 0과 XOR (keyframe). 압축된 크기 반환
+static size_t rle_encode(uint8_t *out, const uint8_t *cur, const uint8_t *base, const size_t size) {
+    uint8_t *p = out;
+    size_t i = 0;
+    while (i < size) {
+        const size_t zero_start = i;
+        // 바뀌지 않은 구간은 8바이트씩 건너뜀
+        if (base) {
+            while (i + 8 <= size && memcmp(cur + i, base + i, 8) == 0) {
+                i += 8;
+            }
+        }
+        while (i < size && xor_at(cur, base, i) == 0) {
+            ++i;
+        }
+        if (i == size) {
+            break;
+        }
+
+        // literal: 0이 RLE_MIN_ZERO_RUN개 이상 이어지기 전까지
+        const size_t literal_start = i;
+        size_t last_nonzero = i;
+        while (i < size && i - last_nonzero <= RLE_MIN_ZERO_RUN) {
+            if (xor_at(cur, base, i) != 0) {
+                last_nonzero = i;
+            }
+            ++i;
+        }
+        const size_t literal_len = last_nonzero + 1 - literal_start;
+
+        p = put_varint(p, (uint32_t) (literal_start - zero_start));
+        p = put_varint(p, (uint32_t) literal_len);
+        for (size_t k = 0; k < literal_len; k++) {
+            *p++ = xor_at(cur, base, literal_start + k);
+        }
+        i = literal_start + literal_len;
+    }
+    return (size_t) (p - out);
+}
+
+// 압축된 XOR 값을 out에 적용
+static void rle_apply(uint8_t *out, const uint8_t *in, const size_t in_size) {
+    const uint8_t *p = in;
+    const uint8_t *end = in + in_size;
+    size_t pos = 0;
+    while (p < end) {
+        uint32_t zero_len;
+        uint32_t literal_len;
+        p = get_varint(p, &zero_len);
+        p = get_varint(p, &literal_len);
+        pos += zero_len;
+        for (uint32_t k = 0; k < literal_len; k++) {
+            out[pos + k] ^= p[k];
+        }
+        p += literal_len;
+        pos += literal_len;
+    }
+}
+
+static inline struct rewind_entry *entry_at(const struct rewind *rewind, const uint64_t n) {
+    return &rewind->entries[n % rewind->entry_capacity];
+}
+
+errcode_t rewind_init(struct rewind *rewind, const size_t budget, const uint32_t interval) {
+    memset(rewind, 0, sizeof(*rewind));
+    if (budget < REWIND_MIN_BUDGET || budget > UINT32_MAX || interval == 0) {
+        log_error("Invalid rewind budget %zu bytes (min %zu) or interval %u",
+                  budget, (size_t) REWIND_MIN_BUDGET, interval);
+        return ERR_INVALID_PARAMETER;
+    }
+
+    // 항목이 아주 작을 때도 예산을 대부분 쓸 수 있을 만큼, 최소 keyframe 그룹 4개
+    rewind->entry_capacity = (uint32_t) (budget / 64);
+    if (rewind->entry_capacity < 4 * interval) {
+        rewind->entry_capacity = 4 * interval;
+    }
+    rewind->data = malloc(budget);
+    rewind->entries = malloc(rewind->entry_capacity * sizeof(*rewind->entries));
+    rewind->scratch = malloc(RLE_MAX_SIZE(sizeof(struct savestate)));
+    if (!rewind->data || !rewind->entries || !rewind->scratch) {
+        rewind_free(rewind);
+        return ERR_UNKNOWN;
+    }
+    rewind->capacity = budget;
+    rewind->interval = interval;
+    return ERR_NONE;
+}
+
+void rewind_free(struct rewind *rewind) {
+    free(rewind->data);
+    free(rewind->entries);
+    free(rewind->scratch);
+    rewind->data = NULL;
+    rewind->entries = NULL;
+    rewind->scratch = NULL;
+    rewind->capacity = 0;
+}
+
+static void clear(struct rewind *rewind) {
+    rewind->entry_tail = rewind->entry_head;
+    rewind->write_offset = 0;
+    rewind->since_keyframe = 0;
+}
+
+// 가장 오래된 keyframe 그룹을 통째로 버림
+static void evict_group(struct rewind *rewind) {
+    do {
+        ++rewind->entry_tail;
+        ++rewind->first_frame;
+        ++rewind->evicted_frames;
+    } while (!rewind_empty(rewind) && !entry_at(rewind, rewind->entry_tail)->keyframe);
+}
+
+// size 바이트를 연속으로 쓸 위치 확보, 필요하면 오래된 그룹을 버림
+// keyframe이 아닌 항목은 자기 그룹(현재 그룹)을 버려야 하는 경우 false
+static bool reserve(struct rewind *rewind, const size_t size, const bool keyframe, size_t *offset) {
+    for (;;) {
+        if (rewind_empty(rewind)) {
+            rewind->write_offset = 0;
+            *offset = 0;
+            return true;
+        }
+        if (rewind->entry_head - rewind->entry_tail < rewind->entry_capacity) {
+            // 바뀐 것이 없는 프레임은 데이터 없이 항목만 추가
+            if (size == 0) {
+                *offset = rewind->write_offset;
+                return true;
+            }
+            // 가장 오래된 항목은 항상 크기가 0이 아닌 keyframe이라 write == tail이면 가득 찬 상태
+            const size_t tail = entry_at(rewind, rewind->entry_tail)->offset;
+            const size_t write = rewind->write_offset;
+            if (write > tail) {
+                // 사용 중: [tail, write), 빈 공간: [write, capacity) + [0, tail)
+                if (rewind->capacity - write >= size) {
+                    *offset = write;
+                    return true;
+                }
+                if (tail >= size) {
+                    *offset = 0; // 끝부분은 비워두고 앞에서 다시 시작
+                    return true;
+                }
+            } else if (write < tail && tail - write >= size) {
+                *offset = write;
+                return true;
+            }
+        }
+        if (!keyframe && rewind->first_frame == rewind->keyframe_frame) {
+            return false;
+        }
+        evict_group(rewind);
+    }
+}
+
+void rewind_push(struct rewind *rewind, const uint64_t frame, const struct savestate *state) {
+    if (!rewind_empty(rewind) && frame != rewind_newest_frame(rewind) + 1) {
+        clear(rewind); // 되감기 없이 상태가 바뀜 (세이브 스테이트 복원 등)
+    }
+
+    const uint8_t *cur = (const uint8_t *) state;
+    bool keyframe = rewind_empty(rewind) || rewind->since_keyframe >= rewind->interval;
+    size_t size = rle_encode(rewind->scratch, cur, keyframe ? NULL : (const uint8_t *) &rewind->keyframe,
+                             sizeof(*state));
+    size_t offset;
+    if (!reserve(rewind, size, keyframe, &offset)) {
+        // 공간을 만들려면 현재 그룹의 keyframe을 버려야 하므로 이 프레임부터 새 그룹 시작
+        keyframe = true;
+        size = rle_encode(rewind->scratch, cur, NULL, sizeof(*state));
+        reserve(rewind, size, true, &offset);
+    }
+    if (rewind_empty(rewind)) {
+        rewind->first_frame = frame;
+    }
+
+    memcpy(rewind->data + offset, rewind->scratch, size);
+    struct rewind_entry *entry = entry_at(rewind, rewind->entry_head);
+    entry->offset = (uint32_t) offset;
+    entry->size = (uint32_t) size;
+    entry->keyframe = keyframe;
+    ++rewind->entry_head;
+    rewind->write_offset = offset + size;
+
+    if (keyframe) {
+        rewind->keyframe = *state;
+        rewind->keyframe_frame = frame;
+        rewind->since_keyframe = 1;
+        ++rewind->keyframes;
+    } else {
+        ++rewind->since_keyframe;
+    }
+    ++rewind->frames;
+    rewind->bytes += size;
+}
+
+// n번째 항목이 속한 그룹의 keyframe 항목 번호 (가장 오래된 항목은 항상 keyframe)
+static uint64_t find_keyframe(const struct rewind *rewind, uint64_t n) {
+    while (!entry_at(rewind, n)->keyframe) {
+        --n;
+    }
+    return n;
+}
+
+static void decode_entry(const struct rewind *rewind, const uint64_t n, uint8_t *out) {
+    const struct rewind_entry *entry = entry_at(rewind, n);
+    rle_apply(out, rewind->data + entry->offset, entry->size);
+}
+
+bool rewind_seek(const struct rewind *rewind, const uint64_t frame, struct savestate *out) {
+    if (rewind_empty(rewind) || frame < rewind->first_frame || frame > rewind_newest_frame(rewind)) {
+        return false;
+    }
+    const uint64_t n = rewind->entry_tail + (frame - rewind->first_frame);
+    const uint64_t key = find_keyframe(rewind, n);
+
+    memset(out, 0, sizeof(*out));
+    decode_entry(rewind, key, (uint8_t *) out);
+    if (key != n) {
+        decode_entry(rewind, n, (uint8_t *) out);
+    }
+    return true;
+}
+
+void rewind_truncate(struct rewind *rewind, const uint64_t frame) {
+    if (rewind_empty(rewind) || frame >= rewind_newest_frame(rewind)) {
+        return;
+    }
+    if (frame < rewind->first_frame) {
+        clear(rewind);
+        return;
+    }
+    const uint64_t n = rewind->entry_tail + (frame - rewind->first_frame);
+    rewind->entry_head = n + 1;
+    rewind->write_offset = entry_at(rewind, n)->offset + entry_at(rewind, n)->size;
+
+    // 다음 delta의 기준을 frame이 속한 그룹의 keyframe으로
+    const uint64_t key = find_keyframe(rewind, n);
+    memset(&rewind->keyframe, 0, sizeof(rewind->keyframe));
+    decode_entry(rewind, key, (uint8_t *) &rewind->keyframe);
+    rewind->keyframe_frame = rewind->first_frame + (key - rewind->entry_tail);
+    rewind->since_keyframe = (uint32_t) (n - key + 1);
+}
+
+void rewind_report(const struct rewind *rewind) {
+    if (!rewind->frames) {
+        return;
+    }
+    const uint64_t stored = rewind->entry_head - rewind->entry_tail;
+    log_info("Rewind: %llu frames pushed, avg %.1f bytes/frame (%.1f KB/s), %llu keyframes, "
+             "%llu frames (%.1f s) kept, %llu evicted",
+             (unsigned long long) rewind->frames, (double) rewind->bytes / (double) rewind->frames,
+             (double) rewind->bytes / (double) rewind->frames * 60.0 / 1024.0,
+             (unsigned long long) rewind->keyframes, (unsigned long long) stored, (double) stored / 60.0,
+             (unsigned long long) rewind->evicted_frames);
+}
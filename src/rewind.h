@@ -0,0 +1,84 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errcode.h"
+#include "savestate.h"
+
+/*
+ * 되감기 버퍼
+ * 프레임마다 머신 상태(struct savestate)를 저장하되, 마지막 keyframe과의 XOR 결과를 RLE로 압축해서 저장한다.
+ * 대부분의 프레임은 메모리/레지스터/화면 중 몇 바이트만 바뀌므로 프레임당 수십~수백 바이트면 충분하다.
+ * - keyframe: interval 프레임마다 전체 상태 (0과 XOR한 것을 같은 방식으로 RLE 압축)
+ * - delta: 같은 그룹의 keyframe과 XOR
+ * 임의 프레임 복원은 keyframe 하나 + delta 하나 디코드로 끝난다. (keyframe 간격과 무관하게 상수 시간)
+ *
+ * 압축 데이터는 budget 바이트 고정 크기 링 버퍼에 쌓고, 공간이 모자라면 가장 오래된 keyframe 그룹부터 통째로 버린다.
+ */
+
+#define REWIND_DEFAULT_INTERVAL 60 // 1초마다 keyframe
+
+struct rewind_entry {
+    uint32_t offset;    // 링 버퍼 안 위치
+    uint32_t size;      // 압축된 크기
+    bool keyframe;
+};
+
+struct rewind {
+    uint8_t *data;              // 압축 데이터 링 버퍼
+    size_t capacity;
+    size_t write_offset;        // 다음 기록 위치
+
+    struct rewind_entry *entries; // 프레임별 위치, entry_capacity 크기 링
+    uint32_t entry_capacity;
+    uint64_t entry_head;        // 지금까지 추가한 항목 수
+    uint64_t entry_tail;        // 가장 오래된 항목 번호
+    uint64_t first_frame;       // entry_tail 항목의 프레임 번호
+
+    uint32_t interval;          // keyframe 간격 (프레임)
+    uint32_t since_keyframe;    // 마지막 keyframe 이후 저장한 프레임 수
+    uint64_t keyframe_frame;    // 현재 그룹 keyframe의 프레임 번호
+    struct savestate keyframe;  // 현재 그룹 keyframe 원본 (delta 기준)
+    uint8_t *scratch;           // 인코딩 버퍼
+
+    /* 통계 */
+    uint64_t frames;            // 저장한 프레임 수
+    uint64_t bytes;             // 저장한 압축 데이터 크기 합
+    uint64_t keyframes;
+    uint64_t evicted_frames;    // 공간이 모자라 버린 프레임 수
+};
+
+// budget: 압축 데이터에 쓸 메모리 (바이트), interval: keyframe 간격 (프레임)
+errcode_t rewind_init(struct rewind *rewind, size_t budget, uint32_t interval);
+
+void rewind_free(struct rewind *rewind);
+
+// frame 번호의 상태 저장, 마지막으로 저장한 프레임 바로 다음이 아니면 이전 기록을 모두 버리고 새로 시작
+void rewind_push(struct rewind *rewind, uint64_t frame, const struct savestate *state);
+
+// frame 번호의 상태를 *out에 복원, 버퍼에 없으면 false
+bool rewind_seek(const struct rewind *rewind, uint64_t frame, struct savestate *out);
+
+// frame 이후의 기록을 버림 (되감은 뒤 새 진행으로 덮어쓰기 위해), 다음 push는 frame + 1
+void rewind_truncate(struct rewind *rewind, uint64_t frame);
+
+static inline bool rewind_empty(const struct rewind *rewind) {
+    return rewind->entry_head == rewind->entry_tail;
+}
+
+// 저장된 가장 오래된 / 최근 프레임 번호 (비어 있지 않을 때만 의미 있음)
+static inline uint64_t rewind_oldest_frame(const struct rewind *rewind) {
+    return rewind->first_frame;
+}
+
+static inline uint64_t rewind_newest_frame(const struct rewind *rewind) {
+    return rewind->first_frame + (rewind->entry_head - rewind->entry_tail) - 1;
+}
+
+// 저장량 통계 로그
+void rewind_report(const struct rewind *rewind);
+
+#endif // REWIND_H
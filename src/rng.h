@@ -0,0 +1,32 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <stdint.h>
+
+/*
+ * Cxkk(RND)용 난수 생성기 (splitmix64)
+ * 상태가 64비트 값 하나라서 기록/재생, 세이브 스테이트에 그대로 저장할 수 있다.
+ * libc rand()와 달리 시드가 같으면 플랫폼과 상관없이 같은 수열이 나온다.
+ */
+
+struct rng {
+    uint64_t state;
+};
+
+static inline void rng_seed(struct rng *rng, const uint64_t seed) {
+    rng->state = seed;
+}
+
+static inline uint64_t rng_next(struct rng *rng) {
+    uint64_t z = (rng->state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// 상위 비트가 품질이 좋으므로 최상위 바이트 사용
+static inline uint8_t rng_next_byte(struct rng *rng) {
+    return (uint8_t) (rng_next(rng) >> 56);
+}
+
+#endif // RNG_H
@@ -0,0 +1,85 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "savestate.h"
+
+errcode_t savestate_create(struct savestate_file *file, const char *path) {
+    file->fd = -1;
+    file->state = NULL;
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        log_error("Failed to create save state %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    if (ftruncate(fd, sizeof(struct savestate)) != 0) {
+        log_error("Failed to size save state: %s", strerror(errno));
+        close(fd);
+        return ERR_UNKNOWN;
+    }
+    void *map = mmap(NULL, sizeof(struct savestate), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map save state: %s", strerror(errno));
+        close(fd);
+        return ERR_UNKNOWN;
+    }
+
+    file->fd = fd;
+    file->state = map;
+    memcpy(file->state->magic, SAVESTATE_MAGIC, sizeof(SAVESTATE_MAGIC));
+    file->state->version = SAVESTATE_VERSION;
+    file->state->size = sizeof(struct savestate);
+    return ERR_NONE;
+}
+
+errcode_t savestate_open(struct savestate_file *file, const char *path) {
+    file->fd = -1;
+    file->state = NULL;
+
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        log_error("Failed to open save state %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size != (off_t) sizeof(struct savestate)) {
+        log_error("%s: not a save state (size mismatch)", path);
+        close(fd);
+        return ERR_INVALID_PARAMETER;
+    }
+    void *map = mmap(NULL, sizeof(struct savestate), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map save state: %s", strerror(errno));
+        close(fd);
+        return ERR_UNKNOWN;
+    }
+
+    const struct savestate *state = map;
+    if (memcmp(state->magic, SAVESTATE_MAGIC, sizeof(SAVESTATE_MAGIC)) != 0
+        || state->version != SAVESTATE_VERSION || state->size != sizeof(struct savestate)) {
+        log_error("%s: unsupported save state (version %u)", path, state->version);
+        munmap(map, sizeof(struct savestate));
+        close(fd);
+        return ERR_INVALID_PARAMETER;
+    }
+
+    file->fd = fd;
+    file->state = map;
+    return ERR_NONE;
+}
+
+void savestate_close(struct savestate_file *file) {
+    if (file->state) {
+        munmap(file->state, sizeof(struct savestate));
+        file->state = NULL;
+    }
+    if (file->fd >= 0) {
+        close(file->fd);
+        file->fd = -1;
+    }
+}
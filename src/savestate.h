@@ -0,0 +1,63 @@
+#ifndef SAVESTATE_H
+#define SAVESTATE_H
+
+#include <stdint.h>
+
+#include "chip8.h"
+#include "errcode.h"
+#include "keypad.h"
+
+/*
+ * 세이브 스테이트
+ * 머신 전체 상태(struct chip8, 난수 상태, 타이머/프레임 누적값, 실행 위치, 키패드)를 고정 레이아웃 구조체 하나로 저장한다.
+ * --max-instructions나 재생 종료로 프레임 중간에서 멈추면 그 프레임의 남은 명령어 수도 저장해서,
+ * 복원한 뒤 첫 프레임은 남은 명령어만 실행하고 타이머를 갱신한다. (끊기지 않고 실행한 것과 같은 명령어 수열)
+ * 파일은 이 구조체 그대로라서 저장은 mmap한 파일에 직접 채우고, 복원은 mmap한 파일에서 한 번 복사하면 끝난다.
+ * 레이아웃이 바뀌면 SAVESTATE_VERSION을 올린다. (엔디언/ABI가 같은 호스트끼리만 호환)
+ */
+
+#define SAVESTATE_MAGIC   "C8STATE"
+#define SAVESTATE_VERSION 1
+
+struct savestate {
+    char magic[8];                  // SAVESTATE_MAGIC
+    uint32_t version;
+    uint32_t size;                  // sizeof(struct savestate)
+
+    /* 저장 당시 실행 조건 (참고용) */
+    uint32_t ips;
+    uint8_t clip_sprites;
+    uint8_t reserved0[3];
+
+    /* 실행 위치 */
+    uint64_t instructions;          // 실행한 명령어 수 (입력 재생 위치와 같은 기준)
+    uint64_t frames;                // 실행한 프레임 수
+
+    uint64_t rng_state;             // Cxkk 난수 생성기 상태
+    uint64_t timer_accumulator_ns;  // 60Hz 타이머 누적 시간
+    struct keypad_snapshot keypad;
+    uint32_t ips_remainder;         // 프레임 명령어 수의 나머지 누적 (struct chip8_state와 같음)
+    uint32_t frame_remaining;       // 중간에 끊긴 프레임에서 남은 명령어 수, 0이면 프레임 경계에서 저장
+    uint8_t reserved[56];
+
+    struct chip8 chip;              // 메모리, 레지스터, 스택, 타이머, 화면
+};
+
+// 파일 형식이 모르게 바뀌지 않도록 크기 고정 (C99라 배열 크기로 검사)
+typedef char savestate_chip8_size_check[(sizeof(struct chip8) == 4408) ? 1 : -1];
+typedef char savestate_size_check[(sizeof(struct savestate) == 4664) ? 1 : -1];
+
+struct savestate_file {
+    int fd;
+    struct savestate *state;        // mmap된 파일
+};
+
+// 쓰기용으로 파일을 만들고 매핑, 헤더는 채워져 있음. 나머지를 채운 뒤 savestate_close()
+errcode_t savestate_create(struct savestate_file *file, const char *path);
+
+// 읽기용으로 매핑하고 헤더 검사
+errcode_t savestate_open(struct savestate_file *file, const char *path);
+
+void savestate_close(struct savestate_file *file);
+
+#endif // SAVESTATE_H
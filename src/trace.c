@@ -0,0 +1,79 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "log.h"
+#include "trace.h"
+
+errcode_t trace_open(struct trace_writer *trace, const char *path, const uint64_t capacity) {
+    memset(trace, 0, sizeof(*trace));
+    trace->fd = -1;
+
+    if (capacity == 0 || capacity > TRACE_MAX_RECORDS
+        || (SIZE_MAX - sizeof(struct trace_header)) / sizeof(struct trace_record) < capacity) {
+        log_error("Invalid trace capacity: %llu records", (unsigned long long) capacity);
+        return ERR_INVALID_PARAMETER;
+    }
+    const size_t size = sizeof(struct trace_header) + capacity * sizeof(struct trace_record);
+
+    const int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        log_error("Failed to open trace file %s: %s", path, strerror(errno));
+        return ERR_FILE_NOT_FOUND;
+    }
+    // 실행 중에 파일 크기를 늘리지 않도록 미리 전체 크기 확보
+    if (ftruncate(fd, (off_t) size) != 0) {
+        log_error("Failed to size trace file: %s", strerror(errno));
+        close(fd);
+        return ERR_UNKNOWN;
+    }
+    // 기록 중 페이지 폴트가 나지 않도록 가능하면 미리 매핑 (Linux MAP_POPULATE)
+#ifdef MAP_POPULATE
+    const int map_flags = MAP_SHARED | MAP_POPULATE;
+#else
+    const int map_flags = MAP_SHARED;
+#endif
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, map_flags, fd, 0);
+    if (map == MAP_FAILED) {
+        log_error("Failed to map trace file: %s", strerror(errno));
+        close(fd);
+        return ERR_UNKNOWN;
+    }
+
+    trace->fd = fd;
+    trace->header = map;
+    trace->records = (struct trace_record *) (trace->header + 1);
+    trace->capacity = capacity;
+
+    memcpy(trace->header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    trace->header->version = TRACE_VERSION;
+    trace->header->record_size = sizeof(struct trace_record);
+    trace->header->capacity = capacity;
+    trace->header->count = 0;
+
+    log_info("Tracing to %s (%llu records)", path, (unsigned long long) capacity);
+    return ERR_NONE;
+}
+
+void trace_close(struct trace_writer *trace) {
+    if (!trace->header) {
+        return;
+    }
+    const size_t mapped = sizeof(struct trace_header) + trace->capacity * sizeof(struct trace_record);
+    const size_t used = sizeof(struct trace_header) + trace->count * sizeof(struct trace_record);
+
+    trace->header->capacity = trace->count;
+    munmap(trace->header, mapped);
+    if (ftruncate(trace->fd, (off_t) used) != 0) {
+        log_warn("Failed to shrink trace file: %s", strerror(errno));
+    }
+    close(trace->fd);
+
+    log_info("Trace closed: %llu records", (unsigned long long) trace->count);
+    trace->header = NULL;
+    trace->records = NULL;
+    trace->fd = -1;
+}
@@ -0,0 +1,83 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "errcode.h"
+
+/*
+ * 바이너리 명령어 트레이스
+ * 명령어마다 16바이트 고정 크기 레코드를 미리 할당해 mmap한 파일에 그대로 저장한다.
+ * 실행 중에는 포맷팅 없이 레코드 필드만 채우고, 해석은 chip8-tracedump 도구가 한다.
+ *
+ * 파일 구조: struct trace_header + struct trace_record * capacity
+ * 파일이 가득 차면 더 이상 기록하지 않는다. (header.count == capacity)
+ */
+
+#define TRACE_MAGIC     "C8TRACE"
+#define TRACE_VERSION   1
+#define TRACE_NO_REG    0xFF // 명령어가 V 레지스터를 바꾸지 않음
+#define TRACE_MAX_RECORDS (1ULL << 30) // 레코드 수 상한 (16GB), 파일 크기 계산이 넘치지 않도록
+
+struct trace_header {
+    char magic[8];          // TRACE_MAGIC
+    uint32_t version;
+    uint32_t record_size;   // sizeof(struct trace_record)
+    uint64_t capacity;      // 미리 할당한 레코드 수
+    uint64_t count;         // 기록된 레코드 수, 기록할 때마다 갱신되므로 비정상 종료해도 유효
+    uint8_t reserved[32];
+};
+
+// 명령어 실행 후 상태
+struct trace_record {
+    uint32_t cycle_lo;      // 실행 순번 (하위 32비트)
+    uint16_t pc;            // 명령어 주소
+    uint16_t opcode;
+    uint16_t i;             // 실행 후 I
+    uint8_t reg;            // 명령어가 쓴 V 레지스터 번호, 없으면 TRACE_NO_REG (Fx65는 마지막 레지스터)
+    uint8_t value;          // 그 레지스터의 실행 후 값
+    uint8_t vf;             // 실행 후 VF
+    uint8_t cycle_hi;       // 실행 순번 (상위 8비트)
+    uint8_t sp;             // 실행 후 sp
+    uint8_t reserved;
+};
+
+// 파일 형식이 바뀌지 않도록 크기 고정 (C99라 배열 크기로 검사)
+typedef char trace_header_size_check[(sizeof(struct trace_header) == 64) ? 1 : -1];
+typedef char trace_record_size_check[(sizeof(struct trace_record) == 16) ? 1 : -1];
+
+static inline uint64_t trace_record_cycle(const struct trace_record *record) {
+    return ((uint64_t) record->cycle_hi << 32) | record->cycle_lo;
+}
+
+struct trace_writer {
+    int fd;
+    struct trace_header *header; // mmap된 파일 시작
+    struct trace_record *records;
+    uint64_t capacity;
+    uint64_t count;
+    uint64_t cycle;
+    bool full_reported;
+};
+
+// capacity는 1..TRACE_MAX_RECORDS, 파일 크기가 size_t를 넘으면 ERR_INVALID_PARAMETER
+errcode_t trace_open(struct trace_writer *trace, const char *path, uint64_t capacity);
+
+// 기록한 만큼으로 파일 크기를 줄이고 닫음
+void trace_close(struct trace_writer *trace);
+
+// 다음 레코드 자리, 가득 찼으면 NULL. 채운 뒤 trace_commit() 호출
+static inline struct trace_record *trace_next(struct trace_writer *trace) {
+    if (trace->count == trace->capacity) {
+        return 0;
+    }
+    return &trace->records[trace->count];
+}
+
+static inline void trace_commit(struct trace_writer *trace) {
+    ++trace->count;
+    trace->header->count = trace->count;
+}
+
+#endif // TRACE_H
@@ -0,0 +1,235 @@
+/*
+ * chip8-tracedump: 바이너리 트레이스 해석기
+ *
+ * 사용법: chip8-tracedump [options] <trace>
+ *   --pc=LO-HI    pc가 범위(16진수, 양 끝 포함) 안인 레코드만
+ *   --op=NAME     명령어 종류가 NAME인 레코드만 (예: DRW, LD_VX_KK)
+ *   --limit=N     최대 N개 출력
+ *   --summary     레코드는 출력하지 않고 요약만
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <getopt.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "chip8.h"
+#include "opcodes.h"
+#include "trace.h"
+
+#define SUMMARY_TOP_PCS 10
+
+struct filter {
+    uint16_t pc_lo;
+    uint16_t pc_hi;
+    int op; // -1이면 전체
+    uint64_t limit;
+    bool summary_only;
+};
+
+static void print_usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options] <trace>\n"
+            "  --pc=LO-HI  pc 범위 (16진수, 예: 200-2FF)\n"
+            "  --op=NAME   명령어 종류 (예: DRW, LD_VX_KK)\n"
+            "  --limit=N   최대 N개 출력\n"
+            "  --summary   요약만 출력\n",
+            prog);
+}
+
+static int parse_op_name(const char *name) {
+    for (int op = CHIP8_OP_INVALID; op < CHIP8_OP_COUNT; op++) {
+        if (strcasecmp(name, chip8_op_name((enum chip8_op) op)) == 0) {
+            return op;
+        }
+    }
+    return -1;
+}
+
+static bool parse_pc_range(const char *arg, struct filter *filter) {
+    char *end;
+    const unsigned long lo = strtoul(arg, &end, 16);
+    if (*end != '-') {
+        return false;
+    }
+    const unsigned long hi = strtoul(end + 1, &end, 16);
+    if (*end != '\0' || lo > hi || hi > 0xFFFF) {
+        return false;
+    }
+    filter->pc_lo = (uint16_t) lo;
+    filter->pc_hi = (uint16_t) hi;
+    return true;
+}
+
+static void print_record(const struct trace_record *record) {
+    struct chip8_insn in;
+    chip8_decode_insn(&in, record->opcode);
+    char text[32];
+    chip8_disasm(&in, text, sizeof(text));
+
+    printf("%10llu  %03X  %04X  %-18s I=%03X VF=%02X SP=%X",
+           (unsigned long long) trace_record_cycle(record), record->pc, record->opcode, text,
+           record->i, record->vf, record->sp);
+    if (record->reg != TRACE_NO_REG) {
+        printf("  V%X=%02X", record->reg, record->value);
+    }
+    putchar('\n');
+}
+
+static void print_summary(const struct trace_header *header, const struct trace_record *records,
+                          const uint64_t matched, const uint64_t *op_counts, const uint64_t *pc_counts) {
+    printf("records: %llu (capacity %llu), matched: %llu\n",
+           (unsigned long long) header->count, (unsigned long long) header->capacity,
+           (unsigned long long) matched);
+    if (header->count > 0) {
+        printf("cycles: %llu - %llu\n",
+               (unsigned long long) trace_record_cycle(&records[0]),
+               (unsigned long long) trace_record_cycle(&records[header->count - 1]));
+    }
+    if (matched == 0) {
+        return;
+    }
+
+    printf("\nby instruction:\n");
+    for (int op = CHIP8_OP_INVALID; op < CHIP8_OP_COUNT; op++) {
+        if (op_counts[op]) {
+            printf("  %-10s %12llu  %5.1f%%\n", chip8_op_name((enum chip8_op) op),
+                   (unsigned long long) op_counts[op], 100.0 * (double) op_counts[op] / (double) matched);
+        }
+    }
+
+    printf("\ntop pc:\n");
+    static bool used[MEMORY_SIZE];
+    for (int rank = 0; rank < SUMMARY_TOP_PCS; rank++) {
+        int best = -1;
+        for (int pc = 0; pc < MEMORY_SIZE; pc++) {
+            if (!used[pc] && pc_counts[pc] && (best < 0 || pc_counts[pc] > pc_counts[best])) {
+                best = pc;
+            }
+        }
+        if (best < 0) {
+            break;
+        }
+        used[best] = true;
+        printf("  %03X %12llu  %5.1f%%\n", best, (unsigned long long) pc_counts[best],
+               100.0 * (double) pc_counts[best] / (double) matched);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct filter filter = {.pc_lo = 0, .pc_hi = 0xFFFF, .op = -1, .limit = UINT64_MAX, .summary_only = false};
+
+    enum { OPT_PC = 0x100, OPT_OP, OPT_LIMIT, OPT_SUMMARY };
+    static const struct option long_options[] = {
+        {"pc", required_argument, NULL, OPT_PC},
+        {"op", required_argument, NULL, OPT_OP},
+        {"limit", required_argument, NULL, OPT_LIMIT},
+        {"summary", no_argument, NULL, OPT_SUMMARY},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+    int opt;
+    while ((opt = getopt_long(argc, argv, "h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case OPT_PC:
+                if (!parse_pc_range(optarg, &filter)) {
+                    fprintf(stderr, "Invalid --pc: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_OP:
+                filter.op = parse_op_name(optarg);
+                if (filter.op < 0) {
+                    fprintf(stderr, "Unknown instruction: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case OPT_LIMIT:
+                filter.limit = strtoull(optarg, NULL, 10);
+                break;
+            case OPT_SUMMARY:
+                filter.summary_only = true;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+    if (optind != argc - 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    const char *path = argv[optind];
+    const int fd = open(path, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+    if ((size_t) st.st_size < sizeof(struct trace_header)) {
+        fprintf(stderr, "%s: not a trace file\n", path);
+        return 1;
+    }
+    const void *map = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return 1;
+    }
+
+    const struct trace_header *header = map;
+    if (memcmp(header->magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 ||
+        header->version != TRACE_VERSION || header->record_size != sizeof(struct trace_record)) {
+        fprintf(stderr, "%s: not a trace file (or unsupported version)\n", path);
+        return 1;
+    }
+    // 비정상 종료로 파일이 줄어들지 않았어도 count까지만 유효
+    const uint64_t available = ((uint64_t) st.st_size - sizeof(*header)) / sizeof(struct trace_record);
+    struct trace_header checked = *header;
+    if (checked.count > available) {
+        checked.count = available;
+    }
+    const struct trace_record *records = (const struct trace_record *) (header + 1);
+
+    static uint64_t op_counts[CHIP8_OP_COUNT];
+    static uint64_t pc_counts[MEMORY_SIZE];
+    uint64_t matched = 0;
+    uint64_t printed = 0;
+
+    for (uint64_t n = 0; n < checked.count; n++) {
+        const struct trace_record *record = &records[n];
+        if (record->pc < filter.pc_lo || record->pc > filter.pc_hi) {
+            continue;
+        }
+        const enum chip8_op op = chip8_decode_op(record->opcode);
+        if (filter.op >= 0 && (int) op != filter.op) {
+            continue;
+        }
+        ++matched;
+        ++op_counts[op];
+        ++pc_counts[record->pc & MEMORY_ADDR_MASK];
+        if (!filter.summary_only && printed < filter.limit) {
+            print_record(record);
+            ++printed;
+        }
+    }
+
+    if (!filter.summary_only) {
+        putchar('\n');
+    }
+    print_summary(&checked, records, matched, op_counts, pc_counts);
+
+    munmap((void *) map, (size_t) st.st_size);
+    close(fd);
+    return 0;
+}
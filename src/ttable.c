@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "ttable.h"
+
+#define TTABLE_CACHE_LINE 64
+#define TTABLE_ZERO_KEY 0x8000000000000001ULL // 해시가 0인 상태를 저장할 때 쓰는 키
+
+struct ttable_entry {
+    uint64_t key; // 0이면 빈 칸
+    uint64_t value;
+};
+
+struct chip8_ttable {
+    struct ttable_entry *entries;
+    uint64_t mask;
+    struct chip8_ttable_stats stats;
+};
+
+struct chip8_ttable *chip8_ttable_create(const size_t capacity) {
+    if (capacity == 0 || capacity > CHIP8_TTABLE_MAX_CAPACITY) {
+        return NULL;
+    }
+    size_t slots = CHIP8_TTABLE_PROBE_LIMIT;
+    while (slots < capacity) {
+        slots <<= 1;
+    }
+
+    struct chip8_ttable *table = calloc(1, sizeof(*table));
+    if (!table) {
+        return NULL;
+    }
+    void *entries = NULL;
+    if (posix_memalign(&entries, TTABLE_CACHE_LINE, slots * sizeof(struct ttable_entry)) != 0) {
+        free(table);
+        return NULL;
+    }
+    table->entries = entries;
+    table->mask = slots - 1;
+    table->stats.capacity = slots;
+    chip8_ttable_clear(table);
+    return table;
+}
+
+void chip8_ttable_destroy(struct chip8_ttable *table) {
+    if (table) {
+        free(table->entries);
+        free(table);
+    }
+}
+
+void chip8_ttable_clear(struct chip8_ttable *table) {
+    memset(table->entries, 0, table->stats.capacity * sizeof(struct ttable_entry));
+    const size_t capacity = table->stats.capacity;
+    memset(&table->stats, 0, sizeof(table->stats));
+    table->stats.capacity = capacity;
+}
+
+/*
+ * 키의 칸을 찾음: 키가 있는 칸, 없으면 탐색 범위 안의 첫 빈 칸, 둘 다 없으면 NULL
+ * 해시는 이미 고르게 섞인 값이라 하위 비트를 그대로 시작 칸으로 씀
+ */
+static struct ttable_entry *probe(struct chip8_ttable *table, const uint64_t key, bool *found) {
+    ++table->stats.lookups;
+    for (uint64_t n = 0; n < CHIP8_TTABLE_PROBE_LIMIT; n++) {
+        struct ttable_entry *entry = &table->entries[(key + n) & table->mask];
+        if (entry->key == key) {
+            ++table->stats.hits;
+            *found = true;
+            return entry;
+        }
+        if (entry->key == 0) {
+            *found = false;
+            return entry;
+        }
+    }
+    *found = false;
+    return NULL;
+}
+
+// 새 키를 넣을 칸, 탐색 범위가 가득 찼으면 시작 칸을 비워서 씀
+static struct ttable_entry *claim(struct chip8_ttable *table, struct ttable_entry *entry, const uint64_t key) {
+    if (entry) {
+        ++table->stats.count;
+    } else {
+        entry = &table->entries[key & table->mask];
+        ++table->stats.evictions;
+    }
+    entry->key = key;
+    return entry;
+}
+
+static inline uint64_t stored_key(const uint64_t key) {
+    return key ? key : TTABLE_ZERO_KEY;
+}
+
+bool chip8_ttable_lookup(struct chip8_ttable *table, uint64_t key, uint64_t *value) {
+    key = stored_key(key);
+    bool found;
+    const struct ttable_entry *entry = probe(table, key, &found);
+    if (found) {
+        *value = entry->value;
+    }
+    return found;
+}
+
+bool chip8_ttable_insert(struct chip8_ttable *table, uint64_t key, const uint64_t value, uint64_t *existing) {
+    key = stored_key(key);
+    bool found;
+    struct ttable_entry *entry = probe(table, key, &found);
+    if (found) {
+        if (existing) {
+            *existing = entry->value;
+        }
+        return true;
+    }
+    claim(table, entry, key)->value = value;
+    return false;
+}
+
+void chip8_ttable_put(struct chip8_ttable *table, uint64_t key, const uint64_t value) {
+    key = stored_key(key);
+    bool found;
+    struct ttable_entry *entry = probe(table, key, &found);
+    if (!found) {
+        entry = claim(table, entry, key);
+    }
+    entry->value = value;
+}
+
+void chip8_ttable_get_stats(const struct chip8_ttable *table, struct chip8_ttable_stats *stats) {
+    *stats = table->stats;
+}
@@ -0,0 +1,49 @@
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * 트랜스포지션 테이블: 상태 해시(chip8_state_hash()) -> 64비트 값 (탐색 깊이, 점수, 노드 번호 등 호출한 쪽이 정함)
+ * 크기가 고정된 open addressing 해시 테이블, 항목은 키와 값 16바이트이고 테이블은 캐시 라인에 맞춰 할당한다.
+ * 키의 시작 칸부터 CHIP8_TTABLE_PROBE_LIMIT칸(캐시 라인 2개) 안에서만 찾고, 그 안에 빈 칸이 없으면
+ * 시작 칸의 항목을 새 항목으로 바꾼다. (always-replace) 그래서 메모리는 늘지 않고 대신 오래된 상태를 잊을 수 있다.
+ * 키 0은 빈 칸 표시라서 해시가 0인 상태는 다른 고정 키로 바꿔 저장한다.
+ * 스레드 하나에서만 쓴다.
+ */
+
+#define CHIP8_TTABLE_PROBE_LIMIT 8
+#define CHIP8_TTABLE_MAX_CAPACITY (1ULL << 32)
+
+struct chip8_ttable;
+
+struct chip8_ttable_stats {
+    size_t capacity;    // 칸 수
+    size_t count;       // 차 있는 칸 수
+    uint64_t lookups;   // 찾기 (lookup/insert/put)
+    uint64_t hits;      // 그중 키가 있었던 횟수
+    uint64_t evictions; // 탐색 범위가 가득 차서 밀어낸 항목 수
+};
+
+// 칸 capacity개 이상(2의 거듭제곱으로 올림), capacity가 0이거나 너무 크거나 메모리가 부족하면 NULL
+struct chip8_ttable *chip8_ttable_create(size_t capacity);
+
+void chip8_ttable_destroy(struct chip8_ttable *table);
+
+// 모든 항목 삭제 (통계 포함)
+void chip8_ttable_clear(struct chip8_ttable *table);
+
+// 키가 있으면 *value에 값을 넣고 true
+bool chip8_ttable_lookup(struct chip8_ttable *table, uint64_t key, uint64_t *value);
+
+// 키가 없으면 넣고 false, 있으면 값은 그대로 두고 true (방문한 상태 중복 제거), existing이 NULL이 아니면 저장된 값
+bool chip8_ttable_insert(struct chip8_ttable *table, uint64_t key, uint64_t value, uint64_t *existing);
+
+// 키가 있으면 값을 바꾸고 없으면 넣음
+void chip8_ttable_put(struct chip8_ttable *table, uint64_t key, uint64_t value);
+
+void chip8_ttable_get_stats(const struct chip8_ttable *table, struct chip8_ttable_stats *stats);
+
+#endif // TTABLE_H
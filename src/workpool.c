@@ -0,0 +1,220 @@
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "workpool.h"
+
+#define IDLE_SPIN_ROUNDS 64     // 훔칠 작업이 없을 때 pause로 기다리는 횟수
+#define IDLE_YIELD_ROUNDS 1024  // 그 다음 sched_yield()로 기다리는 횟수, 이후는 잠깐씩 잠
+#define IDLE_SLEEP_NS 50000L
+
+/*
+ * Chase-Lev 덱 (Lê et al. 2013의 C11 메모리 순서)
+ * bottom은 주인만 바꾸고, top은 꺼내는 쪽(주인 포함)이 CAS로 올린다.
+ */
+struct deque {
+    int64_t top __attribute__((aligned(WORKPOOL_CACHE_LINE)));
+    int64_t bottom __attribute__((aligned(WORKPOOL_CACHE_LINE)));
+    void **buffer;
+    int64_t mask;
+};
+
+enum take_result {
+    TAKE_OK,
+    TAKE_EMPTY,
+    TAKE_ABORT // 다른 스레드가 먼저 가져감, 다시 시도하면 됨
+};
+
+struct worker {
+    struct deque deque;
+    struct workpool *pool;
+    uint64_t rng;
+    struct workpool_worker_stats stats;
+    pthread_t thread;
+} __attribute__((aligned(WORKPOOL_CACHE_LINE)));
+
+struct workpool {
+    size_t remaining __attribute__((aligned(WORKPOOL_CACHE_LINE))); // 끝나지 않은 작업 수, 0이면 워커 종료
+    struct worker *workers;
+    unsigned count;
+    workpool_fn fn;
+    void *arg;
+};
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+// 주인만 호출
+static void deque_push(struct deque *deque, void *task) {
+    const int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_RELAXED);
+    __atomic_store_n(&deque->buffer[bottom & deque->mask], task, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    __atomic_store_n(&deque->bottom, bottom + 1, __ATOMIC_RELAXED);
+}
+
+// top에서 하나 꺼냄, 주인과 도둑 모두 이것만 씀
+static enum take_result deque_take(struct deque *deque, void **task) {
+    int64_t top = __atomic_load_n(&deque->top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    const int64_t bottom = __atomic_load_n(&deque->bottom, __ATOMIC_ACQUIRE);
+    if (top >= bottom) {
+        return TAKE_EMPTY;
+    }
+    void *const value = __atomic_load_n(&deque->buffer[top & deque->mask], __ATOMIC_RELAXED);
+    if (!__atomic_compare_exchange_n(&deque->top, &top, top + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED)) {
+        return TAKE_ABORT;
+    }
+    *task = value;
+    return TAKE_OK;
+}
+
+static uint64_t xorshift64(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// 자기 덱이 비었을 때: 무작위 워커부터 한 바퀴 돌면서 훔침
+static enum take_result steal(struct worker *self, void **task) {
+    const struct workpool *pool = self->pool;
+    const unsigned self_id = (unsigned) (self - pool->workers);
+    const unsigned start = (unsigned) (xorshift64(&self->rng) % pool->count);
+    enum take_result result = TAKE_EMPTY;
+    for (unsigned n = 0; n < pool->count; n++) {
+        const unsigned victim = (start + n) % pool->count;
+        if (victim == self_id) {
+            continue;
+        }
+        const enum take_result r = deque_take(&pool->workers[victim].deque, task);
+        if (r == TAKE_OK) {
+            ++self->stats.steals;
+            return TAKE_OK;
+        }
+        ++self->stats.failed_steals;
+        if (r == TAKE_ABORT) {
+            result = TAKE_ABORT;
+        }
+    }
+    return result;
+}
+
+static void idle_wait(struct worker *self, const unsigned round) {
+    if (round < IDLE_SPIN_ROUNDS) {
+        cpu_relax();
+    } else if (round < IDLE_SPIN_ROUNDS + IDLE_YIELD_ROUNDS) {
+        ++self->stats.idle_yields;
+        sched_yield();
+    } else {
+        // 남은 작업이 워커 수보다 적을 때 놀고 있는 워커가 코어를 계속 잡고 있지 않도록
+        ++self->stats.idle_yields;
+        const struct timespec ts = {0, IDLE_SLEEP_NS};
+        nanosleep(&ts, NULL);
+    }
+}
+
+static void *worker_main(void *arg) {
+    struct worker *self = arg;
+    struct workpool *pool = self->pool;
+    unsigned idle = 0;
+
+    while (__atomic_load_n(&pool->remaining, __ATOMIC_ACQUIRE) > 0) {
+        void *task;
+        enum take_result r = deque_take(&self->deque, &task);
+        if (r == TAKE_EMPTY && pool->count > 1) {
+            r = steal(self, &task);
+        }
+        if (r != TAKE_OK) {
+            // 경쟁에서 진 것뿐이면 바로 다시 시도
+            if (r == TAKE_EMPTY) {
+                idle_wait(self, idle++);
+            }
+            continue;
+        }
+        idle = 0;
+
+        ++self->stats.runs;
+        if (pool->fn(task, pool->arg)) {
+            deque_push(&self->deque, task);
+        } else {
+            __atomic_sub_fetch(&pool->remaining, 1, __ATOMIC_RELEASE);
+        }
+    }
+    return NULL;
+}
+
+errcode_t workpool_run(void **tasks, const size_t count, const unsigned threads, const workpool_fn fn,
+                       void *arg, struct workpool_worker_stats *stats) {
+    if (threads == 0 || threads > WORKPOOL_MAX_THREADS || !fn) {
+        return ERR_INVALID_PARAMETER;
+    }
+    if (count == 0) {
+        return ERR_NONE;
+    }
+
+    // 덱 하나에 작업 전부가 모여도 넘치지 않는 2의 거듭제곱
+    size_t capacity = 1;
+    while (capacity < count) {
+        capacity <<= 1;
+    }
+
+    struct workpool pool;
+    memset(&pool, 0, sizeof(pool));
+    pool.remaining = count;
+    pool.count = threads;
+    pool.fn = fn;
+    pool.arg = arg;
+    void *workers = NULL;
+    if (posix_memalign(&workers, WORKPOOL_CACHE_LINE, threads * sizeof(struct worker)) != 0) {
+        return ERR_UNKNOWN;
+    }
+    pool.workers = workers;
+    memset(pool.workers, 0, threads * sizeof(struct worker));
+
+    errcode_t err = ERR_NONE;
+    for (unsigned n = 0; n < threads; n++) {
+        struct worker *worker = &pool.workers[n];
+        worker->pool = &pool;
+        worker->rng = 0x9E3779B97F4A7C15ULL * (n + 1);
+        worker->deque.mask = (int64_t) capacity - 1;
+        worker->deque.buffer = malloc(capacity * sizeof(void *));
+        if (!worker->deque.buffer) {
+            err = ERR_UNKNOWN;
+        }
+    }
+
+    unsigned started = 1; // 0번 워커는 호출한 스레드
+    if (err == ERR_NONE) {
+        for (size_t n = 0; n < count; n++) {
+            deque_push(&pool.workers[n % threads].deque, tasks[n]);
+        }
+        for (; started < threads; started++) {
+            if (pthread_create(&pool.workers[started].thread, NULL, worker_main, &pool.workers[started]) != 0) {
+                // 이미 시작한 워커는 멈추고 실패 (그 사이 일부 작업은 실행됐을 수 있음)
+                __atomic_store_n(&pool.remaining, 0, __ATOMIC_RELEASE);
+                err = ERR_THREAD_CREATION_FAILED;
+                break;
+            }
+        }
+        worker_main(&pool.workers[0]);
+        for (unsigned n = 1; n < started; n++) {
+            pthread_join(pool.workers[n].thread, NULL);
+        }
+    }
+
+    for (unsigned n = 0; n < threads; n++) {
+        if (stats) {
+            stats[n] = pool.workers[n].stats;
+        }
+        free(pool.workers[n].deque.buffer);
+    }
+    free(pool.workers);
+    return err;
+}
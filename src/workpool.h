@@ -0,0 +1,39 @@
+#ifndef WORKPOOL_H
+#define WORKPOOL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "errcode.h"
+
+/*
+ * work-stealing 스레드 풀
+ * 작업은 끝날 때까지 실행 -> 다시 넣기를 반복하는 포인터 하나 (chip8-farm의 인스턴스 하나)
+ * 워커마다 Chase-Lev 덱을 두고, 작업을 실행한 워커가 자기 덱 bottom에 다시 넣는다.
+ * 꺼낼 때는 주인도 도둑과 같이 top(가장 오래 기다린 작업)에서 꺼내서 한 워커의 작업들이 돌아가며 실행된다.
+ * 자기 덱이 비면 무작위로 고른 다른 워커의 top에서 훔쳐오고, 훔친 작업은 그 뒤로 자기 덱에서 돈다.
+ * 작업은 항상 덱 하나에만 있고 전체 개수가 고정이라 덱 크기는 처음에 정하고 늘리지 않는다.
+ * 덱에 넣고 꺼내는 것이 release/acquire라서 작업 내용은 워커가 바뀌어도 동기화 없이 쓸 수 있다.
+ */
+
+#define WORKPOOL_MAX_THREADS 256
+#define WORKPOOL_CACHE_LINE 64
+
+// 작업 한 번 실행, 다시 실행할 작업이면 true (false면 그 작업은 끝)
+typedef bool (*workpool_fn)(void *task, void *arg);
+
+// 워커별 통계
+struct workpool_worker_stats {
+    uint64_t runs;          // 실행한 작업 수
+    uint64_t steals;        // 다른 워커에게서 훔친 작업 수
+    uint64_t failed_steals; // 빈 덱이었거나 다른 도둑과 경쟁해서 실패한 시도
+    uint64_t idle_yields;   // 훔칠 작업이 없어서 양보한 횟수
+};
+
+// tasks를 threads개 워커(호출한 스레드 포함)에 나눠 넣고 모든 작업이 끝날 때까지 실행
+// stats는 NULL이거나 threads개 배열
+errcode_t workpool_run(void **tasks, size_t count, unsigned threads, workpool_fn fn, void *arg,
+                       struct workpool_worker_stats *stats);
+
+#endif // WORKPOOL_H
@@ -0,0 +1,56 @@
+# chip8-farm이 기록을 재생한 결과가 c_chip_8 --headless --replay와 같은 상태인지 확인
+# cmake -DEMULATOR=... -DFARM=... -DROM=... -DREPLAY=... -DWORK_DIR=... -P farm_replay.cmake
+# 기록의 end를 프레임 중간으로 두어 끊긴 마지막 프레임(프레임 수, 타이머)까지 같은지 본다.
+# 인스턴스마다 chip8_ctx로 실행한 것과 배치 엔진(--batch)으로 실행한 것 모두 비교한다.
+
+foreach (var EMULATOR FARM ROM REPLAY WORK_DIR)
+    if (NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif ()
+endforeach ()
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+# c_chip_8: 종료 상태를 세이브 스테이트로 남기고, 결과 JSON의 state_hash는 그 머신 상태의 해시
+execute_process(
+        COMMAND ${EMULATOR} --headless --replay=${REPLAY} --save-state=${WORK_DIR}/end.state ${ROM}
+        OUTPUT_VARIABLE output
+        RESULT_VARIABLE result
+        ERROR_QUIET)
+if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${EMULATOR} failed: ${result}")
+endif ()
+if (NOT output MATCHES "\"frames\": ([0-9]+).*\"state_hash\": \"(0x[0-9A-F]+)\"")
+    message(FATAL_ERROR "unexpected emulator output: ${output}")
+endif ()
+set(expected_frames ${CMAKE_MATCH_1})
+set(expected_hash ${CMAKE_MATCH_2})
+
+function(check_farm name)
+    execute_process(
+            COMMAND ${FARM} --replay=${REPLAY} --threads=1 ${ARGN} ${ROM}
+            OUTPUT_VARIABLE output
+            RESULT_VARIABLE result
+            ERROR_QUIET)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${FARM} ${ARGN} failed: ${result}")
+    endif ()
+    string(REGEX MATCHALL "\"frames\": [0-9]+, \"error\": [0-9-]+, \"state_hash\": \"0x[0-9A-F]+\"" instances "${output}")
+    if (NOT instances)
+        message(FATAL_ERROR "unexpected farm output: ${output}")
+    endif ()
+    foreach (instance IN LISTS instances)
+        string(REGEX MATCH "\"frames\": ([0-9]+), \"error\": ([0-9-]+), \"state_hash\": \"(0x[0-9A-F]+)\"" _ "${instance}")
+        if (NOT CMAKE_MATCH_2 EQUAL 0)
+            message(FATAL_ERROR "${name}: instance stopped with error ${CMAKE_MATCH_2}")
+        endif ()
+        if (NOT CMAKE_MATCH_1 EQUAL expected_frames OR NOT CMAKE_MATCH_3 STREQUAL expected_hash)
+            message(FATAL_ERROR "${name}: frames ${CMAKE_MATCH_1} state_hash ${CMAKE_MATCH_3}, "
+                    "expected frames ${expected_frames} state_hash ${expected_hash} (c_chip_8)")
+        endif ()
+    endforeach ()
+    message(STATUS "${name}: frames ${expected_frames} state_hash ${expected_hash} match")
+endfunction()
+
+check_farm(instance --instances=2)
+check_farm(batch --instances=2 --batch=2)
@@ -0,0 +1,63 @@
+# 세이브 스테이트로 나눠 실행한 트레이스가 한 번에 실행한 트레이스와 같은지 확인
+# cmake -DEMULATOR=... -DTRACEDUMP=... -DROM=... -DREPLAY=... -DSPLIT=N -DWORK_DIR=... -P savestate_split.cmake
+# SPLIT은 프레임 경계가 아닌 위치 (500 IPS면 프레임당 8~9개)로 정해서 끊긴 프레임 저장/복원까지 확인한다.
+
+foreach (var EMULATOR TRACEDUMP ROM REPLAY SPLIT WORK_DIR)
+    if (NOT DEFINED ${var})
+        message(FATAL_ERROR "${var} is not set")
+    endif ()
+endforeach ()
+
+file(MAKE_DIRECTORY ${WORK_DIR})
+set(state ${WORK_DIR}/split.state)
+
+function(run_emulator trace)
+    execute_process(
+            COMMAND ${EMULATOR} --headless --replay=${REPLAY} --trace=${trace} --trace-records=65536 ${ARGN} ${ROM}
+            RESULT_VARIABLE result
+            OUTPUT_QUIET ERROR_QUIET)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${EMULATOR} ${ARGN} failed: ${result}")
+    endif ()
+endfunction()
+
+# 레코드 줄만 남기고, 실행 순번(첫 열)은 실행마다 0부터라 뺀다
+function(read_trace trace out)
+    execute_process(COMMAND ${TRACEDUMP} ${trace} OUTPUT_FILE ${trace}.txt RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "${TRACEDUMP} ${trace} failed: ${result}")
+    endif ()
+    file(STRINGS ${trace}.txt lines REGEX "^ *[0-9]+  [0-9A-F][0-9A-F][0-9A-F]  ")
+    list(TRANSFORM lines REPLACE "^ *[0-9]+" "")
+    set(${out} "${lines}" PARENT_SCOPE)
+endfunction()
+
+run_emulator(${WORK_DIR}/full.trace)
+run_emulator(${WORK_DIR}/first.trace --max-instructions=${SPLIT} --save-state=${state})
+run_emulator(${WORK_DIR}/second.trace --load-state=${state})
+
+read_trace(${WORK_DIR}/full.trace full)
+read_trace(${WORK_DIR}/first.trace first)
+read_trace(${WORK_DIR}/second.trace second)
+list(APPEND first ${second})
+
+list(LENGTH full full_count)
+list(LENGTH first split_count)
+if (full_count EQUAL 0)
+    message(FATAL_ERROR "empty trace")
+endif ()
+if (NOT full_count EQUAL split_count)
+    message(FATAL_ERROR "split at ${SPLIT}: ${split_count} records, expected ${full_count}")
+endif ()
+if (full STREQUAL first)
+    message(STATUS "split at ${SPLIT}: ${full_count} records match")
+    return()
+endif ()
+math(EXPR last "${full_count} - 1")
+foreach (n RANGE ${last})
+    list(GET full ${n} expected)
+    list(GET first ${n} actual)
+    if (NOT expected STREQUAL actual)
+        message(FATAL_ERROR "split at ${SPLIT}: record ${n} differs\n  expected:${expected}\n  actual:  ${actual}")
+    endif ()
+endforeach ()